@@ -0,0 +1,144 @@
+/* amcfill.c: AMC ADAPTIVE FILL SIZE TEST
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * Allocates small objects from an AMC pool as fast as possible, so
+ * that the allocation point's fill size grows (see
+ * <design/poolamc/#fill.adapt>), and checks that no segment made by
+ * a small fill is as big as the pool's large segment size, which
+ * would make AMC treat it as large (see
+ * <design/poolamc/#fill.adapt.limit>).
+ *
+ * Whether the fill size grows depends on how fast the fills come, so
+ * the test reports the biggest segment it saw, but only the limit is
+ * checked.
+ */
+
+#include "fmtdy.h"
+#include "fmtdytst.h"
+#include "testlib.h"
+#include "mpm.h"
+#include "mpscamc.h"
+#include "mpsavm.h"
+#include "mps.h"
+
+#include <stdio.h> /* printf */
+
+
+#define testArenaSIZE   ((size_t)64 << 20)
+#define allocSIZE       ((size_t)16 << 20)
+#define objectSLOTS     4
+
+
+static void test(mps_arena_t arena, Size extendBy, Size largeSize)
+{
+  mps_fmt_t format;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  Seg seg = NULL;
+  Size size = 0, biggest = 0;
+  Count segs = 0, grown = 0;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_EXTEND_BY, extendBy);
+    MPS_ARGS_ADD(args, MPS_KEY_LARGE_SIZE, largeSize);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create");
+
+  while (size < allocSIZE) {
+    mps_word_t v;
+    die(make_dylan_vector(&v, ap, objectSLOTS), "make_dylan_vector");
+    size += (objectSLOTS + 2) * sizeof(mps_word_t);
+    if (seg == NULL || (Addr)v >= SegLimit(seg)) {
+      Insist(SegOfAddr(&seg, (Arena)arena, (Addr)v));
+      Insist(SegSize(seg) < largeSize);
+      ++segs;
+      if (SegSize(seg) > extendBy)
+        ++grown;
+      if (SegSize(seg) > biggest)
+        biggest = SegSize(seg);
+    }
+  }
+  printf("extendBy %lu, largeSize %lu: %lu segments, %lu grown, "
+         "biggest %lu bytes\n",
+         (unsigned long)extendBy, (unsigned long)largeSize,
+         (unsigned long)segs, (unsigned long)grown,
+         (unsigned long)biggest);
+
+  mps_ap_destroy(ap);
+  mps_pool_destroy(pool);
+  mps_fmt_destroy(format);
+}
+
+
+int main(int argc, char *argv[])
+{
+  mps_arena_t arena;
+
+  testlib_init(argc, argv);
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+
+  /* Parked, so that the objects are never moved or collected. */
+  mps_arena_park(arena);
+
+  test(arena, AMC_EXTEND_BY_DEFAULT, AMC_LARGE_SIZE_DEFAULT);
+  test(arena, AMC_EXTEND_BY_DEFAULT, AMC_LARGE_SIZE_DEFAULT + 1);
+  test(arena, AMC_EXTEND_BY_DEFAULT, AMC_EXTEND_BY_DEFAULT * 3);
+
+  mps_arena_destroy(arena);
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
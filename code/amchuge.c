@@ -0,0 +1,265 @@
+/* amchuge.c: TEST FOR INCREMENTAL SCANNING OF HUGE OBJECTS IN AMC
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * Keeps some huge arrays of references in an AMC pool that is never
+ * collected, while allocating small objects in another AMC pool that
+ * is collected incrementally. Between collections, the test stores
+ * references to new small objects in the arrays, so that the arrays
+ * must be scanned in every collection. It runs first with an object
+ * format that can only scan whole objects, and then with a format
+ * that can scan part of an object (see <design/poolamc/#suspend.part>),
+ * and checks that in the second run the arrays were scanned in parts
+ * no bigger than the scan budget, and that their references were
+ * fixed correctly in both.
+ *
+ * The test also reports the longest time taken by an allocation
+ * (which includes the collector's work) in each run, but doesn't
+ * check it, because it depends on the load on the machine.
+ */
+
+#include "fmtvec.h"
+#include "mps.h"
+#include "mpsavm.h"
+#include "mpscamc.h"
+#include "testlib.h"
+
+#include <stdio.h> /* printf */
+#include <time.h> /* clock, clock_t, CLOCKS_PER_SEC */
+
+#define arrayCOUNT      2
+#define arraySIZE       ((size_t)8 << 20)
+#define collectionCOUNT 4
+#define storeCOUNT      1000
+#define smallWORDS      4
+#define pauseTIME       0.001   /* seconds */
+
+static mps_gen_param_s smallChain[] = {
+  { 1024, 0.9 }
+};
+
+static mps_gen_param_s arrayChain[] = {
+  { 1024 * 1024, 0.5 }
+};
+
+
+/* scan_part -- count the parts scanned, and scan them
+ *
+ * A part that doesn't start at the beginning of its object must follow
+ * a part that ran out of budget.
+ */
+
+static size_t partCount;        /* calls to scan_part */
+static size_t partContinued;    /* parts not at the start of an object */
+static size_t partLargest;      /* largest part scanned, in bytes */
+
+static mps_res_t scan_part(mps_ss_t ss, mps_addr_t obj,
+                           mps_addr_t base, mps_addr_t limit)
+{
+  size_t size = (size_t)((char *)limit - (char *)base);
+  ++partCount;
+  if (base != obj)
+    ++partContinued;
+  if (size > partLargest)
+    partLargest = size;
+  return vec_scan_part(ss, obj, base, limit);
+}
+
+
+static mps_addr_t arrays[arrayCOUNT];
+
+
+static mps_word_t *alloc(mps_ap_t ap, size_t words)
+{
+  mps_word_t *p;
+  die(make_vec(&p, ap, words, VEC_REFS), "make_vec");
+  return p;
+}
+
+
+/* test -- run one test, with or without scan_part */
+
+static void test(mps_bool_t scanPart)
+{
+  mps_arena_t arena;
+  mps_thr_t thread;
+  mps_root_t stackRoot, arrayRoot;
+  mps_fmt_t format;
+  mps_chain_t chain[2];
+  mps_pool_t smallPool, arrayPool;
+  mps_ap_t smallAp, arrayAp;
+  mps_message_t message;
+  size_t i, collections = 0;
+  unsigned long allocs = 0;
+  clock_t longest = 0;
+  void *marker = &marker;
+
+  partCount = partContinued = partLargest = 0;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, 4 * arrayCOUNT * arraySIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_PAUSE_TIME, pauseTIME);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+  mps_message_type_enable(arena, mps_message_type_gc());
+  die(mps_thread_reg(&thread, arena), "thread_reg");
+  die(mps_root_create_thread(&stackRoot, arena, thread, marker),
+      "root_create_thread");
+  die(mps_root_create_table(&arrayRoot, arena, mps_rank_exact(), 0,
+                            arrays, arrayCOUNT),
+      "root_create_table");
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_ALIGN, VEC_ALIGN);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_SCAN, vec_scan);
+    if (scanPart)
+      MPS_ARGS_ADD(args, MPS_KEY_FMT_SCAN_PART, scan_part);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_SKIP, vec_skip);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_FWD, vec_fwd);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_ISFWD, vec_isfwd);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_PAD, vec_pad);
+    die(mps_fmt_create_k(&format, arena, args), "fmt_create");
+  } MPS_ARGS_END(args);
+  die(mps_chain_create(&chain[0], arena, NELEMS(smallChain), smallChain),
+      "chain_create");
+  die(mps_chain_create(&chain[1], arena, NELEMS(arrayChain), arrayChain),
+      "chain_create");
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain[0]);
+    die(mps_pool_create_k(&smallPool, arena, mps_class_amc(), args),
+        "pool_create small");
+  } MPS_ARGS_END(args);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain[1]);
+    die(mps_pool_create_k(&arrayPool, arena, mps_class_amc(), args),
+        "pool_create array");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create_k(&smallAp, smallPool, mps_args_none), "ap_create");
+  die(mps_ap_create_k(&arrayAp, arrayPool, mps_args_none), "ap_create");
+
+  for (i = 0; i < arrayCOUNT; ++i)
+    arrays[i] = alloc(arrayAp, arraySIZE / sizeof(mps_word_t));
+
+  while (collections < collectionCOUNT) {
+    /* Store new objects in the arrays while no collection is running,
+       so that the stores don't hit the read barrier, and the arrays
+       refer to the next collection's condemned set. */
+    mps_arena_park(arena);
+    for (i = 0; i < storeCOUNT; ++i) {
+      mps_word_t *array = arrays[rnd() % arrayCOUNT];
+      size_t j = 1 + rnd() % (arraySIZE / sizeof(mps_word_t) - 1);
+      array[j] = (mps_word_t)alloc(smallAp, smallWORDS);
+    }
+    mps_arena_release(arena);
+
+    /* Allocate garbage until a collection finishes. */
+    while (!mps_message_get(&message, arena, mps_message_type_gc())) {
+      clock_t start = clock(), time;
+      (void)alloc(smallAp, smallWORDS);
+      time = clock() - start;
+      if (time > longest)
+        longest = time;
+      ++allocs;
+    }
+    mps_message_discard(arena, message);
+    ++collections;
+  }
+
+  /* Check that the references in the arrays were fixed correctly. */
+  mps_arena_park(arena);
+  for (i = 0; i < arrayCOUNT; ++i) {
+    mps_word_t *array = arrays[i];
+    size_t j;
+    for (j = 1; j < arraySIZE / sizeof(mps_word_t); ++j)
+      if (array[j] != 0) {
+        mps_word_t *p = (mps_word_t *)array[j];
+        Insist(p[0] == VEC_HEADER(smallWORDS, VEC_REFS));
+      }
+  }
+
+  printf("%s: %lu allocations, longest pause %.3fs, "
+         "%lu parts (%lu continued), largest part %lu bytes\n",
+         scanPart ? "parts" : "whole", allocs,
+         (double)longest / CLOCKS_PER_SEC,
+         (unsigned long)partCount, (unsigned long)partContinued,
+         (unsigned long)partLargest);
+  if (scanPart) {
+    Insist(partContinued > 0);
+    Insist(partLargest < arraySIZE);
+  } else {
+    Insist(partCount == 0);
+  }
+
+  for (i = 0; i < arrayCOUNT; ++i)
+    arrays[i] = NULL;
+  mps_ap_destroy(arrayAp);
+  mps_ap_destroy(smallAp);
+  mps_pool_destroy(arrayPool);
+  mps_pool_destroy(smallPool);
+  mps_chain_destroy(chain[1]);
+  mps_chain_destroy(chain[0]);
+  mps_fmt_destroy(format);
+  mps_root_destroy(arrayRoot);
+  mps_root_destroy(stackRoot);
+  mps_thread_dereg(thread);
+  mps_arena_destroy(arena);
+}
+
+
+int main(int argc, char *argv[])
+{
+  testlib_init(argc, argv);
+
+  test(FALSE);
+  test(TRUE);
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs, such as windowing system software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -68,17 +68,22 @@ static void report(void)
       printf("    clock: %"PRIuLONGEST"\n", (ulongest_t)mps_message_clock(arena, message));
 
     } else if (type == mps_message_type_gc()) {
-      size_t live, condemned, not_condemned;
+      size_t live, condemned, not_condemned, copied, marked;
       
       nCollsDone += 1;
       live = mps_message_gc_live_size(arena, message);
       condemned = mps_message_gc_condemned_size(arena, message);
       not_condemned = mps_message_gc_not_condemned_size(arena, message);
+      copied = mps_message_gc_copied_size(arena, message);
+      marked = mps_message_gc_marked_size(arena, message);
+      cdie(copied + marked == live, "copied + marked == live");
 
       printf("\n  Collection %lu finished:\n", nCollsDone);
       printf("    live %"PRIuLONGEST"\n", (ulongest_t)live);
       printf("    condemned %"PRIuLONGEST"\n", (ulongest_t)condemned);
       printf("    not_condemned %"PRIuLONGEST"\n", (ulongest_t)not_condemned);
+      printf("    copied %"PRIuLONGEST"\n", (ulongest_t)copied);
+      printf("    marked %"PRIuLONGEST"\n", (ulongest_t)marked);
       printf("    clock: %"PRIuLONGEST"\n", (ulongest_t)mps_message_clock(arena, message));
       printf("}\n");
     } else {
@@ -130,7 +135,8 @@ static void test_stepper(mps_addr_t object, mps_fmt_t fmt, mps_pool_t pool,
 
 /* test -- the body of the test */
 
-static void test(mps_pool_class_t pool_class, size_t roots_count)
+static void test(mps_pool_class_t pool_class, size_t roots_count,
+                 double mark_threshold)
 {
   mps_fmt_t format;
   mps_chain_t chain;
@@ -147,8 +153,13 @@ static void test(mps_pool_class_t pool_class, size_t roots_count)
   die(dylan_fmt(&format, arena), "fmt_create");
   die(mps_chain_create(&chain, arena, genCOUNT, testChain), "chain_create");
 
-  die(mps_pool_create(&pool, arena, pool_class, format, chain),
-      "pool_create(amc)");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    MPS_ARGS_ADD(args, MPS_KEY_AMC_MARK_THRESHOLD, mark_threshold);
+    die(mps_pool_create_k(&pool, arena, pool_class, args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
 
   die(mps_ap_create(&ap, pool, mps_rank_exact()), "BufferCreate");
   die(mps_ap_create(&busy_ap, pool, mps_rank_exact()), "BufferCreate 2");
@@ -318,8 +329,9 @@ int main(int argc, char *argv[])
   mps_message_type_enable(arena, mps_message_type_gc());
   mps_message_type_enable(arena, mps_message_type_gc_start());
   die(mps_thread_reg(&thread, arena), "thread_reg");
-  test(mps_class_amc(), exactRootsCOUNT);
-  test(mps_class_amcz(), 0);
+  test(mps_class_amc(), exactRootsCOUNT, 1.0);
+  test(mps_class_amc(), exactRootsCOUNT, 0.0);
+  test(mps_class_amcz(), 0, 0.5);
   mps_thread_dereg(thread);
   report();
   mps_arena_destroy(arena);
@@ -8,6 +8,10 @@
  * runs mps_arena_formatted_objects_walk(). This checks that walking
  * works while the other threads continue to allocate in the
  * background.
+ *
+ * The test is run twice: the second time with a background collector
+ * thread, so that collection work happens concurrently with all of
+ * the mutator threads.
  */
 
 #include "fmtdy.h"
@@ -268,7 +272,7 @@ static void test_pool(const char *name, mps_pool_t pool, size_t roots_count)
     testthr_join(&kids[i], NULL);
 }
 
-static void test_arena(void)
+static void test_arena(mps_bool_t background)
 {
   size_t i;
   mps_fmt_t format;
@@ -281,6 +285,7 @@ static void test_arena(void)
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, rnd_grain(testArenaSIZE));
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_BACKGROUND_COLLECTOR, background);
     die(mps_arena_create_k(&arena, mps_arena_class_vm(), args), "arena_create");
   } MPS_ARGS_END(args);
   mps_message_type_enable(arena, mps_message_type_gc());
@@ -330,7 +335,8 @@ static void test_arena(void)
 int main(int argc, char *argv[])
 {
   testlib_init(argc, argv);
-  test_arena();
+  test_arena(FALSE);
+  test_arena(TRUE);
 
   printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
   return 0;
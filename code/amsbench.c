@@ -0,0 +1,322 @@
+/* amsbench.c -- AMS sweep and scan benchmark
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * This benchmark builds a random graph of objects in an AMS pool,
+ * drops most of them, and times full collections. It's intended for
+ * measuring the parts of AMS that work on the colour tables: finding
+ * grey objects when scanning (<design/poolams/#blacken.find>) and
+ * counting free grains when reclaiming (<design/bt/#if.count-res-range>).
+ * The survival probability controls how sparse the grey and white bits
+ * are, and so how much of each table the collector has to search.
+ */
+
+#include "mps.c"
+#include "testlib.h"
+#include "fmtdy.h"
+#include "fmtdytst.h"
+#include "mpm.h"
+
+#ifdef MPS_OS_W3
+#include "getopt.h"
+#else
+#include <getopt.h>
+#endif
+
+#include <stdio.h> /* fprintf, printf, putchar, stderr, stdout */
+#include <stdlib.h> /* calloc, exit, free, EXIT_FAILURE, EXIT_SUCCESS, strtoul */
+#include <time.h> /* clock, CLOCKS_PER_SEC */
+
+#define RESMUST(expr) \
+  do { \
+    mps_res_t res = (expr); \
+    if (res != MPS_RES_OK) { \
+      fprintf(stderr, #expr " returned %d\n", res); \
+      exit(EXIT_FAILURE); \
+    } \
+  } while(0)
+
+static mps_arena_t arena;
+static mps_pool_t pool;
+static mps_fmt_t format;
+static mps_ap_t ap;
+
+static rnd_state_t seed = 0;      /* random number seed */
+static unsigned niter = 5;        /* iterations */
+static size_t nobj = 100000;      /* objects allocated per iteration */
+static size_t width = 4;          /* maximum slots in each object */
+static double psurvive = 0.1;     /* probability that an object is a root */
+static double plink = 0.5;        /* probability that a slot is a reference */
+static size_t arena_size = 256ul * 1024 * 1024; /* arena size */
+static mps_bool_t ambig = FALSE;  /* roots are ambiguous */
+
+typedef mps_word_t obj_t;
+
+static obj_t *roots;              /* objects kept alive */
+
+
+/* mkgraph -- allocate objects, each referring to some earlier ones
+ *
+ * Every object is entered into the root table as soon as it's
+ * allocated, so the only references from the stack are to objects
+ * that are also reachable from the table.
+ */
+
+static void mkgraph(void)
+{
+  size_t i, j, slots;
+  for (i = 0; i < nobj; ++i) {
+    slots = 1 + rnd() % width;
+    RESMUST(make_dylan_vector(&roots[i], ap, slots));
+    if (i == 0)
+      continue;
+    for (j = 0; j < slots; ++j)
+      if (rnd_double() < plink)
+        DYLAN_VECTOR_SLOT(roots[i], j) = roots[rnd() % i];
+  }
+}
+
+
+/* prune -- drop all but the surviving roots */
+
+static void prune(void)
+{
+  size_t i;
+  for (i = 0; i < nobj; ++i)
+    if (rnd_double() >= psurvive)
+      roots[i] = 0;
+}
+
+
+static double elapsed(clock_t begin, clock_t end)
+{
+  return (double)(end - begin) / CLOCKS_PER_SEC;
+}
+
+
+/* bench -- time allocation and full collections */
+
+static void bench(void)
+{
+  clock_t begin, end;
+  double talloc = 0.0, tcollect = 0.0, t1, t2;
+  unsigned i;
+
+  for (i = 0; i < niter; ++i) {
+    begin = clock();
+    mkgraph();
+    end = clock();
+    t1 = elapsed(begin, end);
+
+    prune();
+
+    begin = clock();
+    mps_arena_collect(arena);
+    end = clock();
+    t2 = elapsed(begin, end);
+
+    printf("iteration %u: alloc %g collect %g committed %lu\n",
+           i, t1, t2, (unsigned long)mps_arena_committed(arena));
+    talloc += t1;
+    tcollect += t2;
+    mps_arena_release(arena);
+  }
+
+  printf("alloc: %g\n", talloc);
+  printf("collect: %g\n", tcollect);
+  printf("traced: %.0f bytes in %g seconds\n",
+         arena->tracedWork, arena->tracedTime);
+}
+
+
+/* Command-line options definitions.  See getopt_long(3). */
+
+static struct option longopts[] = {
+  {"help",             no_argument,       NULL, 'h'},
+  {"niter",            required_argument, NULL, 'i'},
+  {"nobj",             required_argument, NULL, 'n'},
+  {"width",            required_argument, NULL, 'w'},
+  {"psurvive",         required_argument, NULL, 's'},
+  {"plink",            required_argument, NULL, 'l'},
+  {"arena-size",       required_argument, NULL, 'm'},
+  {"ambiguous",        no_argument,       NULL, 'A'},
+  {"seed",             required_argument, NULL, 'x'},
+  {NULL,               0,                 NULL, 0  }
+};
+
+
+int main(int argc, char *argv[])
+{
+  int ch;
+  mps_bool_t seed_specified = FALSE;
+  mps_thr_t thread;
+  mps_root_t root, stack_root;
+  void *marker;
+
+  seed = rnd_seed();
+
+  while ((ch = getopt_long(argc, argv, "hi:n:w:s:l:m:Ax:",
+                           longopts, NULL)) != -1)
+    switch (ch) {
+    case 'i':
+      niter = (unsigned)strtoul(optarg, NULL, 10);
+      break;
+    case 'n':
+      nobj = (size_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'w':
+      width = (size_t)strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      psurvive = strtod(optarg, NULL);
+      break;
+    case 'l':
+      plink = strtod(optarg, NULL);
+      break;
+    case 'm': {
+        char *p;
+        arena_size = (unsigned)strtoul(optarg, &p, 10);
+        switch(toupper(*p)) {
+        case 'G': arena_size <<= 30; break;
+        case 'M': arena_size <<= 20; break;
+        case 'K': arena_size <<= 10; break;
+        case '\0': break;
+        default:
+          fprintf(stderr, "Bad arena size %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+      }
+      break;
+    case 'A':
+      ambig = TRUE;
+      break;
+    case 'x':
+      seed = strtoul(optarg, NULL, 10);
+      seed_specified = TRUE;
+      break;
+    default:
+      fprintf(stderr,
+              "Usage: %s [option...]\n"
+              "Options:\n"
+              "  -m n, --arena-size=n[KMG]?\n"
+              "    Initial size of arena (default %lu).\n"
+              "  -i n, --niter=n\n"
+              "    Allocate and collect n times (default %u).\n"
+              "  -n n, --nobj=n\n"
+              "    Allocate n objects each time (default %lu).\n"
+              "  -w n, --width=n\n"
+              "    Maximum number of slots in an object (default %lu).\n",
+              argv[0],
+              (unsigned long)arena_size,
+              niter,
+              (unsigned long)nobj,
+              (unsigned long)width);
+      fprintf(stderr,
+              "  -s p, --psurvive=p\n"
+              "    Probability that an object is a root (default %g).\n"
+              "  -l p, --plink=p\n"
+              "    Probability that a slot is a reference (default %g).\n"
+              "  -A, --ambiguous\n"
+              "    Make the roots ambiguous.\n"
+              "  -x n, --seed=n\n"
+              "    Random number seed (default from entropy).\n",
+              psurvive,
+              plink);
+      return EXIT_FAILURE;
+    }
+  argc -= optind;
+  argv += optind;
+
+  if (argc > 0 || width == 0) {
+    fprintf(stderr, "Bad arguments; try --help\n");
+    return EXIT_FAILURE;
+  }
+
+  if (!seed_specified) {
+    printf("seed: %lu\n", seed);
+    (void)fflush(stdout);
+  }
+  (void)mps_lib_assert_fail_install(assert_die);
+  rnd_state_set(seed);
+
+  roots = calloc(nobj, sizeof roots[0]);
+  if (roots == NULL) {
+    fprintf(stderr, "Couldn't allocate root table\n");
+    return EXIT_FAILURE;
+  }
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, arena_size);
+    RESMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
+  } MPS_ARGS_END(args);
+  RESMUST(dylan_fmt(&format, arena));
+  RESMUST(dylan_make_wrappers());
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_AMS_SUPPORT_AMBIGUOUS, ambig);
+    RESMUST(mps_pool_create_k(&pool, arena, mps_class_ams(), args));
+  } MPS_ARGS_END(args);
+  RESMUST(mps_root_create_table(&root, arena,
+                                ambig ? mps_rank_ambig() : mps_rank_exact(),
+                                0, (mps_addr_t *)roots, nobj));
+  RESMUST(mps_thread_reg(&thread, arena));
+  RESMUST(mps_root_create_thread(&stack_root, arena, thread, &marker));
+  RESMUST(mps_ap_create_k(&ap, pool, mps_args_none));
+
+  bench();
+
+  mps_arena_park(arena);
+  mps_ap_destroy(ap);
+  mps_root_destroy(stack_root);
+  mps_thread_dereg(thread);
+  mps_root_destroy(root);
+  mps_pool_destroy(pool);
+  mps_fmt_destroy(format);
+  mps_arena_destroy(arena);
+  free(roots);
+
+  return EXIT_SUCCESS;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
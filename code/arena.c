@@ -202,6 +202,7 @@ Bool ArenaCheck(Arena arena)
   /* Can't use CHECKD_NOSIG because TreeEMPTY is NULL. */
   CHECKL(TreeCheck(ArenaChunkTree(arena)));
   /* TODO: check that the chunkRing and chunkTree have identical members */
+  /* Can't check chunkCache cheaply: see ArenaChunkRemoved. */
   /* nothing to check for chunkSerial */
   
   CHECKL(LocusCheck(arena));
@@ -211,6 +212,12 @@ Bool ArenaCheck(Arena arena)
     CHECKD(Land, ArenaFreeLand(arena));
 
   CHECKL(BoolCheck(arena->zoned));
+  CHECKL(BoolCheck(arena->softBarrier));
+  CHECKL(arena->wbCount <= WB_SOFT_BUFFER_LENGTH);
+  CHECKL(arena->softBarrier || arena->wbCount == 0);
+  CHECKL(BoolCheck(arena->backgroundCollector));
+  if (arena->collector != NULL)
+    CHECKD_NOSIG(Collector, arena->collector);
 
   return TRUE;
 }
@@ -222,16 +229,23 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
 {
   Res res;
   Bool zoned = ARENA_DEFAULT_ZONED;
+  Bool softBarrier = ARENA_DEFAULT_SOFT_BARRIER;
+  Bool backgroundCollector = ARENA_DEFAULT_BACKGROUND_COLLECTOR;
   Size commitLimit = ARENA_DEFAULT_COMMIT_LIMIT;
   Size spareCommitLimit = ARENA_DEFAULT_SPARE_COMMIT_LIMIT;
   double pauseTime = ARENA_DEFAULT_PAUSE_TIME;
   mps_arg_s arg;
+  Index i;
 
   AVER(arena != NULL);
   AVERT(ArenaGrainSize, grainSize);
   
   if (ArgPick(&arg, args, MPS_KEY_ARENA_ZONED))
     zoned = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_SOFT_BARRIER))
+    softBarrier = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_ARENA_BACKGROUND_COLLECTOR))
+    backgroundCollector = arg.val.b;
   if (ArgPick(&arg, args, MPS_KEY_COMMIT_LIMIT))
     commitLimit = arg.val.size;
   if (ArgPick(&arg, args, MPS_KEY_SPARE_COMMIT_LIMIT))
@@ -239,6 +253,11 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   if (ArgPick(&arg, args, MPS_KEY_PAUSE_TIME))
     pauseTime = arg.val.d;
 
+  /* The background collector could collect between a store and the
+     call to mps_write_barrier: <design/write-barrier/#soft.threads>. */
+  if (softBarrier && backgroundCollector)
+    return ResPARAM;
+
   /* Superclass init */
   InstInit(CouldBeA(Inst, arena));
 
@@ -257,10 +276,16 @@ static Res ArenaAbsInit(Arena arena, Size grainSize, ArgList args)
   arena->hasFreeLand = FALSE;
   arena->freeZones = ZoneSetUNIV;
   arena->zoned = zoned;
+  arena->softBarrier = softBarrier;
+  arena->wbCount = 0;
+  arena->backgroundCollector = backgroundCollector;
+  arena->collector = NULL;
 
   arena->primary = NULL;
   RingInit(ArenaChunkRing(arena));
   arena->chunkTree = TreeEMPTY;
+  for (i = 0; i < ChunkCacheLENGTH; ++i)
+    arena->chunkCache[i] = NULL;
   arena->chunkSerial = (Serial)0;
   
   LocusInit(arena);
@@ -315,6 +340,8 @@ ARG_DEFINE_KEY(VMW3_TOP_DOWN, Bool);
 ARG_DEFINE_KEY(ARENA_GRAIN_SIZE, Size);
 ARG_DEFINE_KEY(ARENA_SIZE, Size);
 ARG_DEFINE_KEY(ARENA_ZONED, Bool);
+ARG_DEFINE_KEY(ARENA_SOFT_BARRIER, Bool);
+ARG_DEFINE_KEY(ARENA_BACKGROUND_COLLECTOR, Bool);
 ARG_DEFINE_KEY(COMMIT_LIMIT, Size);
 ARG_DEFINE_KEY(SPARE_COMMIT_LIMIT, Size);
 ARG_DEFINE_KEY(PAUSE_TIME, double);
@@ -550,6 +577,10 @@ static Res ArenaAbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
                "hasFreeLand      $S\n", WriteFYesNo(arena->hasFreeLand),
                "freeZones        $B\n", (WriteFB)arena->freeZones,
                "zoned            $S\n", WriteFYesNo(arena->zoned),
+               "softBarrier      $S\n", WriteFYesNo(arena->softBarrier),
+               "backgroundCollector $S\n",
+               WriteFYesNo(arena->backgroundCollector),
+               "collector        $P\n", (WriteFP)arena->collector,
                NULL);
   if (res != ResOK)
     return res;
@@ -738,17 +769,27 @@ void ArenaChunkInsert(Arena arena, Chunk chunk) {
 
 
 /* ArenaChunkRemoved -- chunk was removed from the arena and is being
- * finished, so update the total reserved address space, and unset the
- * primary chunk if necessary.
+ * finished, so update the total reserved address space, remove the
+ * chunk from the chunk cache, and unset the primary chunk if
+ * necessary.
+ *
+ * The chunk cache need not be updated by ArenaChunkInsert, because
+ * entries are only trusted if they contain the address being looked
+ * up: see ChunkOfAddr.
  */
 
 void ArenaChunkRemoved(Arena arena, Chunk chunk)
 {
   Size size;
+  Index i;
 
   AVERT(Arena, arena);
   AVERT(Chunk, chunk);
 
+  for (i = 0; i < ChunkCacheLENGTH; ++i)
+    if (arena->chunkCache[i] == chunk)
+      arena->chunkCache[i] = NULL;
+
   size = ChunkReserved(chunk);
   AVER(arena->reserved >= size);
   arena->reserved -= size;
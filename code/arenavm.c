@@ -45,6 +45,9 @@ typedef struct VMChunkStruct {
   VMStruct vmStruct;            /* virtual memory descriptor */
   Addr overheadMappedLimit;     /* limit of pages mapped for overhead */
   SparseArrayStruct pages;      /* to manage backing store of page table */
+#if defined(PROT_UFFD)
+  ProtUffdRangeStruct uffdRange; /* <code/protuffd.c#register> */
+#endif
   Sig sig;                      /* <design/sig/> */
 } VMChunkStruct;
 
@@ -311,6 +314,11 @@ static Res VMChunkCreate(Chunk *chunkReturn, VMArena vmArena, Size size)
 
   BootBlockFinish(boot);
 
+#if defined(PROT_UFFD)
+  /* If this fails, the chunk is protected with mprotect(2) instead. */
+  (void)ProtUffdRegister(&vmChunk->uffdRange, base, limit);
+#endif
+
   vmChunk->sig = VMChunkSig;
   AVERT(VMChunk, vmChunk);
 
@@ -425,6 +433,10 @@ static void VMChunkFinish(Chunk chunk)
   VM vm = &vmStruct;
   VMChunk vmChunk = Chunk2VMChunk(chunk);
 
+#if defined(PROT_UFFD)
+  ProtUffdDeregister(&vmChunk->uffdRange);
+#endif
+
   /* Copy VM descriptor to stack-local storage so that we can continue
    * using the descriptor after the VM has been unmapped. */
   VMCopy(vm, VMChunkVM(vmChunk));
@@ -856,6 +856,25 @@ Bool BTFindShortResRange(Index *baseReturn, Index *limitReturn,
                         length, length);
 }
 
+/* BTFindFirstRes -- find the lowest reset bit in a range
+ *
+ * See <design/bt/#if.find-first-res>.
+ */
+
+Bool BTFindFirstRes(Index *indexReturn, BT bt,
+                    Index searchBase, Index searchLimit)
+{
+  Bool found;
+
+  AVER(indexReturn != NULL);
+  AVERT(BT, bt);
+  AVER(searchBase < searchLimit);
+
+  BTFindRes(&found, indexReturn, bt, searchBase, searchLimit);
+  return found;
+}
+
+
 /* BTFindShortResRangeHigh -- find short range of reset bits in a bit table
  *
  * Starts looking from the top of the search range.
@@ -1016,19 +1035,50 @@ void BTCopyOffsetRange(BT fromBT, BT toBT,
 }
 
 
-/* BTCountResRange -- count number of reset bits in a range */
+/* btWordCountSet -- count the set bits in a word
+ *
+ * This is the usual "SWAR" population count: it adds adjacent bits,
+ * then adjacent pairs, then adjacent nibbles, and then sums the bytes
+ * by multiplication.  The constants are built from ~(Word)0 so that
+ * the same code works for any multiple of 8 bits up to 256.
+ */
+
+static Count btWordCountSet(Word word)
+{
+  const Word m1 = ~(Word)0 / 3;         /* 0x5555... */
+  const Word m2 = ~(Word)0 / 15 * 3;    /* 0x3333... */
+  const Word m4 = ~(Word)0 / 255 * 15;  /* 0x0f0f... */
+  const Word h01 = ~(Word)0 / 255;      /* 0x0101... */
+
+  word = word - ((word >> 1) & m1);
+  word = (word & m2) + ((word >> 2) & m2);
+  word = (word + (word >> 4)) & m4;
+  return (Count)((word * h01) >> (MPS_WORD_WIDTH - 8));
+}
+
+
+/* BTCountResRange -- count number of reset bits in a range
+ *
+ * See <design/bt/#if.count-res-range>.
+ */
 
 Count BTCountResRange(BT bt, Index base, Index limit)
 {
   Count c = 0;
-  Index bit;
 
   AVERT(BT, bt);
   AVER(base < limit);
 
-  for (bit = base; bit < limit; ++bit)
-    if (!BTGet(bt, bit))
-      ++c;
+#define SINGLE_COUNT_RES_RANGE(i) \
+  if (!BTGet(bt, (i))) ++c
+#define BITS_COUNT_RES_RANGE(i,base,limit) \
+  c += btWordCountSet(~bt[(i)] & BTMask((base),(limit)))
+#define WORD_COUNT_RES_RANGE(i) \
+  c += btWordCountSet(~bt[(i)])
+
+  ACT_ON_RANGE(base, limit, SINGLE_COUNT_RES_RANGE,
+               BITS_COUNT_RES_RANGE, WORD_COUNT_RES_RANGE);
+
   return c;
 }
 
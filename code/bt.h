@@ -48,6 +48,8 @@ extern Bool BTIsSetRange(BT bt, Index base, Index limit);
 extern void BTResRange(BT bt, Index base, Index limit);
 extern Bool BTIsResRange(BT bt, Index base, Index limit);
 
+extern Bool BTFindFirstRes(Index *indexReturn, BT bt,
+                           Index searchBase, Index searchLimit);
 extern Bool BTFindShortResRange(Index *baseReturn, Index *limitReturn,
                                 BT bt, Index searchBase, Index searchLimit,
                                 Count length);
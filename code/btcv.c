@@ -506,6 +506,52 @@ static void btCopyTests(BT bt1, BT bt2, Count btSize,
 }
 
 
+/* btCountTests -- Test BTCountResRange & BTFindFirstRes
+ *
+ * Fill the table with random bits and compare the results with a
+ * bit-by-bit count and search of the range.
+ */
+
+static void btCountTests(BT bt, Count btSize, Index base, Index limit)
+{
+  Index i, first;
+  Count count;
+  Bool found;
+
+  for (i = 0; i < btSize; i++) {
+    if (rnd() & 1)
+      BTSet(bt, i);
+    else
+      BTRes(bt, i);
+  }
+  /* Make the range sparse sometimes, so that BTFindFirstRes has to */
+  /* look beyond the first word. */
+  if ((rnd() & 1) && base < (base + limit) / 2)
+    BTSetRange(bt, base, (base + limit) / 2);
+
+  count = 0;
+  found = FALSE;
+  first = 0;
+  for (i = base; i < limit; i++) {
+    if (!BTGet(bt, i)) {
+      if (!found) {
+        found = TRUE;
+        first = i;
+      }
+      ++count;
+    }
+  }
+  cdie(BTCountResRange(bt, base, limit) == count, "BTCountResRange");
+  if (found) {
+    Index index;
+    cdie(BTFindFirstRes(&index, bt, base, limit), "BTFindFirstRes");
+    cdie(index == first, "BTFindFirstRes index");
+  } else {
+    Index index;
+    cdie(!BTFindFirstRes(&index, bt, base, limit), "BTFindFirstRes");
+  }
+}
+
 
 /* btTests --  Do all the tests
  */
@@ -523,6 +569,9 @@ static void btTests(BT btlo, BT bthi, Count btSize)
       /* Perform Copy*Range tests over those subranges */
       btCopyTests(btlo, bthi, btSize, base, limit);
 
+      /* Perform counting tests over those subranges */
+      btCountTests(btlo, btSize, base, limit);
+
       /* Perform FindResRange tests with different lengths */
       btFindRangeTests(btlo, bthi, btSize, base, limit, 1);
       btFindRangeTests(btlo, bthi, btSize, base, limit, 2);
@@ -533,6 +582,14 @@ static void btTests(BT btlo, BT bthi, Count btSize)
       btFindRangeTests(btlo, bthi, btSize, base, limit, limit - base);
     }
   }
+
+  /* Perform counting tests over short subranges, which may lie */
+  /* within a word or straddle a word boundary */
+  for (base = 0; base < 2 * MPS_WORD_WIDTH; base++) {
+    for (limit = base + 1; limit <= base + MPS_WORD_WIDTH + 1; limit++) {
+      btCountTests(btlo, btSize, base, limit);
+    }
+  }
 }
 
 
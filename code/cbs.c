@@ -35,6 +35,11 @@ SRCID(cbs, "$Id$");
 #define cbsZonedBlockOfTree(_tree) \
   PARENT(CBSZonedBlockStruct, cbsFastBlockStruct, cbsFastBlockOfTree(_tree))
 #define cbsBlockPool(cbs) RVALUE((cbs)->blockPool)
+#define cbsSegFitOfCBS(cbs) PARENT(CBSSegFitStruct, cbsStruct, cbs)
+#define cbsSegFitBlockOfBlock(block) \
+  PARENT(CBSSegFitBlockStruct, cbsBlockStruct, block)
+#define cbsSegFitBlockOfRing(ring) \
+  RING_ELT(CBSSegFitBlock, binRing, ring)
 
 /* We pass the block base directly as a TreeKey (void *) assuming that
    Addr can be encoded, and possibly breaking <design/type/#addr.use>.
@@ -64,6 +69,18 @@ Bool CBSCheck(CBS cbs)
   return TRUE;
 }
 
+Bool CBSSegFitCheck(CBSSegFit segFit)
+{
+  CHECKS(CBSSegFit, segFit);
+  CHECKD(CBS, &segFit->cbsStruct);
+  CHECKL(segFit->alignShift
+         == SizeLog2(LandAlignment(CBSLand(&segFit->cbsStruct))));
+  CHECKL(segFit->subBins != NULL);
+  /* See .segfit.map. */
+  CHECKL((segFit->binMap == 0) == (segFit->cbsStruct.size == 0));
+  return TRUE;
+}
+
 
 ATTRIBUTE_UNUSED
 static Bool CBSBlockCheck(CBSBlock block)
@@ -208,6 +225,152 @@ static void cbsUpdateZonedNode(SplayTree splay, Tree tree)
 }
 
 
+/* Segregated fit
+ *
+ * .segfit: CBSSegFit keeps each block on a ring of blocks of similar
+ * size, as in TLSF.  See <design/cbs/#impl.seg-fit>.  Sizes are in
+ * grains of the land alignment.  Bin i > 0 holds blocks whose size
+ * has its highest set bit at cbsSegFitSubBinSHIFT + i - 1, and is
+ * divided into cbsSegFitSubBINS sub-bins by the next
+ * cbsSegFitSubBinSHIFT bits of the size.  Bin 0 holds blocks smaller
+ * than cbsSegFitSubBINS grains, one size per sub-bin.
+ *
+ * .segfit.map: binMap has a bit set for each bin with a non-empty
+ * sub-bin, and subBinMap[i] a bit set for each non-empty sub-bin of
+ * bin i.  So the first non-empty sub-bin whose blocks are all at
+ * least a given size is found in constant time by cbsSegFitFind.
+ *
+ * .segfit.tree: The blocks are still kept in the splay tree, which is
+ * needed to coalesce on insert and to find the block containing a
+ * range on delete.  But a block found in a sub-bin is shrunk in place
+ * without splaying (see cbsSegFitFindDelete).  Shrinking a block
+ * doesn't change its order relative to its neighbours, and CBSSegFit
+ * keeps no summaries in the tree that would need updating.  So
+ * finding a range is constant time unless it uses up the block.
+ *
+ * .segfit.order: In exchange, LandFindFirst and LandFindLast are not
+ * address-ordered: both return the most recently binned block in the
+ * first suitable sub-bin (a "good fit").
+ */
+
+#define cbsSegFitSubBinSHIFT 3
+#define cbsSegFitSubBINS ((Index)1 << cbsSegFitSubBinSHIFT)
+#define cbsSegFitBINS ((Index)MPS_WORD_WIDTH)
+#define cbsSegFitSubBinsSize \
+  (sizeof(RingStruct) * cbsSegFitBINS * cbsSegFitSubBINS)
+#define cbsSegFitSubBinRing(segFit, bin, subBin) \
+  (&(segFit)->subBins[(bin) * cbsSegFitSubBINS + (subBin)])
+#define cbsSegFitGrains(segFit, size) ((Word)(size) >> (segFit)->alignShift)
+
+/* cbsWordHighest, cbsWordLowest -- index of highest or lowest set bit
+ *
+ * Where the compiler has no builtin (see config.h), halve the word
+ * until one bit is left, as ACTION_FIND_SET_BIT does in bt.c, so that
+ * this takes MPS_WORD_SHIFT steps rather than one per bit.
+ */
+
+static Index cbsWordHighest(Word word)
+{
+  AVER_CRITICAL(word != 0);
+#if defined(WORD_HIGHEST_BIT)
+  return WORD_HIGHEST_BIT(word);
+#else
+  {
+    Index index = 0;
+    Index width = MPS_WORD_WIDTH >> 1;
+    while (width != 0) {
+      if ((word >> width) != 0) {
+        index += width;
+        word >>= width;
+      }
+      width >>= 1;
+    }
+    return index;
+  }
+#endif
+}
+
+static Index cbsWordLowest(Word word)
+{
+  AVER_CRITICAL(word != 0);
+#if defined(WORD_LOWEST_BIT)
+  return WORD_LOWEST_BIT(word);
+#else
+  return cbsWordHighest(word & (~word + 1));
+#endif
+}
+
+
+/* cbsSegFitSubBin -- find the sub-bin for blocks of a size in grains */
+
+static void cbsSegFitSubBin(Index *binReturn, Index *subBinReturn,
+                            Word grains)
+{
+  Index high;
+
+  AVER_CRITICAL(grains > 0);
+
+  if (grains < cbsSegFitSubBINS) {
+    *binReturn = 0;
+    *subBinReturn = (Index)grains;
+  } else {
+    high = cbsWordHighest(grains);
+    *binReturn = high - cbsSegFitSubBinSHIFT + 1;
+    *subBinReturn = (Index)(grains >> (high - cbsSegFitSubBinSHIFT))
+                    - cbsSegFitSubBINS;
+  }
+}
+
+
+/* cbsSegFitBin, cbsSegFitUnbin -- add or remove a block in its sub-bin
+ *
+ * cbsSegFitUnbin takes the size of the block when it was binned,
+ * because the block may have grown or shrunk since.
+ */
+
+static void cbsSegFitBin(CBSSegFit segFit, CBSSegFitBlock block)
+{
+  Index bin, subBin;
+  CBSBlock cbsBlock = &block->cbsBlockStruct;
+
+  cbsSegFitSubBin(&bin, &subBin,
+                  cbsSegFitGrains(segFit, CBSBlockSize(cbsBlock)));
+  RingInsert(cbsSegFitSubBinRing(segFit, bin, subBin), &block->binRing);
+  segFit->subBinMap[bin] |= (Word)1 << subBin;
+  segFit->binMap |= (Word)1 << bin;
+}
+
+static void cbsSegFitUnbin(CBSSegFit segFit, CBSSegFitBlock block,
+                           Size size)
+{
+  Index bin, subBin;
+
+  cbsSegFitSubBin(&bin, &subBin, cbsSegFitGrains(segFit, size));
+  RingRemove(&block->binRing);
+  if (RingIsSingle(cbsSegFitSubBinRing(segFit, bin, subBin))) {
+    segFit->subBinMap[bin] &= ~((Word)1 << subBin);
+    if (segFit->subBinMap[bin] == 0)
+      segFit->binMap &= ~((Word)1 << bin);
+  }
+}
+
+
+/* cbsSegFitRebin -- move a block that has grown or shrunk */
+
+static void cbsSegFitRebin(CBSSegFit segFit, CBSBlock block, Size oldSize)
+{
+  Index oldBin, oldSubBin, bin, subBin;
+
+  cbsSegFitSubBin(&oldBin, &oldSubBin, cbsSegFitGrains(segFit, oldSize));
+  cbsSegFitSubBin(&bin, &subBin,
+                  cbsSegFitGrains(segFit, CBSBlockSize(block)));
+  if (bin != oldBin || subBin != oldSubBin) {
+    cbsSegFitUnbin(segFit, cbsSegFitBlockOfBlock(block), oldSize);
+    cbsSegFitBin(segFit, cbsSegFitBlockOfBlock(block));
+  }
+}
+
+
 /* cbsInit -- Initialise a CBS structure
  *
  * See <design/land/#function.init>.
@@ -283,6 +446,45 @@ static Res cbsInitZoned(Land land, Arena arena, Align alignment, ArgList args)
                      sizeof(CBSZonedBlockStruct));
 }
 
+static Res cbsInitSegFit(Land land, Arena arena, Align alignment,
+                         ArgList args)
+{
+  CBSSegFit segFit;
+  Index i;
+  void *p;
+  Res res;
+
+  res = cbsInitComm(land, CLASS(CBS), arena, alignment,
+                    args, SplayTrivUpdate,
+                    sizeof(CBSSegFitBlockStruct));
+  if (res != ResOK)
+    goto failInit;
+  segFit = CouldBeA(CBSSegFit, land);
+
+  res = ControlAlloc(&p, arena, cbsSegFitSubBinsSize);
+  if (res != ResOK)
+    goto failAlloc;
+  segFit->subBins = p;
+  for (i = 0; i < cbsSegFitBINS * cbsSegFitSubBINS; ++i)
+    RingInit(&segFit->subBins[i]);
+  for (i = 0; i < cbsSegFitBINS; ++i)
+    segFit->subBinMap[i] = 0;
+  segFit->binMap = 0;
+  segFit->alignShift = SizeLog2(alignment);
+
+  SetClassOfPoly(land, CLASS(CBSSegFit));
+  segFit->sig = CBSSegFitSig;
+  AVERC(CBSSegFit, segFit);
+
+  return ResOK;
+
+failAlloc:
+  LandFinish(land);
+failInit:
+  AVER(res != ResOK);
+  return res;
+}
+
 
 /* cbsFinish -- Finish a CBS structure
  *
@@ -305,6 +507,19 @@ static void cbsFinish(Inst inst)
   NextMethod(Inst, CBS, finish)(inst);
 }
 
+static void cbsFinishSegFit(Inst inst)
+{
+  Land land = MustBeA(Land, inst);
+  CBSSegFit segFit = MustBeA(CBSSegFit, land);
+
+  /* The land need not be empty (see MVFFFinish), so the sub-bins are
+     freed without being finished. */
+  segFit->sig = SigInvalid;
+  ControlFree(LandArena(land), segFit->subBins, cbsSegFitSubBinsSize);
+
+  NextMethod(Inst, CBSSegFit, finish)(inst);
+}
+
 
 /* cbsSize -- total size of ranges in CBS
  *
@@ -330,6 +545,8 @@ static void cbsBlockDestroy(CBS cbs, CBSBlock block)
   STATISTIC(--cbs->treeSize);
   AVER(cbs->size >= size);
   cbs->size -= size;
+  if (IsA(CBSSegFit, cbs))
+    cbsSegFitUnbin(cbsSegFitOfCBS(cbs), cbsSegFitBlockOfBlock(block), size);
 
   /* make invalid */
   block->limit = block->base;
@@ -341,7 +558,7 @@ static void cbsBlockDestroy(CBS cbs, CBSBlock block)
  *
  * These four functions are called whenever blocks are created,
  * destroyed, grow, or shrink.  They maintain the maxSize if fastFind is
- * enabled.
+ * enabled, and the sub-bins of a CBSSegFit (.segfit).
  */
 
 static void cbsBlockDelete(CBS cbs, CBSBlock block)
@@ -368,8 +585,11 @@ static void cbsBlockShrunk(CBS cbs, CBSBlock block, Size oldSize)
   AVER(oldSize > newSize);
   AVER(cbs->size >= oldSize - newSize);
 
-  SplayNodeRefresh(cbsSplay(cbs), cbsBlockTree(block));
+  if (SplayHasUpdate(cbsSplay(cbs)))
+    SplayNodeRefresh(cbsSplay(cbs), cbsBlockTree(block));
   cbs->size -= oldSize - newSize;
+  if (IsA(CBSSegFit, cbs))
+    cbsSegFitRebin(cbsSegFitOfCBS(cbs), block, oldSize);
 }
 
 static void cbsBlockGrew(CBS cbs, CBSBlock block, Size oldSize)
@@ -382,8 +602,11 @@ static void cbsBlockGrew(CBS cbs, CBSBlock block, Size oldSize)
   newSize = CBSBlockSize(block);
   AVER(oldSize < newSize);
 
-  SplayNodeRefresh(cbsSplay(cbs), cbsBlockTree(block));
+  if (SplayHasUpdate(cbsSplay(cbs)))
+    SplayNodeRefresh(cbsSplay(cbs), cbsBlockTree(block));
   cbs->size += newSize - oldSize;
+  if (IsA(CBSSegFit, cbs))
+    cbsSegFitRebin(cbsSegFitOfCBS(cbs), block, oldSize);
 }
 
 /* cbsBlockAlloc -- allocate a new block and set its base and limit,
@@ -408,7 +631,10 @@ static Res cbsBlockAlloc(CBSBlock *blockReturn, CBS cbs, Range range)
   block->base = RangeBase(range);
   block->limit = RangeLimit(range);
 
-  SplayNodeInit(cbsSplay(cbs), cbsBlockTree(block));
+  if (SplayHasUpdate(cbsSplay(cbs)))
+    SplayNodeInit(cbsSplay(cbs), cbsBlockTree(block));
+  if (IsA(CBSSegFit, cbs))
+    RingInit(&cbsSegFitBlockOfBlock(block)->binRing);
 
   AVERT(CBSBlock, block);
   *blockReturn = block;
@@ -433,6 +659,8 @@ static void cbsBlockInsert(CBS cbs, CBSBlock block)
   AVER(b);
   STATISTIC(++cbs->treeSize);
   cbs->size += CBSBlockSize(block);
+  if (IsA(CBSSegFit, cbs))
+    cbsSegFitBin(cbsSegFitOfCBS(cbs), cbsSegFitBlockOfBlock(block));
 }
 
 
@@ -903,6 +1131,183 @@ static Bool cbsFindFirst(Range rangeReturn, Range oldRangeReturn,
   return found;
 }
 
+/* cbsSegFitFind -- find a block in the sub-bins of at least a size
+ *
+ * See .segfit.map.  Searching starts at the sub-bin after the one for
+ * the size (unless it is exact), so that any block found is big
+ * enough.  If that fails, search the sub-bin for the size itself, so
+ * that we find a block if there is one.
+ */
+
+static CBSBlock cbsSegFitFind(CBSSegFit segFit, Size size)
+{
+  Index bin, subBin;
+  Word grains, start, map;
+  Ring ring, node, next;
+
+  AVER_CRITICAL(size > 0);
+
+  grains = cbsSegFitGrains(segFit, size);
+  start = grains;
+  if (grains >= cbsSegFitSubBINS) {
+    Shift shift = cbsWordHighest(grains) - cbsSegFitSubBinSHIFT;
+    start = grains + ((Word)1 << shift) - 1;
+  }
+
+  if (start >= grains) { /* otherwise start overflowed */
+    cbsSegFitSubBin(&bin, &subBin, start);
+    map = segFit->subBinMap[bin] & ((Word)-1 << subBin);
+    if (map == 0 && bin + 1 < cbsSegFitBINS) {
+      map = segFit->binMap & ((Word)-1 << (bin + 1));
+      if (map != 0) {
+        bin = cbsWordLowest(map);
+        map = segFit->subBinMap[bin];
+      }
+    }
+    if (map != 0) {
+      subBin = cbsWordLowest(map);
+      ring = RingNext(cbsSegFitSubBinRing(segFit, bin, subBin));
+      return &cbsSegFitBlockOfRing(ring)->cbsBlockStruct;
+    }
+    if (start == grains)
+      return NULL;
+  }
+
+  cbsSegFitSubBin(&bin, &subBin, grains);
+  ring = cbsSegFitSubBinRing(segFit, bin, subBin);
+  RING_FOR(node, ring, next) {
+    CBSBlock block = &cbsSegFitBlockOfRing(node)->cbsBlockStruct;
+    if (CBSBlockSize(block) >= size)
+      return block;
+  }
+  return NULL;
+}
+
+
+/* cbsSegFitFindDelete -- delete appropriate range of block found
+ *
+ * Like cbsFindDeleteRange, but shrinks the block in place rather than
+ * looking it up in the tree.  See .segfit.tree.
+ */
+
+static void cbsSegFitFindDelete(Range rangeReturn, Range oldRangeReturn,
+                                CBS cbs, CBSBlock block, Size size,
+                                FindDelete findDelete)
+{
+  Addr base, limit;
+  Size oldSize;
+
+  AVER_CRITICAL(CBSBlockSize(block) >= size);
+
+  base = CBSBlockBase(block);
+  limit = CBSBlockLimit(block);
+  RangeInit(oldRangeReturn, base, limit);
+
+  switch (findDelete) {
+  case FindDeleteNONE:
+    RangeInit(rangeReturn, base, limit);
+    return;
+
+  case FindDeleteLOW:
+    limit = AddrAdd(base, size);
+    break;
+
+  case FindDeleteHIGH:
+    base = AddrSub(limit, size);
+    break;
+
+  case FindDeleteENTIRE:
+    /* do nothing */
+    break;
+
+  default:
+    NOTREACHED;
+    break;
+  }
+
+  RangeInit(rangeReturn, base, limit);
+  oldSize = CBSBlockSize(block);
+  if (base == CBSBlockBase(block) && limit == CBSBlockLimit(block)) {
+    cbsBlockDelete(cbs, block);
+  } else {
+    if (base == CBSBlockBase(block))
+      block->base = limit;
+    else
+      block->limit = base;
+    cbsBlockShrunk(cbs, block, oldSize);
+  }
+}
+
+
+/* cbsSegFitFindFirst -- find a good fit in a segregated-fit CBS
+ *
+ * This is both the findFirst and findLast method.  See .segfit.order.
+ */
+
+static Bool cbsSegFitFindFirst(Range rangeReturn, Range oldRangeReturn,
+                               Land land, Size size, FindDelete findDelete)
+{
+  CBSSegFit segFit = MustBeA_CRITICAL(CBSSegFit, land);
+  CBSBlock block;
+
+  AVER_CRITICAL(rangeReturn != NULL);
+  AVER_CRITICAL(oldRangeReturn != NULL);
+  AVER_CRITICAL(size > 0);
+  AVER_CRITICAL(SizeIsAligned(size, LandAlignment(land)));
+  AVERT_CRITICAL(FindDelete, findDelete);
+
+  block = cbsSegFitFind(segFit, size);
+  if (block == NULL)
+    return FALSE;
+
+  cbsSegFitFindDelete(rangeReturn, oldRangeReturn, &segFit->cbsStruct,
+                      block, size, findDelete);
+  return TRUE;
+}
+
+
+/* cbsSegFitFindLargest -- find the largest block in the sub-bins
+ *
+ * The largest block is in the last non-empty sub-bin, but that
+ * sub-bin has to be searched for it.
+ */
+
+static Bool cbsSegFitFindLargest(Range rangeReturn, Range oldRangeReturn,
+                                 Land land, Size size,
+                                 FindDelete findDelete)
+{
+  CBSSegFit segFit = MustBeA(CBSSegFit, land);
+  CBSBlock largest = NULL;
+  Index bin, subBin;
+  Ring ring, node, next;
+
+  AVER(rangeReturn != NULL);
+  AVER(oldRangeReturn != NULL);
+  AVER(size > 0);
+  AVERT(FindDelete, findDelete);
+
+  if (segFit->binMap == 0)
+    return FALSE;
+
+  bin = cbsWordHighest(segFit->binMap);
+  subBin = cbsWordHighest(segFit->subBinMap[bin]);
+  ring = cbsSegFitSubBinRing(segFit, bin, subBin);
+  RING_FOR(node, ring, next) {
+    CBSBlock block = &cbsSegFitBlockOfRing(node)->cbsBlockStruct;
+    if (largest == NULL || CBSBlockSize(block) > CBSBlockSize(largest))
+      largest = block;
+  }
+  AVER(largest != NULL);
+
+  if (CBSBlockSize(largest) < size)
+    return FALSE;
+
+  cbsSegFitFindDelete(rangeReturn, oldRangeReturn, &segFit->cbsStruct,
+                      largest, size, findDelete);
+  return TRUE;
+}
+
+
 /* cbsFindInZones -- find a block of at least the given size that lies
  * entirely within a zone set. (The first such block, if high is
  * FALSE, or the last, if high is TRUE.)
@@ -1135,6 +1540,26 @@ static Res cbsDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
   return res;
 }
 
+static Res cbsDescribeSegFit(Inst inst, mps_lib_FILE *stream, Count depth)
+{
+  Land land = CouldBeA(Land, inst);
+  CBSSegFit segFit = CouldBeA(CBSSegFit, land);
+  Res res;
+
+  if (!TESTC(CBSSegFit, segFit))
+    return ResPARAM;
+  if (stream == NULL)
+    return ResPARAM;
+
+  res = NextMethod(Inst, CBSSegFit, describe)(inst, stream, depth);
+  if (res != ResOK)
+    return res;
+
+  return WriteF(stream, depth + 2,
+                "binMap $B\n", (WriteFB)segFit->binMap,
+                NULL);
+}
+
 DEFINE_CLASS(Land, CBS, klass)
 {
   INHERIT_CLASS(klass, CBS, Land);
@@ -1165,6 +1590,18 @@ DEFINE_CLASS(Land, CBSZoned, klass)
   klass->init = cbsInitZoned;
 }
 
+DEFINE_CLASS(Land, CBSSegFit, klass)
+{
+  INHERIT_CLASS(klass, CBSSegFit, CBS);
+  klass->instClassStruct.describe = cbsDescribeSegFit;
+  klass->instClassStruct.finish = cbsFinishSegFit;
+  klass->size = sizeof(CBSSegFitStruct);
+  klass->init = cbsInitSegFit;
+  klass->findFirst = cbsSegFitFindFirst;
+  klass->findLast = cbsSegFitFindFirst;
+  klass->findLargest = cbsSegFitFindLargest;
+}
+
 
 /* C. COPYRIGHT AND LICENSE
  *
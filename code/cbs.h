@@ -35,9 +35,17 @@ typedef struct CBSZonedBlockStruct {
   ZoneSet zones; /* union zone set of all ranges in sub-tree */
 } CBSZonedBlockStruct;
 
+typedef struct CBSSegFitBlockStruct *CBSSegFitBlock;
+typedef struct CBSSegFitBlockStruct {
+  struct CBSBlockStruct cbsBlockStruct;
+  RingStruct binRing; /* attaches block to its sub-bin */
+} CBSSegFitBlockStruct;
+
 typedef struct CBSStruct *CBS, *CBSFast, *CBSZoned;
+typedef struct CBSSegFitStruct *CBSSegFit;
 
 extern Bool CBSCheck(CBS cbs);
+extern Bool CBSSegFitCheck(CBSSegFit segFit);
 
 
 /* CBSLand -- convert CBS to Land
@@ -54,6 +62,7 @@ extern Bool CBSCheck(CBS cbs);
 DECLARE_CLASS(Land, CBS, Land);
 DECLARE_CLASS(Land, CBSFast, CBS);
 DECLARE_CLASS(Land, CBSZoned, CBSFast);
+DECLARE_CLASS(Land, CBSSegFit, CBS);
 
 extern const struct mps_key_s _mps_key_cbs_block_pool;
 #define CBSBlockPool (&_mps_key_cbs_block_pool)
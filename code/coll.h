@@ -0,0 +1,102 @@
+/* coll.h: BACKGROUND COLLECTOR THREAD
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * .purpose: Provides a thread that does collection work on behalf of
+ * an arena, so that the work is not charged to the mutator threads.
+ * See <design/arena/#collector>.
+ *
+ * .platform: Creating and waking threads is platform-specific, so
+ * there is one implementation of this interface per platform, like
+ * the lock module (<code/lock.h>).  The work itself is done by
+ * ArenaCollectorStep, which is platform-independent.
+ */
+
+#ifndef coll_h
+#define coll_h
+
+#include "mpm.h"
+
+
+#define CollectorSig    ((Sig)0x519C011E) /* SIGnature COLLEctor */
+
+
+/* CollectorSize -- Return the size of a CollectorStruct
+ *
+ * Supports allocation of collectors.
+ */
+
+extern size_t CollectorSize(void);
+
+
+/*  CollectorInit
+ *
+ *  collector points to the allocated collector structure.  Start a
+ *  thread that repeatedly calls ArenaCollectorStep for arena, and
+ *  waits for the interval that it returns.  Return ResUNIMPL if
+ *  there's no implementation of threads on this platform, or
+ *  ResRESOURCE if the thread can't be created.
+ */
+
+extern Res CollectorInit(Collector collector, Arena arena);
+
+
+/*  CollectorFinish
+ *
+ *  Stop the thread, waiting for it to finish any step in progress.
+ *  This must not be called while holding the arena lock, since the
+ *  thread may be waiting for it.
+ */
+
+extern void CollectorFinish(Collector collector);
+
+
+/*  CollectorCheck -- Validation */
+
+extern Bool CollectorCheck(Collector collector);
+
+
+#endif /* coll_h */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
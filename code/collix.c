@@ -0,0 +1,226 @@
+/* collix.c: BACKGROUND COLLECTOR THREAD FOR POSIX SYSTEMS
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * .posix: The implementation uses POSIX threads, and supports
+ * FreeBSD, Linux and Darwin (OS X).
+ *
+ * .design: The thread loops, calling ArenaCollectorStep and then
+ * waiting on a condition variable for the interval it returns.
+ * CollectorFinish sets the stop flag and signals the condition
+ * variable, so that the thread notices at once, rather than at the
+ * end of a long wait.  See <design/arena/#collector>.
+ *
+ * .stop: The stop field must only be read or written while holding
+ * the mutex.
+ *
+ * .realtime: pthread_cond_timedwait takes an absolute time on the
+ * realtime clock.  gettimeofday is used to get it, since
+ * clock_gettime is not available on older versions of OS X.
+ */
+
+#include "coll.h"
+#include "mpm.h"
+
+#include <errno.h>
+#include <pthread.h> /* see .feature.li in config.h */
+#include <sys/time.h>
+
+#if !defined(MPS_OS_FR) && !defined(MPS_OS_LI) && !defined(MPS_OS_XC)
+#error "collix.c is Unix specific."
+#endif
+
+SRCID(collix, "$Id$");
+
+#if defined(LOCK)
+
+/* CollectorStruct -- the background collector structure */
+
+typedef struct CollectorStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* arena being collected */
+  Bool stop;                    /* should the thread stop? see .stop */
+  pthread_mutex_t mut;          /* protects stop */
+  pthread_cond_t cond;          /* signalled when stop is set */
+  pthread_t thread;             /* the collector thread */
+} CollectorStruct;
+
+
+/* CollectorSize -- size of a CollectorStruct */
+
+size_t CollectorSize(void)
+{
+  return sizeof(CollectorStruct);
+}
+
+
+/* CollectorCheck -- check a collector */
+
+Bool CollectorCheck(Collector collector)
+{
+  CHECKS(Collector, collector);
+  CHECKU(Arena, collector->arena);
+  /* Can't check stop without claiming the mutex: see .stop. */
+  return TRUE;
+}
+
+
+/* collectorWait -- wait until interval seconds from now, or until stopped
+ *
+ * Return TRUE if the thread should stop.
+ */
+
+static Bool collectorWait(Collector collector, double interval)
+{
+  struct timeval now;
+  struct timespec deadline;
+  double secs;
+  Bool stop;
+  int res;
+
+  AVER(interval >= 0.0);
+
+  res = gettimeofday(&now, NULL);
+  AVER(res == 0);
+  secs = (double)now.tv_sec + now.tv_usec / 1e6 + interval;
+  deadline.tv_sec = (time_t)secs;
+  deadline.tv_nsec = (long)((secs - (double)deadline.tv_sec) * 1e9);
+  if (deadline.tv_nsec >= 1000000000L)
+    deadline.tv_nsec = 999999999L;
+
+  res = pthread_mutex_lock(&collector->mut);
+  AVER(res == 0);
+  /* Spurious wakeups just mean an early step, so there's no loop. */
+  if (!collector->stop) {
+    res = pthread_cond_timedwait(&collector->cond, &collector->mut,
+                                 &deadline);
+    AVER(res == 0 || res == ETIMEDOUT || res == EINTR);
+  }
+  stop = collector->stop;
+  res = pthread_mutex_unlock(&collector->mut);
+  AVER(res == 0);
+
+  return stop;
+}
+
+
+/* collectorThread -- the body of the collector thread */
+
+static void *collectorThread(void *p)
+{
+  Collector collector = p;
+  double interval;
+
+  do {
+    interval = ArenaCollectorStep(collector->arena);
+  } while (!collectorWait(collector, interval));
+
+  return NULL;
+}
+
+
+/* CollectorInit -- initialize a collector and start its thread */
+
+Res CollectorInit(Collector collector, Arena arena)
+{
+  int res;
+
+  AVER(collector != NULL);
+  AVER(TESTT(Arena, arena));
+
+  collector->arena = arena;
+  collector->stop = FALSE;
+  res = pthread_mutex_init(&collector->mut, NULL);
+  AVER(res == 0);
+  res = pthread_cond_init(&collector->cond, NULL);
+  AVER(res == 0);
+  collector->sig = CollectorSig;
+  AVERT(Collector, collector);
+
+  res = pthread_create(&collector->thread, NULL, collectorThread, collector);
+  if (res != 0) {
+    collector->sig = SigInvalid;
+    (void)pthread_cond_destroy(&collector->cond);
+    (void)pthread_mutex_destroy(&collector->mut);
+    return ResRESOURCE;
+  }
+
+  return ResOK;
+}
+
+
+/* CollectorFinish -- stop the thread and finish a collector */
+
+void CollectorFinish(Collector collector)
+{
+  int res;
+
+  AVERT(Collector, collector);
+
+  res = pthread_mutex_lock(&collector->mut);
+  AVER(res == 0);
+  collector->stop = TRUE;
+  res = pthread_cond_signal(&collector->cond);
+  AVER(res == 0);
+  res = pthread_mutex_unlock(&collector->mut);
+  AVER(res == 0);
+
+  res = pthread_join(collector->thread, NULL);
+  AVER(res == 0);
+
+  res = pthread_cond_destroy(&collector->cond);
+  AVER(res == 0);
+  res = pthread_mutex_destroy(&collector->mut);
+  AVER(res == 0);
+  collector->sig = SigInvalid;
+}
+
+
+#elif defined(LOCK_NONE)
+#include "collan.c"
+#else
+#error "No lock configuration."
+#endif
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
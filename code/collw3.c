@@ -0,0 +1,154 @@
+/* collw3.c: BACKGROUND COLLECTOR THREAD FOR WIN32
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * .design: The thread loops, calling ArenaCollectorStep and then
+ * waiting on a manual-reset event for the interval it returns.
+ * CollectorFinish sets the event, so that the thread notices at
+ * once, rather than at the end of a long wait.  See
+ * <design/arena/#collector>.
+ */
+
+#include "coll.h"
+#include "mpm.h"
+
+#ifndef MPS_OS_W3
+#error "collw3.c is specific to Win32 but MPS_OS_W3 not defined"
+#endif
+
+#include "mpswin.h"
+
+SRCID(collw3, "$Id$");
+
+#if defined(LOCK)
+
+typedef struct CollectorStruct {
+  Sig sig;                      /* <design/sig/> */
+  Arena arena;                  /* arena being collected */
+  HANDLE stop;                  /* event set when the thread should stop */
+  HANDLE thread;                /* the collector thread */
+} CollectorStruct;
+
+
+size_t CollectorSize(void)
+{
+  return sizeof(CollectorStruct);
+}
+
+Bool CollectorCheck(Collector collector)
+{
+  CHECKS(Collector, collector);
+  CHECKU(Arena, collector->arena);
+  CHECKL(collector->stop != NULL);
+  return TRUE;
+}
+
+
+/* collectorThread -- the body of the collector thread */
+
+static DWORD WINAPI collectorThread(LPVOID p)
+{
+  Collector collector = p;
+  double interval;
+  DWORD wait;
+
+  do {
+    interval = ArenaCollectorStep(collector->arena);
+    AVER(interval >= 0.0);
+    wait = (DWORD)(interval * 1000.0);
+  } while (WaitForSingleObject(collector->stop, wait) == WAIT_TIMEOUT);
+
+  return 0;
+}
+
+
+Res CollectorInit(Collector collector, Arena arena)
+{
+  AVER(collector != NULL);
+  AVER(TESTT(Arena, arena));
+
+  collector->arena = arena;
+  collector->stop = CreateEvent(NULL, TRUE, FALSE, NULL);
+  if (collector->stop == NULL)
+    return ResRESOURCE;
+  collector->sig = CollectorSig;
+  AVERT(Collector, collector);
+
+  collector->thread = CreateThread(NULL, 0, collectorThread, collector,
+                                   0, NULL);
+  if (collector->thread == NULL) {
+    collector->sig = SigInvalid;
+    (void)CloseHandle(collector->stop);
+    return ResRESOURCE;
+  }
+
+  return ResOK;
+}
+
+void CollectorFinish(Collector collector)
+{
+  BOOL b;
+  DWORD r;
+
+  AVERT(Collector, collector);
+
+  b = SetEvent(collector->stop);
+  AVER(b);
+  r = WaitForSingleObject(collector->thread, INFINITE);
+  AVER(r == WAIT_OBJECT_0);
+  b = CloseHandle(collector->thread);
+  AVER(b);
+  b = CloseHandle(collector->stop);
+  AVER(b);
+  collector->sig = SigInvalid;
+}
+
+
+#elif defined(LOCK_NONE)
+#include "collan.c"
+#else
+#error "No lock configuration."
+#endif
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -200,6 +200,19 @@
 #endif
 
 
+/* CONFIG_PROT_UFFD -- use userfaultfd for the write barrier on Linux
+ *
+ * This symbol causes the MPS to implement write protection using the
+ * write-protect mode of userfaultfd(2), so that write barrier hits
+ * are handled by a dedicated thread instead of a signal handler.
+ * Read protection still uses mprotect(2).  See <code/protuffd.c>.
+ */
+
+#if defined(CONFIG_PROT_UFFD)
+#define PROT_UFFD
+#endif
+
+
 #define MPS_VARIETY_STRING \
   MPS_ASSERT_STRING "." MPS_LOG_STRING "." MPS_STATS_STRING
 
@@ -318,6 +331,45 @@
 #define LIKELY(exp) ((exp) != 0)
 #endif
 
+/* WORD_LOWEST_BIT, WORD_HIGHEST_BIT -- index of lowest or highest set bit
+ *
+ * The word must not be zero.  Only GCC and Clang have the builtins,
+ * and only there is unsigned long as wide as a Word, so elsewhere
+ * (for example, Visual C) these are not defined and callers fall back
+ * to a portable C search.  See
+ * <https://gcc.gnu.org/onlinedocs/gcc/Other-Builtins.html>.
+ */
+
+#if defined(MPS_BUILD_GC) || defined(MPS_BUILD_LL)
+#define WORD_LOWEST_BIT(word) ((Index)__builtin_ctzl(word))
+#define WORD_HIGHEST_BIT(word) \
+  ((Index)(MPS_WORD_WIDTH - 1) - (Index)__builtin_clzl(word))
+#endif
+
+/* ATOMIC_CAS_PTR -- atomic compare-and-swap of a pointer
+ *
+ * If the pointer at p is equal to old, atomically replace it with new
+ * and return true, otherwise return false.  Acts as a full memory
+ * barrier.  On Windows, the module must include "mpswin.h".  See
+ * <https://gcc.gnu.org/onlinedocs/gcc/_005f_005fsync-Builtins.html>
+ * and <https://msdn.microsoft.com/en-us/library/ms683568.aspx>.
+ */
+
+#if defined(MPS_BUILD_GC) || defined(MPS_BUILD_LL)
+#define ATOMIC_CAS_PTR(p, old, new) \
+  __sync_bool_compare_and_swap(p, old, new)
+#elif defined(MPS_BUILD_MV) || defined(MPS_BUILD_PC)
+#define ATOMIC_CAS_PTR(p, old, new) \
+  (InterlockedCompareExchangePointer((void *volatile *)(p), \
+                                     (void *)(new), (void *)(old)) \
+   == (void *)(old))
+#elif defined(CONFIG_THREAD_SINGLE)
+#define ATOMIC_CAS_PTR(p, old, new) \
+  (*(p) == (old) ? (*(p) = (new), 1) : 0)
+#else
+#error "No atomic compare-and-swap for this compiler."
+#endif
+
 
 /* EPVMDefaultSubsequentSegSIZE is a default for the alignment of
  * subsequent segments (non-initial at each save level) in EPVM.  See
@@ -337,6 +389,7 @@
 #define FMT_ALIGN_DEFAULT ((Align)MPS_PF_ALIGN)
 #define FMT_HEADER_SIZE_DEFAULT ((Size)0)
 #define FMT_SCAN_DEFAULT (&FormatNoScan)
+#define FMT_SCAN_PART_DEFAULT NULL
 #define FMT_SKIP_DEFAULT (&FormatNoSkip)
 #define FMT_FWD_DEFAULT (&FormatNoMove)
 #define FMT_ISFWD_DEFAULT (&FormatNoIsMoved)
@@ -350,6 +403,28 @@
 /* AMC treats objects larger than or equal to this as "Large" */
 #define AMC_LARGE_SIZE_DEFAULT ((Size)32768)
 #define AMC_EXTEND_BY_DEFAULT  ((Size)8192)
+#define AMC_MARK_THRESHOLD_DEFAULT (1.0) /* never mark in place */
+#define AMC_COPY_DEPTH_DEFAULT ((Count)0) /* copy breadth-first */
+/* Each level of nesting exposes two segments: see <design/poolamc/#copy.max> */
+#define AMC_COPY_DEPTH_MAX     ((Count)8)
+#define AMC_PRETENURE_DEFAULT  FALSE
+
+/* A mutator buffer that adapts its generation moves to an older one
+ * if more than AMCPretenureHIGH of the memory it allocates survives
+ * its first collection, and back to a younger one if less than
+ * AMCPretenureLOW survives, measured over at least AMCPretenureSAMPLE
+ * bytes.  See <design/poolamc/#pretenure.adapt>. */
+#define AMCPretenureSAMPLE     ((Size)256 * 1024)
+#define AMCPretenureHIGH       (0.5)
+#define AMCPretenureLOW        (0.1)
+
+/* A mutator buffer whose fills come less than AMCFillFAST seconds apart
+ * gets bigger segments, up to AMCFillGROWTH_LIMIT times extendBy; one
+ * whose fills come more than AMCFillSLOW seconds apart gets smaller
+ * ones.  See <design/poolamc/#fill.adapt>. */
+#define AMCFillFAST            (0.001)
+#define AMCFillSLOW            (0.1)
+#define AMCFillGROWTH_LIMIT    ((Size)8)
 
 
 /* Pool AMS Configuration -- see <code/poolams.c> */
@@ -357,6 +432,11 @@
 #define AMS_SUPPORT_AMBIGUOUS_DEFAULT TRUE
 #define AMS_GEN_DEFAULT       0
 
+/* AMSGreyStackLENGTH is the number of newly grey objects each AMS
+ * segment remembers for scanning before it falls back to searching
+ * its colour tables.  See <design/poolams/#scan.stack>. */
+#define AMSGreyStackLENGTH ((Count)32)
+
 
 /* Pool AWL Configuration -- see <code/poolawl.c> */
 
@@ -370,6 +450,10 @@
 /* Pool LO Configuration -- see <code/poollo.c> */
 
 #define LO_GEN_DEFAULT       0
+#define LO_LAZY_SWEEP_DEFAULT FALSE
+#define LO_SIZE_CLASSES_DEFAULT FALSE
+#define LO_SIZE_CLASS_COUNT  8      /* slots of 1, 2, 4, ... 128 grains */
+#define LO_SIZE_CLASS_SEG_SLOTS 64  /* minimum slots in a size class segment */
 
 
 /* Pool MV Configuration -- see <code/poolmv.c> */
@@ -383,6 +467,9 @@
 /* Pool MFS Configuration -- see <code/poolmfs.c> */
 
 #define MFS_EXTEND_BY_DEFAULT ((Size)65536)
+#define MFS_MAGAZINE_SIZE_DEFAULT 0 /* no magazines */
+#define MFS_MAGAZINE_SLOTS    16    /* magazine pairs; power of 2 */
+#define MFS_DEPOT_LIMIT       32    /* full magazines in the depot */
 
 
 /* Pool MVFF Configuration -- see <code/poolmvff.c> */
@@ -393,7 +480,11 @@
 #define MVFF_SLOT_HIGH_DEFAULT   FALSE
 #define MVFF_ARENA_HIGH_DEFAULT  FALSE
 #define MVFF_FIRST_FIT_DEFAULT   TRUE
+#define MVFF_SEGREGATED_FIT_DEFAULT FALSE
+#define MVFF_POOL_LOCK_DEFAULT   FALSE
 #define MVFF_SPARE_DEFAULT       0.75
+#define MVFF_CACHE_CLASSES       64  /* sizes cached, in units of alignment */
+#define MVFF_CACHE_DEPTH         32  /* blocks cached of each size */
 
 
 /* Pool MVT Configuration -- see <code/poolmv2.c> */
@@ -411,6 +502,12 @@
 
 #define ArenaPollALLOCTIME (65536.0)
 
+/* ArenaPollBACKGROUNDALLOCTIME is how much the mutator may allocate
+ * after a step of the background collector before it polls the arena
+ * itself.  See <design/arena/#collector.poll>. */
+
+#define ArenaPollBACKGROUNDALLOCTIME (128 * ArenaPollALLOCTIME)
+
 /* .client.seg-size: ARENA_CLIENT_GRAIN_SIZE is the minimum size, in
  * bytes, of a grain in the client arena. It's set at 8192 with no
  * particular justification. */
@@ -433,6 +530,12 @@
 
 #define ARENA_DEFAULT_ZONED     TRUE
 
+/* See <design/write-barrier/#soft> */
+#define ARENA_DEFAULT_SOFT_BARRIER FALSE
+
+/* See <design/arena/#collector> */
+#define ARENA_DEFAULT_BACKGROUND_COLLECTOR FALSE
+
 /* ARENA_MINIMUM_COLLECTABLE_SIZE is the minimum size (in bytes) of
  * collectable memory that might be considered worthwhile to run a
  * full garbage collection. */
@@ -457,6 +560,12 @@
 
 #define ARENA_MAX_COLLECT_FRACTION (0.1)
 
+/* ARENA_COLLECTOR_MAX_INTERVAL is the longest time (in seconds) that
+ * the background collector waits between steps when there's no
+ * collection work to do.  See <design/arena/#collector.interval>. */
+
+#define ARENA_COLLECTOR_MAX_INTERVAL (1.0)
+
 /* ArenaDefaultZONESET is the zone set used by LocusPrefDEFAULT.
  *
  * TODO: This is left over from before branches 2014-01-29/mps-chain-zones
@@ -482,6 +591,15 @@
 
 #define VM_ARENA_SIZE_DEFAULT ((Size)1 << 28)
 
+/* ChunkCacheLENGTH is the number of entries in the arena's
+ * direct-mapped cache of chunks, and must be a power of two.  Each
+ * entry covers an address range of 2^ChunkCacheSHIFT bytes.  Chunks
+ * are usually much larger than this, so a chunk occupies many entries
+ * and distinct chunks rarely collide.  See ChunkOfAddr in
+ * <code/tract.c>. */
+#define ChunkCacheLENGTH ((Count)64)
+#define ChunkCacheSHIFT  ((Shift)20)
+
 
 /* Locus configuration -- see <code/locus.c> */
 
@@ -505,6 +623,7 @@
 
 #define ShieldQueueLENGTH  512  /* initial length of shield queue */
 #define ShieldDepthWIDTH     4  /* log2(max nested exposes + 1) */
+#define ShieldBridgeLIMIT    8  /* max segs to bridge between queued segs */
 
 
 /* VM Configuration -- see <code/vm*.c> */
@@ -526,6 +645,7 @@
  * prmci3li.c  REG_EAX etc.              <ucontext.h>  _GNU_SOURCE
  * prmci6li.c  REG_RAX etc.              <ucontext.h>  _GNU_SOURCE
  * prmcix.h    stack_t, siginfo_t        <signal.h>    _XOPEN_SOURCE
+ * protuffd.c  syscall                   <unistd.h>    _GNU_SOURCE
  * pthrdext.c  sigaction etc.            <signal.h>    _XOPEN_SOURCE
  * vmix.c      MAP_ANON                  <sys/mman.h>  _GNU_SOURCE
  *
@@ -643,11 +763,18 @@
 #endif
 
 
-/* Tracer Configuration -- see <code/trace.c> */
+/* Tracer Configuration -- see <code/trace.c>
+ *
+ * TraceLIMIT must stay at 1 until the pool classes can cope with more
+ * than one busy trace.  See <design/trace/#instance.limit.poll>.
+ */
 
 #define TraceLIMIT ((size_t)1)
 /* I count 4 function calls to scan, 10 to copy. */
 #define TraceCopyScanRATIO (1.5)
+/* Fewest bytes a trace step lets a pool scan in a segment before the
+   pool may suspend the scan.  See <design/scan/#suspend.budget>. */
+#define TraceScanBudgetMIN ((Size)256 * 1024)
 
 /* Chosen so that the RememberedSummaryBlockStruct packs nicely into
    pages */
@@ -730,6 +857,16 @@
 #define WB_DEFER_HIT   1  /* boring scans after barrier hit */
 
 
+/* Software write barrier buffer
+ *
+ * The number of stores that mps_write_barrier records before it
+ * claims the arena lock to apply them.  See
+ * <design/write-barrier/#soft.buffer>.
+ */
+
+#define WB_SOFT_BUFFER_LENGTH 256
+
+
 #endif /* config_h */
 
 
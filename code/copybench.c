@@ -0,0 +1,352 @@
+/* copybench.c -- AMC copy order benchmark
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * This benchmark builds binary trees in an AMC pool, runs some
+ * collections, and then measures the time taken by lookups that each
+ * follow a path from the root of a random tree to a random leaf. The
+ * tests compare the orders in which AMC can copy objects (see
+ * <design/poolamc/#copy.depth>):
+ *
+ *   breadth  copy objects in the order the collector finds them
+ *   depth    copy the children of each object next to it
+ */
+
+#include "mps.c"
+#include "testlib.h"
+#include "fmtvec.h"
+#include "mpscamc.h"
+
+#ifdef MPS_OS_W3
+#include "getopt.h"
+#else
+#include <getopt.h>
+#endif
+
+#include <stdio.h> /* fprintf, printf, stderr */
+#include <stdlib.h> /* calloc, free, EXIT_FAILURE, EXIT_SUCCESS, strtoul */
+#include <string.h> /* memset, strcmp */
+#include <time.h> /* clock, CLOCKS_PER_SEC */
+
+static size_t ntrees = 64;        /* number of trees */
+static unsigned height = 16;      /* levels in each tree */
+static size_t nwords = 4;         /* words in each node */
+static unsigned ncollect = 4;     /* collections before the lookups */
+static unsigned long nlookups = 1000000; /* number of lookups */
+static unsigned long depth = 4;   /* copy depth for the depth test */
+static size_t arena_size = 512ul * 1024 * 1024; /* arena size */
+
+static mps_gen_param_s gen[] = {
+  { 1024, 0.9 }
+};
+
+
+/* Objects
+ *
+ * A node is a vector of references (see fmtvec.c). Its first and
+ * second slots are its children, or NULL, and its third is its value,
+ * a small integer. Any further slots are NULL.
+ */
+
+#define NODE_LEFT           1
+#define NODE_RIGHT          2
+#define NODE_VALUE          3
+
+
+static mps_word_t **trees;        /* the roots of the trees */
+
+
+/* make -- make a tree with the given number of levels */
+
+static mps_word_t *make(mps_ap_t ap, unsigned levels)
+{
+  mps_word_t *left, *right, *p;
+
+  if (levels == 0)
+    return NULL;
+  left = make(ap, levels - 1);
+  right = make(ap, levels - 1);
+  die(make_vec(&p, ap, nwords, VEC_REFS), "make_vec");
+  p[NODE_LEFT] = (mps_word_t)left;
+  p[NODE_RIGHT] = (mps_word_t)right;
+  p[NODE_VALUE] = levels;
+  return p;
+}
+
+
+/* lookup -- return the sum of the values on a random path in a tree */
+
+static unsigned long lookup(mps_word_t *p)
+{
+  unsigned long sum = 0, path = rnd();
+  while (p != NULL) {
+    sum += (unsigned long)p[NODE_VALUE];
+    p = (mps_word_t *)p[(path & 1) ? NODE_RIGHT : NODE_LEFT];
+    path >>= 1;
+  }
+  return sum;
+}
+
+
+/* near -- return the number of links in a tree from a node to a child
+ * in the same 4 KiB block of memory */
+
+static size_t near(mps_word_t *p)
+{
+  size_t count = 0, i;
+  if (p == NULL)
+    return 0;
+  for (i = NODE_LEFT; i <= NODE_RIGHT; ++i) {
+    mps_word_t child = p[i];
+    if (child != 0 && (child >> 12) == ((mps_word_t)p >> 12))
+      ++count;
+    count += near((mps_word_t *)child);
+  }
+  return count;
+}
+
+
+/* bench -- run one test */
+
+static void bench(const char *name, unsigned long copyDepth)
+{
+  mps_arena_t arena;
+  mps_thr_t thread;
+  mps_root_t stackroot, treeroot;
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  clock_t begin, collected, end;
+  unsigned long sum = 0;
+  size_t i, links = 0;
+  void *marker;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, arena_size);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+  die(mps_thread_reg(&thread, arena), "thread_reg");
+  die(mps_root_create_thread(&stackroot, arena, thread, &marker),
+      "root_create_thread");
+  die(mps_root_create_table(&treeroot, arena, mps_rank_exact(), 0,
+                            (mps_addr_t *)trees, ntrees),
+      "root_create_table");
+  die(vec_fmt(&format, arena), "vec_fmt");
+  die(mps_chain_create(&chain, arena, NELEMS(gen), gen), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    MPS_ARGS_ADD(args, MPS_KEY_AMC_COPY_DEPTH, copyDepth);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create_k(&ap, pool, mps_args_none), "ap_create");
+
+  mps_arena_park(arena);
+  for (i = 0; i < ntrees; ++i)
+    trees[i] = make(ap, height);
+  begin = clock();
+  for (i = 0; i < ncollect; ++i)
+    die(mps_arena_collect(arena), "arena_collect");
+  collected = clock();
+  for (i = 0; i < nlookups; ++i)
+    sum += lookup(trees[rnd() % ntrees]);
+  end = clock();
+  for (i = 0; i < ntrees; ++i)
+    links += near(trees[i]);
+
+  printf("%s: collect %g seconds, lookup %g seconds, "
+         "%.0f%% of links near, sum %lu\n", name,
+         (double)(collected - begin) / CLOCKS_PER_SEC,
+         (double)(end - collected) / CLOCKS_PER_SEC,
+         100.0 * (double)links
+         / (double)(ntrees * (((size_t)1 << height) - 2)), sum);
+
+  mps_arena_park(arena);
+  mps_ap_destroy(ap);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_root_destroy(treeroot);
+  mps_root_destroy(stackroot);
+  mps_thread_dereg(thread);
+  mps_arena_destroy(arena);
+}
+
+
+/* Command-line options definitions.  See getopt_long(3). */
+
+static struct option longopts[] = {
+  {"help",             no_argument,       NULL, 'h'},
+  {"ntrees",           required_argument, NULL, 'n'},
+  {"height",           required_argument, NULL, 'e'},
+  {"nwords",           required_argument, NULL, 'w'},
+  {"ncollect",         required_argument, NULL, 'c'},
+  {"nlookups",         required_argument, NULL, 'l'},
+  {"depth",            required_argument, NULL, 'd'},
+  {"arena-size",       required_argument, NULL, 'm'},
+  {NULL,               0,                 NULL, 0  }
+};
+
+
+static struct {
+  const char *name;
+  mps_bool_t depthFirst;
+} tests[] = {
+  {"breadth", FALSE},
+  {"depth",   TRUE},
+};
+
+
+/* Command-line driver */
+
+int main(int argc, char *argv[])
+{
+  int ch;
+  unsigned i;
+
+  while ((ch = getopt_long(argc, argv, "hn:e:w:c:l:d:m:",
+                           longopts, NULL)) != -1)
+    switch (ch) {
+    case 'n':
+      ntrees = (size_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'e':
+      height = (unsigned)strtoul(optarg, NULL, 10);
+      break;
+    case 'w':
+      nwords = (size_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'c':
+      ncollect = (unsigned)strtoul(optarg, NULL, 10);
+      break;
+    case 'l':
+      nlookups = strtoul(optarg, NULL, 10);
+      break;
+    case 'd':
+      depth = strtoul(optarg, NULL, 10);
+      break;
+    case 'm': {
+        char *p;
+        arena_size = (unsigned)strtoul(optarg, &p, 10);
+        switch(toupper(*p)) {
+        case 'G': arena_size <<= 30; break;
+        case 'M': arena_size <<= 20; break;
+        case 'K': arena_size <<= 10; break;
+        case '\0': break;
+        default:
+          fprintf(stderr, "Bad arena size %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+      }
+      break;
+    default:
+      fprintf(stderr,
+              "Usage: %s [option...] [test...]\n"
+              "Options:\n"
+              "  -m n, --arena-size=n[KMG]?\n"
+              "    Initial size of arena (default %lu).\n"
+              "  -n n, --ntrees=n\n"
+              "    Number of trees (default %lu).\n"
+              "  -e n, --height=n\n"
+              "    Number of levels in each tree (default %u).\n"
+              "  -w n, --nwords=n\n"
+              "    Number of words in each node (default %lu).\n",
+              argv[0],
+              (unsigned long)arena_size,
+              (unsigned long)ntrees,
+              height,
+              (unsigned long)nwords);
+      fprintf(stderr,
+              "  -c n, --ncollect=n\n"
+              "    Collections before the lookups (default %u).\n"
+              "  -l n, --nlookups=n\n"
+              "    Number of lookups (default %lu).\n"
+              "  -d n, --depth=n\n"
+              "    Copy depth for the depth test (default %lu).\n"
+              "Tests:\n"
+              "  breadth  copy objects breadth-first\n"
+              "  depth    copy the children of each object next to it\n",
+              ncollect,
+              nlookups,
+              depth);
+      return EXIT_FAILURE;
+    }
+  argc -= optind;
+  argv += optind;
+
+  if (ntrees == 0 || height < 2 || height > 31 /* bits from rnd */
+      || nwords <= NODE_VALUE)
+  {
+    fprintf(stderr, "Bad arguments; try --help\n");
+    return EXIT_FAILURE;
+  }
+
+  trees = calloc(ntrees, sizeof trees[0]);
+  if (trees == NULL) {
+    fprintf(stderr, "Couldn't allocate roots\n");
+    return EXIT_FAILURE;
+  }
+
+  while (argc > 0) {
+    for (i = 0; i < NELEMS(tests); ++i)
+      if (strcmp(argv[0], tests[i].name) == 0)
+        goto found;
+    fprintf(stderr, "unknown test \"%s\"\n", argv[0]);
+    return EXIT_FAILURE;
+  found:
+    (void)mps_lib_assert_fail_install(assert_die);
+    memset(trees, 0, ntrees * sizeof trees[0]);
+    bench(tests[i].name, tests[i].depthFirst ? depth : 0);
+    --argc;
+    ++argv;
+  }
+
+  free(trees);
+  return EXIT_SUCCESS;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -780,6 +780,9 @@ void PoolClassMixInDebug(PoolClass klass)
   klass->init = DebugPoolInit;
   klass->alloc = DebugPoolAlloc;
   klass->free = DebugPoolFree;
+  /* Debugging needs the arena, for tags and fenceposts. */
+  klass->tryAlloc = PoolTrivTryAlloc;
+  klass->tryFree = PoolTrivTryFree;
 }
 
 
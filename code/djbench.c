@@ -55,9 +55,38 @@ static unsigned rmax = 10;        /* maximum recursion depth */
 static mps_bool_t zoned = TRUE;   /* arena allocates using zones */
 static size_t arena_size = 256ul * 1024 * 1024; /* arena size */
 static size_t arena_grain_size = 1; /* arena grain size */
+static unsigned sac_classes = 16; /* size classes in each cache */
+static mps_bool_t use_sac = FALSE; /* give each thread a cache */
+static size_t sac_table_limit = 0; /* cache lookup table limit */
+static mps_bool_t segregated_fit = FALSE; /* MVFF uses segregated fit */
+static mps_bool_t pool_lock = FALSE; /* MVFF has its own lock */
+static size_t unit_size = 0;      /* MFS unit size, or 0 if not MFS */
+static mps_word_t magazine_size = 0; /* MFS units in a magazine */
+
+
+/* sac_create -- create a cache with sac_classes evenly spaced classes */
+
+static mps_res_t sac_create(mps_sac_t *sac_o)
+{
+  mps_sac_class_s *classes = alloca(sizeof(classes[0]) * sac_classes);
+  unsigned i;
+  mps_res_t res;
+
+  for (i = 0; i < sac_classes; ++i) {
+    classes[i].mps_block_size = (i + 1) * 2 * MPS_PF_ALIGN;
+    classes[i].mps_cached_count = 64;
+    classes[i].mps_frequency = 1;
+  }
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_SAC_TABLE_LIMIT, sac_table_limit);
+    res = mps_sac_create_k(sac_o, pool, sac_classes, classes, args);
+  } MPS_ARGS_END(args);
+  return res;
+}
 
 #define DJRUN(fname, alloc, free) \
-  static unsigned fname##_inner(mps_ap_t ap, unsigned depth, unsigned r) { \
+  static unsigned fname##_inner(mps_ap_t ap, mps_sac_t sac, \
+                                unsigned depth, unsigned r) { \
     struct {void *p; size_t s;} *blocks = alloca(sizeof(blocks[0]) * nblocks); \
     unsigned j, k; \
     \
@@ -84,7 +113,7 @@ static size_t arena_grain_size = 1; /* arena grain size */
       } \
       if (rinter > 0 && depth > 0 && ++r % rinter == 0) { \
         /* putchar('>'); fflush(stdout); */ \
-        r = fname##_inner(ap, depth - 1, r); \
+        r = fname##_inner(ap, sac, depth - 1, r); \
         /* putchar('<'); fflush(stdout); */ \
       } \
     } \
@@ -101,10 +130,15 @@ static size_t arena_grain_size = 1; /* arena grain size */
   static void *fname(void *p) { \
     unsigned i; \
     mps_ap_t ap = NULL; \
-    if (pool != NULL) \
+    mps_sac_t sac = NULL; \
+    if (pool != NULL && unit_size == 0) \
       DJMUST(mps_ap_create_k(&ap, pool, mps_args_none)); \
+    if (pool != NULL && use_sac) \
+      DJMUST(sac_create(&sac)); \
     for (i = 0; i < niter; ++i) \
-      (void)fname##_inner(ap, rmax, 0); \
+      (void)fname##_inner(ap, sac, rmax, 0); \
+    if (sac != NULL) \
+      mps_sac_destroy(sac); \
     if (ap != NULL) \
       mps_ap_destroy(ap); \
     return p; \
@@ -127,6 +161,14 @@ DJRUN(dj_malloc, MALLOC_ALLOC, MALLOC_FREE)
 DJRUN(dj_alloc, MPS_ALLOC, MPS_FREE)
 
 
+/* mps_alloc/mps_free benchmark with fixed size blocks */
+
+#define MFS_ALLOC(p, s) do { mps_alloc(&p, pool, unit_size); } while(0)
+#define MFS_FREE(p, s)  do { mps_free(pool, p, unit_size); } while(0)
+
+DJRUN(dj_mfs, MFS_ALLOC, MFS_FREE)
+
+
 /* reserve/free benchmark */
 
 #define ALIGN_UP(s, a) (((s) + ((a) - 1)) & ~((a) - 1))
@@ -140,8 +182,151 @@ DJRUN(dj_alloc, MPS_ALLOC, MPS_FREE)
 
 DJRUN(dj_reserve, RESERVE_ALLOC, RESERVE_FREE)
 
+
+/* segregated allocation cache benchmark */
+
+#define SAC_ALLOC(p, s) \
+  do { \
+    mps_res_t _res; \
+    MPS_SAC_ALLOC_FAST(_res, p, sac, s, FALSE); \
+    (void)_res; \
+  } while(0)
+#define SAC_FREE(p, s) MPS_SAC_FREE_FAST(sac, p, s)
+
+DJRUN(dj_sac, SAC_ALLOC, SAC_FREE)
+
 typedef void *(*dj_t)(void *);
 
+
+/* Producer/consumer benchmark
+ *
+ * Each of nthreads producer threads allocates blocks from its own
+ * segregated allocation cache and passes them through a ring of
+ * nblocks slots to its own consumer thread, which frees them.  In
+ * pc_local the consumer frees blocks to a cache of its own, so they
+ * only get back to the producer's cache through the pool, under the
+ * arena lock.  In pc_remote the consumer frees them straight to the
+ * producer's cache with mps_sac_free_remote, without the lock.
+ */
+
+#define PC_CLASSES 8
+
+typedef struct pc_s {
+  mps_sac_t sac;                /* producer's cache */
+  mps_sac_t local;              /* consumer's cache, for pc_local */
+  void * volatile *slots;       /* ring of blocks being passed */
+  testthr_t producer, consumer;
+} pc_s, *pc_t;
+
+static unsigned long pc_count(void)
+{
+  return (unsigned long)niter * npass * nblocks;
+}
+
+static void *pc_produce(void *arg)
+{
+  pc_t pc = arg;
+  unsigned long n = pc_count();
+  unsigned k = 0, idle = 0;
+
+  while (n > 0) {
+    if (pc->slots[k] == NULL) {
+      size_t s = sizeof(void *) << (1 + rnd() % PC_CLASSES);
+      void *p;
+      mps_res_t sac_res;
+      s -= rnd() % (s / 2);
+      MPS_SAC_ALLOC_FAST(sac_res, p, pc->sac, s, FALSE);
+      DJMUST(sac_res);
+      *(size_t *)p = s;
+      cdie(ATOMIC_CAS_PTR(&pc->slots[k], NULL, p), "pc_produce");
+      --n;
+      idle = 0;
+    } else if (++idle == nblocks) {
+      testthr_yield();
+      idle = 0;
+    }
+    k = (k + 1) % nblocks;
+  }
+  return NULL;
+}
+
+#define PC_CONSUME(fname, free) \
+  static void *fname(void *arg) { \
+    pc_t pc = arg; \
+    unsigned long n = pc_count(); \
+    unsigned k = 0, idle = 0; \
+    \
+    while (n > 0) { \
+      void *p = pc->slots[k]; \
+      if (p != NULL && ATOMIC_CAS_PTR(&pc->slots[k], p, NULL)) { \
+        size_t s = *(size_t *)p; \
+        free(p, s); \
+        --n; \
+        idle = 0; \
+      } else if (++idle == nblocks) { \
+        testthr_yield(); \
+        idle = 0; \
+      } \
+      k = (k + 1) % nblocks; \
+    } \
+    return NULL; \
+  }
+
+#define LOCAL_FREE(p, s) MPS_SAC_FREE_FAST(pc->local, p, s)
+#define REMOTE_FREE(p, s) mps_sac_free_remote(pc->sac, p, s)
+
+PC_CONSUME(pc_local, LOCAL_FREE)
+PC_CONSUME(pc_remote, REMOTE_FREE)
+
+static void pc_wrap(dj_t dj, mps_pool_class_t pool_class, const char *name)
+{
+  pc_t pcs = alloca(sizeof(pcs[0]) * nthreads);
+  mps_sac_class_s classes[PC_CLASSES];
+  clock_t start, finish;
+  unsigned i, t;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, arena_size);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, arena_grain_size);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
+    DJMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
+  } MPS_ARGS_END(args);
+  DJMUST(mps_pool_create_k(&pool, arena, pool_class, mps_args_none));
+
+  for (i = 0; i < PC_CLASSES; ++i) {
+    classes[i].mps_block_size = sizeof(void *) << (1 + i);
+    classes[i].mps_cached_count = 64;
+    classes[i].mps_frequency = 1;
+  }
+  for (t = 0; t < nthreads; ++t) {
+    DJMUST(mps_sac_create(&pcs[t].sac, pool, PC_CLASSES, classes));
+    DJMUST(mps_sac_create(&pcs[t].local, pool, PC_CLASSES, classes));
+    pcs[t].slots = alloca(sizeof(pcs[t].slots[0]) * nblocks);
+    for (i = 0; i < nblocks; ++i)
+      pcs[t].slots[i] = NULL;
+  }
+
+  start = clock();
+  for (t = 0; t < nthreads; ++t) {
+    testthr_create(&pcs[t].producer, pc_produce, &pcs[t]);
+    testthr_create(&pcs[t].consumer, dj, &pcs[t]);
+  }
+  for (t = 0; t < nthreads; ++t) {
+    testthr_join(&pcs[t].producer, NULL);
+    testthr_join(&pcs[t].consumer, NULL);
+  }
+  finish = clock();
+
+  printf("%s: %g\n", name, (double)(finish - start) / CLOCKS_PER_SEC);
+
+  for (t = 0; t < nthreads; ++t) {
+    mps_sac_destroy(pcs[t].sac);
+    mps_sac_destroy(pcs[t].local);
+  }
+  mps_pool_destroy(pool);
+  mps_arena_destroy(arena);
+}
+
 static void weave(dj_t dj)
 {
   testthr_t *threads = alloca(sizeof(threads[0]) * nthreads);
@@ -190,13 +375,87 @@ static void arena_wrap(dj_t dj, mps_pool_class_t pool_class, const char *name)
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
     DJMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
   } MPS_ARGS_END(args);
-  DJMUST(mps_pool_create_k(&pool, arena, pool_class, mps_args_none));
+  MPS_ARGS_BEGIN(args) {
+    if (segregated_fit)
+      MPS_ARGS_ADD(args, MPS_KEY_MVFF_SEGREGATED_FIT, TRUE);
+    if (pool_lock)
+      MPS_ARGS_ADD(args, MPS_KEY_MVFF_POOL_LOCK, TRUE);
+    if (unit_size > 0)
+      MPS_ARGS_ADD(args, MPS_KEY_MFS_UNIT_SIZE, unit_size);
+    if (magazine_size > 0)
+      MPS_ARGS_ADD(args, MPS_KEY_MFS_MAGAZINE_SIZE, magazine_size);
+    DJMUST(mps_pool_create_k(&pool, arena, pool_class, args));
+  } MPS_ARGS_END(args);
   watch(dj, name);
   mps_pool_destroy(pool);
   mps_arena_destroy(arena);
 }
 
 
+/* Wrap a call to a dj benchmark that allocates through a segregated
+   allocation cache in each thread, without and with a lookup table */
+
+static void sac_wrap(dj_t dj, mps_pool_class_t pool_class, const char *name)
+{
+  use_sac = TRUE;
+  sac_table_limit = 0;
+  arena_wrap(dj, pool_class, name);
+  use_sac = FALSE;
+}
+
+static void sac_table_wrap(dj_t dj, mps_pool_class_t pool_class,
+                           const char *name)
+{
+  use_sac = TRUE;
+  sac_table_limit = (size_t)sac_classes * 2 * MPS_PF_ALIGN;
+  arena_wrap(dj, pool_class, name);
+  use_sac = FALSE;
+}
+
+
+/* Wrap a call to a dj benchmark on an MVFF pool that uses segregated
+   fit */
+
+static void segfit_wrap(dj_t dj, mps_pool_class_t pool_class,
+                        const char *name)
+{
+  segregated_fit = TRUE;
+  arena_wrap(dj, pool_class, name);
+  segregated_fit = FALSE;
+}
+
+
+/* Wrap a call to a dj benchmark on an MVFF pool that has its own lock
+   and so mostly allocates and frees without the arena lock */
+
+static void pool_lock_wrap(dj_t dj, mps_pool_class_t pool_class,
+                           const char *name)
+{
+  pool_lock = TRUE;
+  arena_wrap(dj, pool_class, name);
+  pool_lock = FALSE;
+}
+
+
+/* Wrap a call to a dj benchmark on an MFS pool of 8-word units,
+   without and with magazines */
+
+static void mfs_wrap(dj_t dj, mps_pool_class_t pool_class, const char *name)
+{
+  unit_size = 8 * sizeof(void *);
+  arena_wrap(dj, pool_class, name);
+  unit_size = 0;
+}
+
+static void magazine_wrap(dj_t dj, mps_pool_class_t pool_class,
+                          const char *name)
+{
+  magazine_size = 16;
+  mfs_wrap(dj, pool_class, name);
+  magazine_size = 0;
+}
+
+
 /* Command-line options definitions.  See getopt_long(3). */
 
 static struct option longopts[] = {
@@ -213,6 +472,7 @@ static struct option longopts[] = {
   {"arena-size",       required_argument, NULL, 'm'},
   {"arena-grain-size", required_argument, NULL, 'a'},
   {"arena-unzoned",    no_argument,       NULL, 'z'},
+  {"sac-classes",      required_argument, NULL, 'k'},
   {NULL,               0,                 NULL, 0  }
 };
 
@@ -232,9 +492,18 @@ static struct {
 } pools[] = {
   {"mvt",   arena_wrap, dj_reserve, mps_class_mvt},
   {"mvff",  arena_wrap, dj_reserve, mps_class_mvff},
+  {"mvffa", arena_wrap, dj_alloc,   mps_class_mvff}, /* mvff without buffers */
+  {"mvffsf", segfit_wrap, dj_alloc, mps_class_mvff},
+  {"mvffl", pool_lock_wrap, dj_alloc, mps_class_mvff},
+  {"mfs",   mfs_wrap,   dj_mfs,     mps_class_mfs},
+  {"mfsm",  magazine_wrap, dj_mfs,  mps_class_mfs},
   {"mv",    arena_wrap, dj_alloc,   mps_class_mv},
   {"mvb",   arena_wrap, dj_reserve, mps_class_mv}, /* mv with buffers */
   {"an",    wrap,       dj_malloc,  dummy_class},
+  {"mvffsac",  sac_wrap,       dj_sac, mps_class_mvff},
+  {"mvffsact", sac_table_wrap, dj_sac, mps_class_mvff},
+  {"mvffpc",  pc_wrap, pc_local,  mps_class_mvff},
+  {"mvffpcr", pc_wrap, pc_remote, mps_class_mvff},
 };
 
 
@@ -247,7 +516,7 @@ int main(int argc, char *argv[]) {
 
   seed = rnd_seed();
   
-  while ((ch = getopt_long(argc, argv, "ht:i:p:b:s:c:r:d:m:a:x:z", longopts, NULL)) != -1)
+  while ((ch = getopt_long(argc, argv, "ht:i:p:b:s:c:r:d:m:a:x:zk:", longopts, NULL)) != -1)
     switch (ch) {
     case 't':
       nthreads = (unsigned)strtoul(optarg, NULL, 10);
@@ -280,6 +549,9 @@ int main(int argc, char *argv[]) {
     case 'z':
       zoned = FALSE;
       break;
+    case 'k':
+      sac_classes = (unsigned)strtoul(optarg, NULL, 10);
+      break;
     case 'm': {
         char *p;
         arena_size = (unsigned)strtoul(optarg, &p, 10);
@@ -346,15 +618,29 @@ int main(int argc, char *argv[]) {
               "    Random number seed (default from entropy).\n"
               "  -z, --arena-unzoned\n"
               "    Disabled zoned allocation in the arena\n"
-              "Tests:\n"
-              "  mvt   pool class MVT\n"
-              "  mvff  pool class MVFF\n"
-              "  mv    pool class MV\n"
-              "  mvb   pool class MV with buffers\n"
-              "  an    malloc\n",
+              "  -k n, --sac-classes=n\n"
+              "    Size classes in each cache (default %u).\n",
               pact,
               rinter,
-              rmax);
+              rmax,
+              sac_classes);
+      fprintf(stderr,
+              "Tests:\n"
+              "  mvt      pool class MVT\n"
+              "  mvff     pool class MVFF\n"
+              "  mvffa    pool class MVFF without buffers\n"
+              "  mvffsf   the same, with segregated fit\n"
+              "  mvffl    the same, with a pool lock\n"
+              "  mv       pool class MV\n"
+              "  mvb      pool class MV with buffers\n"
+              "  an       malloc\n");
+      fprintf(stderr,
+              "  mfs      pool class MFS, 8-word blocks\n"
+              "  mfsm     the same, with magazines\n"
+              "  mvffsac  pool class MVFF, through caches\n"
+              "  mvffsact the same, looking up size classes in a table\n"
+              "  mvffpc   pool class MVFF, freeing on other threads\n"
+              "  mvffpcr  the same, freeing remotely\n");
       return EXIT_FAILURE;
     }
   argc -= optind;
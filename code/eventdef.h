@@ -37,7 +37,7 @@
 
 #define EVENT_VERSION_MAJOR  ((unsigned)1)
 #define EVENT_VERSION_MEDIAN ((unsigned)6)
-#define EVENT_VERSION_MINOR  ((unsigned)1)
+#define EVENT_VERSION_MINOR  ((unsigned)4)
 
 
 /* EVENT_LIST -- list of event types and general properties
@@ -67,7 +67,7 @@
  */
  
 #define EventNameMAX ((size_t)19)
-#define EventCodeMAX ((EventCode)0x0088)
+#define EventCodeMAX ((EventCode)0x008B)
 
 #define EVENT_LIST(EVENT, X) \
   /*       0123456789012345678 <- don't exceed without changing EventNameMAX */ \
@@ -194,7 +194,10 @@
   EVENT(X, ArenaUseFreeZone   , 0x0085,  TRUE, Arena) \
   /* EVENT(X, ArenaBlacklistZone , 0x0086,  TRUE, Arena) */ \
   EVENT(X, PauseTimeSet       , 0x0087,  TRUE, Arena) \
-  EVENT(X, TraceEndGen        , 0x0088,  TRUE, Trace)
+  EVENT(X, TraceEndGen        , 0x0088,  TRUE, Trace) \
+  EVENT(X, ShieldFlush        , 0x0089,  TRUE, Arena) \
+  EVENT(X, ArenaCollectorStep , 0x008A,  TRUE, Arena) \
+  EVENT(X, AMCFill            , 0x008B,  TRUE, Pool)
 
 
 /* Remember to update EventNameMAX and EventCodeMAX above! 
@@ -735,6 +738,22 @@
   PARAM(X,  4, W, preservedInPlace) /* bytes preserved in generation */ \
   PARAM(X,  5, D, mortality)    /* updated mortality */
 
+#define EVENT_ShieldFlush_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena)        /* the arena */ \
+  PARAM(X,  1, W, segs)         /* segments whose protection changed */ \
+  PARAM(X,  2, W, calls)        /* calls to ProtSet */
+
+#define EVENT_ArenaCollectorStep_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, arena) \
+  PARAM(X,  1, W, start) \
+  PARAM(X,  2, B, workWasDone)
+
+#define EVENT_AMCFill_PARAMS(PARAM, X) \
+  PARAM(X,  0, P, amc)          /* the pool */ \
+  PARAM(X,  1, P, buffer)       /* the buffer being filled */ \
+  PARAM(X,  2, W, fillSize)     /* segment size for small fills */ \
+  PARAM(X,  3, W, interval)     /* clock ticks since previous fill */
+
 
 #endif /* eventdef_h */
 
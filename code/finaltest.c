@@ -45,6 +45,7 @@
 
 #include <math.h> /* HUGE_VAL */
 #include <stdio.h> /* fflush, printf, stdout */
+#include <string.h> /* memset */
 
 enum {
   ModePARK,                     /* .mode.park */
@@ -99,6 +100,35 @@ static void register_numbered_tree(mps_word_t tree, mps_arena_t arena)
     }
 }
 
+static mps_addr_t batch[1 << maxtreeDEPTH];
+
+/* collect_numbered_tree -- store the objects of a numbered tree
+ *
+ * Stores the addresses of the objects in a numbered tree in batch,
+ * starting at index count, and returns the index after the last one.
+ */
+
+static size_t collect_numbered_tree(mps_word_t tree, size_t count)
+{
+    /* don't finalize ints */
+    if ((tree & 1) == 0) {
+        Insist(count < NELEMS(batch));
+        batch[count++] = (mps_addr_t)tree;
+        count = collect_numbered_tree(DYLAN_VECTOR_SLOT(tree, 0), count);
+        count = collect_numbered_tree(DYLAN_VECTOR_SLOT(tree, 1), count);
+    }
+    return count;
+}
+
+/* register_batched_tree -- register a numbered tree in one call */
+
+static void register_batched_tree(mps_word_t tree, mps_arena_t arena)
+{
+    size_t count = collect_numbered_tree(tree, 0);
+    die(mps_finalize_many(arena, batch, count), "mps_finalize_many");
+    memset(batch, 0, sizeof batch);
+}
+
 static mps_word_t make_indirect_cons(mps_word_t car, mps_word_t cdr,
                                      mps_ap_t ap)
 {
@@ -144,7 +174,8 @@ static void *root[rootCOUNT];
 static void test_trees(int mode, const char *name, mps_arena_t arena,
                        mps_pool_t pool, mps_ap_t ap,
                        mps_word_t (*make)(mps_word_t, mps_ap_t),
-                       void (*reg)(mps_word_t, mps_arena_t))
+                       void (*reg)(mps_word_t, mps_arena_t),
+                       mps_bool_t batched)
 {
   size_t collections = 0;
   size_t finals = 0;
@@ -199,6 +230,14 @@ static void test_trees(int mode, const char *name, mps_arena_t arena,
       Insist(free_size <= total_size);
       Insist(free_size + live_size <= total_size);
     }
+    if (batched) {
+      mps_addr_t refs[16];
+      size_t got;
+      do {
+        got = mps_message_get_finalization_refs(arena, refs, NELEMS(refs));
+        final_this_time += got;
+      } while (got == NELEMS(refs));
+    }
     while (mps_message_queue_type(&type, arena)) {
       mps_message_t message;
       cdie(mps_message_get(&message, arena, type), "message_get");
@@ -255,9 +294,11 @@ static void test_pool(int mode, mps_arena_t arena, mps_chain_t chain,
   die(mps_ap_create(&ap, pool, mps_rank_exact()), "ap_create\n");
 
   test_trees(mode, "numbered", arena, pool, ap, make_numbered_tree,
-             register_numbered_tree);
+             register_numbered_tree, FALSE);
   test_trees(mode, "indirect", arena, pool, ap, make_indirect_tree,
-             register_indirect_tree);
+             register_indirect_tree, FALSE);
+  test_trees(mode, "batched", arena, pool, ap, make_numbered_tree,
+             register_batched_tree, TRUE);
 
   mps_ap_destroy(ap);
   mps_root_destroy(mps_root);
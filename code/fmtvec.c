@@ -0,0 +1,203 @@
+/* fmtvec.c: VECTOR OBJECT FORMAT IMPLEMENTATION
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * .readership: MPS developers
+ *
+ * .layout: An object is a vector of words. The first word is a header
+ * that gives the size of the object in words, shifted left by two,
+ * with the object's type in the bottom two bits. In a VEC_REFS
+ * object, every other word is a reference, NULL, or a small integer
+ * (which is not an address in the arena, so the collector ignores
+ * it). In a VEC_LEAF object, the other words are data that the
+ * collector never looks at. A forwarded object keeps its size in its
+ * header and has its new address in its second word, so objects are
+ * at least VEC_MIN_WORDS long. A padding object may be a single word.
+ *
+ * .scan-part: vec_scan_part scans part of a VEC_REFS object, so
+ * that pools can suspend and resume the scan of a huge object (see
+ * <design/poolamc/#suspend.part>). It is not included in the format
+ * made by vec_fmt; tests that want it pass it to mps_fmt_create_k
+ * with MPS_KEY_FMT_SCAN_PART.
+ */
+
+#include "fmtvec.h"
+#include "mps.h"
+#include "testlib.h"
+
+
+mps_res_t vec_scan(mps_ss_t ss, mps_addr_t base, mps_addr_t limit)
+{
+  MPS_SCAN_BEGIN(ss) {
+    while (base < limit) {
+      mps_word_t *p = base;
+      size_t words = VEC_WORDS(p[0]);
+      if (VEC_TYPE(p[0]) == VEC_REFS) {
+        size_t i;
+        for (i = 1; i < words; ++i) {
+          mps_addr_t ref = (mps_addr_t)p[i];
+          if (MPS_FIX1(ss, ref)) {
+            mps_res_t res = MPS_FIX2(ss, &ref);
+            if (res != MPS_RES_OK)
+              return res;
+            p[i] = (mps_word_t)ref;
+          }
+        }
+      }
+      base = p + words;
+    }
+  } MPS_SCAN_END(ss);
+  return MPS_RES_OK;
+}
+
+
+mps_res_t vec_scan_part(mps_ss_t ss, mps_addr_t obj,
+                        mps_addr_t base, mps_addr_t limit)
+{
+  mps_word_t *p = obj;
+  mps_word_t *q = base;
+
+  if (VEC_TYPE(p[0]) != VEC_REFS)
+    return MPS_RES_OK;
+  if (q < p + 1)
+    q = p + 1;
+  MPS_SCAN_BEGIN(ss) {
+    for (; q < (mps_word_t *)limit; ++q) {
+      mps_addr_t ref = (mps_addr_t)*q;
+      if (MPS_FIX1(ss, ref)) {
+        mps_res_t res = MPS_FIX2(ss, &ref);
+        if (res != MPS_RES_OK)
+          return res;
+        *q = (mps_word_t)ref;
+      }
+    }
+  } MPS_SCAN_END(ss);
+  return MPS_RES_OK;
+}
+
+
+mps_addr_t vec_skip(mps_addr_t obj)
+{
+  mps_word_t *p = obj;
+  return p + VEC_WORDS(p[0]);
+}
+
+
+void vec_fwd(mps_addr_t old, mps_addr_t new)
+{
+  mps_word_t *p = old;
+  Insist(VEC_WORDS(p[0]) >= VEC_MIN_WORDS);
+  p[0] = VEC_HEADER(VEC_WORDS(p[0]), VEC_FWD);
+  p[1] = (mps_word_t)new;
+}
+
+
+mps_addr_t vec_isfwd(mps_addr_t obj)
+{
+  mps_word_t *p = obj;
+  if (VEC_TYPE(p[0]) != VEC_FWD)
+    return NULL;
+  return (mps_addr_t)p[1];
+}
+
+
+void vec_pad(mps_addr_t addr, size_t size)
+{
+  mps_word_t *p = addr;
+  Insist(size >= sizeof(mps_word_t));
+  Insist(size % sizeof(mps_word_t) == 0);
+  p[0] = VEC_HEADER(size / sizeof(mps_word_t), VEC_PAD);
+}
+
+
+/* vec_fmt -- create a vector format without vec_scan_part */
+
+mps_res_t vec_fmt(mps_fmt_t *fmtReturn, mps_arena_t arena)
+{
+  mps_res_t res;
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_ALIGN, VEC_ALIGN);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_SCAN, vec_scan);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_SKIP, vec_skip);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_FWD, vec_fwd);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_ISFWD, vec_isfwd);
+    MPS_ARGS_ADD(args, MPS_KEY_FMT_PAD, vec_pad);
+    res = mps_fmt_create_k(fmtReturn, arena, args);
+  } MPS_ARGS_END(args);
+  return res;
+}
+
+
+/* make_vec -- allocate a vector
+ *
+ * The references in a VEC_REFS object are NULL. The data in a VEC_LEAF
+ * object is not initialized, so that benchmarks that allocate leaves
+ * measure only the allocation.
+ */
+
+mps_res_t make_vec(mps_word_t **objReturn, mps_ap_t ap,
+                   size_t words, unsigned type)
+{
+  size_t size = words * sizeof(mps_word_t);
+  mps_addr_t addr;
+  mps_word_t *p;
+  size_t i;
+
+  Insist(words >= VEC_MIN_WORDS);
+  Insist(type == VEC_REFS || type == VEC_LEAF);
+  do {
+    mps_res_t res = mps_reserve(&addr, ap, size);
+    if (res != MPS_RES_OK)
+      return res;
+    p = addr;
+    p[0] = VEC_HEADER(words, type);
+    if (type == VEC_REFS)
+      for (i = 1; i < words; ++i)
+        p[i] = 0;
+  } while (!mps_commit(ap, addr, size));
+  *objReturn = p;
+  return MPS_RES_OK;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,82 @@
+/* fmtvec.h: VECTOR OBJECT FORMAT INTERFACE
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * A simple object format for test cases and benchmarks that need to
+ * control the size and layout of their objects. See fmtvec.c.
+ */
+
+#ifndef fmtvec_h
+#define fmtvec_h
+
+#include "mps.h"
+
+/* Object types. These go in the bottom two bits of the header. */
+
+enum {
+  VEC_REFS,             /* words after the header are references */
+  VEC_LEAF,             /* words after the header are data */
+  VEC_FWD,              /* forwarded object: new address in word 1 */
+  VEC_PAD               /* padding */
+};
+
+#define VEC_HEADER(words, type) (((mps_word_t)(words) << 2) | (type))
+#define VEC_WORDS(header)       ((size_t)((header) >> 2))
+#define VEC_TYPE(header)        ((unsigned)((header) & 3))
+#define VEC_ALIGN               sizeof(mps_word_t)
+#define VEC_MIN_WORDS           2 /* room for a forwarding pointer */
+
+extern mps_res_t vec_scan(mps_ss_t, mps_addr_t, mps_addr_t);
+extern mps_res_t vec_scan_part(mps_ss_t, mps_addr_t, mps_addr_t, mps_addr_t);
+extern mps_addr_t vec_skip(mps_addr_t);
+extern void vec_fwd(mps_addr_t, mps_addr_t);
+extern mps_addr_t vec_isfwd(mps_addr_t);
+extern void vec_pad(mps_addr_t, size_t);
+extern mps_res_t vec_fmt(mps_fmt_t *, mps_arena_t);
+
+extern mps_res_t make_vec(mps_word_t **, mps_ap_t, size_t, unsigned);
+
+#endif /* fmtvec_h */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -28,6 +28,7 @@ Bool FormatCheck(Format format)
      check that this alignment is not greater than that, as well as all other
      alignments. */
   CHECKL(FUNCHECK(format->scan));
+  CHECKL(format->scanPart == NULL || FUNCHECK(format->scanPart));
   CHECKL(FUNCHECK(format->skip));
   CHECKL(FUNCHECK(format->move));
   CHECKL(FUNCHECK(format->isMoved));
@@ -90,6 +91,7 @@ static mps_addr_t FormatDefaultClass(mps_addr_t object)
 
 ARG_DEFINE_KEY(FMT_ALIGN, Align);
 ARG_DEFINE_KEY(FMT_SCAN, Fun);
+ARG_DEFINE_KEY(FMT_SCAN_PART, Fun);
 ARG_DEFINE_KEY(FMT_SKIP, Fun);
 ARG_DEFINE_KEY(FMT_FWD, Fun);
 ARG_DEFINE_KEY(FMT_ISFWD, Fun);
@@ -106,6 +108,7 @@ Res FormatCreate(Format *formatReturn, Arena arena, ArgList args)
   Align fmtAlign = FMT_ALIGN_DEFAULT;
   Size fmtHeaderSize = FMT_HEADER_SIZE_DEFAULT;
   mps_fmt_scan_t fmtScan = FMT_SCAN_DEFAULT;
+  mps_fmt_scan_part_t fmtScanPart = FMT_SCAN_PART_DEFAULT;
   mps_fmt_skip_t fmtSkip = FMT_SKIP_DEFAULT;
   mps_fmt_fwd_t fmtFwd = FMT_FWD_DEFAULT;
   mps_fmt_isfwd_t fmtIsfwd = FMT_ISFWD_DEFAULT;
@@ -122,6 +125,8 @@ Res FormatCreate(Format *formatReturn, Arena arena, ArgList args)
     fmtHeaderSize = arg.val.size;
   if (ArgPick(&arg, args, MPS_KEY_FMT_SCAN))
     fmtScan = arg.val.fmt_scan;
+  if (ArgPick(&arg, args, MPS_KEY_FMT_SCAN_PART))
+    fmtScanPart = arg.val.fmt_scan_part;
   if (ArgPick(&arg, args, MPS_KEY_FMT_SKIP))
     fmtSkip = arg.val.fmt_skip;
   if (ArgPick(&arg, args, MPS_KEY_FMT_FWD))
@@ -144,6 +149,7 @@ Res FormatCreate(Format *formatReturn, Arena arena, ArgList args)
   format->alignment = fmtAlign;
   format->headerSize = fmtHeaderSize;
   format->scan = fmtScan;
+  format->scanPart = fmtScanPart;
   format->skip = fmtSkip;
   format->move = fmtFwd;
   format->isMoved = fmtIsfwd;
@@ -221,6 +227,30 @@ Res FormatScan(Format format, ScanState ss, Addr base, Addr limit)
 }
 
 
+/* FormatScanPart -- scan part of a formatted object for references
+ *
+ * Scans the references in the object obj that are stored at addresses
+ * in [base, limit), which must lie within the object.  This lets a
+ * pool divide the scanning of a very large object into several
+ * increments.  See <design/scan/#suspend.part>.
+ */
+
+Res FormatScanPart(Format format, ScanState ss, Addr obj,
+                   Addr base, Addr limit)
+{
+  AVERT_CRITICAL(Format, format);
+  AVERT_CRITICAL(ScanState, ss);
+  AVER_CRITICAL(FormatCanScanPart(format));
+  AVER_CRITICAL(obj != NULL);
+  AVER_CRITICAL(base != NULL);
+  AVER_CRITICAL(base < limit);
+
+  ss->scannedSize += AddrOffset(base, limit);
+
+  return format->scanPart(&ss->ss_s, obj, base, limit);
+}
+
+
 /* FormatDescribe -- describe a format */
 
 Res FormatDescribe(Format format, mps_lib_FILE *stream, Count depth)
@@ -234,6 +264,7 @@ Res FormatDescribe(Format format, mps_lib_FILE *stream, Count depth)
                "  poolCount $U\n", (WriteFU)format->poolCount,
                "  alignment $W\n", (WriteFW)format->alignment,
                "  scan $F\n", (WriteFF)format->scan,
+               "  scanPart $F\n", (WriteFF)(void (*)(void))format->scanPart,
                "  skip $F\n", (WriteFF)format->skip,
                "  move $F\n", (WriteFF)format->move,
                "  isMoved $F\n", (WriteFF)format->isMoved,
@@ -20,9 +20,13 @@
 #endif
 
 #include <stdio.h> /* fprintf, printf, putchars, sscanf, stderr, stdout */
-#include <stdlib.h> /* alloca, exit, EXIT_FAILURE, EXIT_SUCCESS, strtoul */
+#include <stdlib.h> /* alloca, exit, EXIT_FAILURE, EXIT_SUCCESS, free, malloc, strtoul */
 #include <time.h> /* clock, CLOCKS_PER_SEC */
 
+#ifndef MPS_OS_W3
+#include <sys/time.h> /* gettimeofday */
+#endif
+
 #define RESMUST(expr) \
   do { \
     mps_res_t res = (expr); \
@@ -56,51 +60,118 @@ static size_t arena_grain_size = 1; /* arena grain size */
 static unsigned pinleaf = FALSE;  /* are leaf objects pinned at start */
 static mps_bool_t zoned = TRUE;   /* arena allocates using zones */
 static double pause_time = ARENA_DEFAULT_PAUSE_TIME; /* maximum pause time */
+static mps_bool_t soft_barrier = FALSE; /* client calls write barrier */
+static mps_bool_t background = FALSE; /* background collector thread */
+static mps_bool_t histogram = FALSE; /* record pause histogram */
+static size_t old_size = 0;       /* size of long-lived data */
+static size_t area_size = 8ul * 1024 * 1024; /* size of ambiguous area */
 
 typedef struct gcthread_s *gcthread_t;
 
 typedef void *(*gcthread_fn_t)(gcthread_t thread);
 
+/* Pause histogram: bucket i counts gaps of [2^i, 2^(i+1)) microseconds
+ * between successive mutator operations, except that the last bucket
+ * counts all longer gaps too.  See tick. */
+#define histLIMIT 24
+
 struct gcthread_s {
     testthr_t thread;
     mps_thr_t mps_thread;
     mps_root_t reg_root;
     mps_ap_t ap;
     gcthread_fn_t fn;
+    double last;                  /* time of last mutator operation */
+    unsigned long hist[histLIMIT]; /* pause histogram */
 };
 
+static unsigned long hist[histLIMIT]; /* pause histogram for all threads */
+
 typedef mps_word_t obj_t;
 
-static obj_t mkvector(mps_ap_t ap, size_t n) {
+
+/* now -- wall clock time in seconds
+ *
+ * This is wall clock time rather than processor time, since the point
+ * is to see how long a mutator thread is held up, whether that's by
+ * doing collection work itself or by waiting for the arena lock.
+ */
+
+static double now(void)
+{
+#ifdef MPS_OS_W3
+  LARGE_INTEGER count, freq;
+  QueryPerformanceCounter(&count);
+  QueryPerformanceFrequency(&freq);
+  return (double)count.QuadPart / (double)freq.QuadPart;
+#else
+  struct timeval tv;
+  (void)gettimeofday(&tv, NULL);
+  return (double)tv.tv_sec + (double)tv.tv_usec / 1e6;
+#endif
+}
+
+
+/* tick -- note a mutator operation, for the pause histogram
+ *
+ * The gap since the previous operation is the time the mutator was
+ * held up: in the allocation slow path, handling a barrier hit, or
+ * waiting for the arena lock.  Gaps under a microsecond are ordinary
+ * mutator work and aren't recorded.
+ */
+
+static void tick(gcthread_t thread)
+{
+  double t = now();
+  double gap = (t - thread->last) * 1e6;
+  unsigned i;
+
+  thread->last = t;
+  if (gap < 1.0)
+    return;
+  for (i = 0; i < histLIMIT - 1 && gap >= 2.0; ++i)
+    gap /= 2.0;
+  ++ thread->hist[i];
+}
+
+static obj_t mkvector(gcthread_t thread, size_t n) {
   mps_word_t v;
-  RESMUST(make_dylan_vector(&v, ap, n));
+  if (histogram)
+    tick(thread);
+  RESMUST(make_dylan_vector(&v, thread->ap, n));
   return v;
 }
 
-static obj_t aref(obj_t v, size_t i) {
+static obj_t aref(gcthread_t thread, obj_t v, size_t i) {
+  if (histogram)
+    tick(thread);
   return DYLAN_VECTOR_SLOT(v, i);
 }
 
-static void aset(obj_t v, size_t i, obj_t val) {
+static void aset(gcthread_t thread, obj_t v, size_t i, obj_t val) {
+  if (histogram)
+    tick(thread);
   DYLAN_VECTOR_SLOT(v, i) = val;
+  if (soft_barrier)
+    mps_write_barrier(arena, (mps_addr_t)v);
 }
 
 /* mktree - make a tree of nodes with depth d. */
-static obj_t mktree(mps_ap_t ap, unsigned d, obj_t leaf) {
+static obj_t mktree(gcthread_t thread, unsigned d, obj_t leaf) {
   obj_t tree;
   size_t i;
   if (d <= 0)
     return leaf;
-  tree = mkvector(ap, width);
+  tree = mkvector(thread, width);
   for (i = 0; i < width; ++i) {
-    aset(tree, i, mktree(ap, d - 1, leaf));
+    aset(thread, tree, i, mktree(thread, d - 1, leaf));
   }
   return tree;
 }
 
-static obj_t random_subtree(obj_t tree, unsigned levels) {
+static obj_t random_subtree(gcthread_t thread, obj_t tree, unsigned levels) {
   while(tree != objNULL && levels > 0) {
-    tree = aref(tree, rnd() % width);
+    tree = aref(thread, tree, rnd() % width);
     --levels;
   }
   return tree;
@@ -114,17 +185,17 @@ static obj_t random_subtree(obj_t tree, unsigned levels) {
  * NOTE: Changing preuse will dramatically change how much work
  * is done.  In particular, if preuse==1, the old tree is returned
  * unchanged. */
-static obj_t new_tree(mps_ap_t ap, obj_t oldtree, unsigned d) {
+static obj_t new_tree(gcthread_t thread, obj_t oldtree, unsigned d) {
   obj_t subtree;
   size_t i;
   if (rnd_double() < preuse) {
-    subtree = random_subtree(oldtree, depth - d);
+    subtree = random_subtree(thread, oldtree, depth - d);
   } else {
     if (d == 0)
       return objNULL;
-    subtree = mkvector(ap, width);
+    subtree = mkvector(thread, width);
     for (i = 0; i < width; ++i) {
-      aset(subtree, i, new_tree(ap, oldtree, d - 1));
+      aset(thread, subtree, i, new_tree(thread, oldtree, d - 1));
     }
   }
   return subtree;
@@ -133,42 +204,120 @@ static obj_t new_tree(mps_ap_t ap, obj_t oldtree, unsigned d) {
 /* Update tree to be identical tree but with nodes reallocated
  * with probability pupdate.  This avoids writing to vector slots
  * if unecessary. */
-static obj_t update_tree(mps_ap_t ap, obj_t oldtree, unsigned d) {
+static obj_t update_tree(gcthread_t thread, obj_t oldtree, unsigned d) {
   obj_t tree;
   size_t i;
   if (oldtree == objNULL || d == 0)
     return oldtree;
   if (rnd_double() < pupdate) {
-    tree = mkvector(ap, width);
+    /* The ambiguous reference to oldtree on the stack pins it while
+       the new node is filled in.  Without the volatile copy, the
+       compiler may keep only the offset from tree to oldtree in a
+       register, and then oldtree may move. */
+    volatile obj_t old = oldtree;
+    tree = mkvector(thread, width);
     for (i = 0; i < width; ++i) {
-      aset(tree, i, update_tree(ap, aref(oldtree, i), d - 1));
+      aset(thread, tree, i, update_tree(thread, aref(thread, old, i),
+                                        d - 1));
     }
   } else {
     tree = oldtree;
     for (i = 0; i < width; ++i) {
-      obj_t oldsubtree = aref(oldtree, i);
-      obj_t subtree = update_tree(ap, oldsubtree, d - 1);
+      obj_t oldsubtree = aref(thread, oldtree, i);
+      obj_t subtree = update_tree(thread, oldsubtree, d - 1);
       if (subtree != oldsubtree) {
-        aset(tree, i, subtree);
+        aset(thread, tree, i, subtree);
       }
     }
   }
   return tree;
 }
 
+/* mkold -- make a list of about old_size bytes of long-lived data
+ *
+ * The list is allocated directly in the dynamic generation (AMC
+ * honours MPS_KEY_GEN on the allocation point), and refers to nothing
+ * younger, so nursery collections need not scan it.  Comparing runs
+ * with different --old sizes shows how the cost of a nursery
+ * collection depends on the size of the old generation.
+ */
+
+static obj_t mkold(gcthread_t thread) {
+  mps_ap_t ap;
+  obj_t list = objNULL;
+  size_t size = 0;
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_GEN, ngen > 0 ? ngen : 2);
+    RESMUST(mps_ap_create_k(&ap, pool, args));
+  } MPS_ARGS_END(args);
+  while (size < old_size) {
+    mps_word_t v;
+    RESMUST(make_dylan_vector(&v, ap, width));
+    aset(thread, v, 0, list);
+    list = v;
+    size += (width + 2) * sizeof(mps_word_t);
+  }
+  mps_ap_destroy(ap);
+  return list;
+}
+
 static void *gc_tree(gcthread_t thread) {
   unsigned i, j;
-  mps_ap_t ap = thread->ap;
-  obj_t leaf = pinleaf ? mktree(ap, 1, objNULL) : objNULL;
+  obj_t leaf = pinleaf ? mktree(thread, 1, objNULL) : objNULL;
+  volatile obj_t old = old_size > 0 ? mkold(thread) : objNULL;
   for (i = 0; i < niter; ++i) {
-    obj_t tree = mktree(ap, depth, leaf);
+    obj_t tree = mktree(thread, depth, leaf);
     for (j = 0 ; j < npass; ++j) {
       if (preuse < 1.0)
-        tree = new_tree(ap, tree, depth);
+        tree = new_tree(thread, tree, depth);
       if (pupdate > 0.0)
-        tree = update_tree(ap, tree, depth);
+        tree = update_tree(thread, tree, depth);
     }
   }
+  (void)old; /* keep the long-lived data alive until here */
+  return NULL;
+}
+
+/* gc_area -- time scanning a large ambiguous area
+ *
+ * The area is filled with a random mixture of small integers and
+ * addresses outside the arena, as a thread stack might be, and
+ * registered as an ambiguous root scanned by mps_scan_area.  Each full collection scans
+ * it once, and the heap is only a small tree, so the time per
+ * collection is dominated by MPS_SCAN_AREA.
+ */
+
+static void *gc_area(gcthread_t thread) {
+  size_t i, nwords = area_size / sizeof(mps_word_t);
+  mps_word_t *area = malloc(nwords * sizeof(mps_word_t));
+  volatile obj_t tree = mktree(thread, 10, objNULL);
+  mps_root_t root;
+  double begin, seconds;
+
+  if (area == NULL) {
+    fprintf(stderr, "unable to allocate %lu byte area\n",
+            (unsigned long)area_size);
+    exit(EXIT_FAILURE);
+  }
+  for (i = 0; i < nwords; ++i) {
+    if (rnd() % 2 == 0)
+      area[i] = (mps_word_t)rnd();
+    else
+      area[i] = (mps_word_t)&area[rnd() % nwords];
+  }
+  RESMUST(mps_root_create_area(&root, arena, mps_rank_ambig(), 0,
+                               area, area + nwords, mps_scan_area, NULL));
+  begin = now();
+  for (i = 0; i < niter; ++i)
+    RESMUST(mps_arena_collect(arena));
+  seconds = now() - begin;
+  mps_arena_release(arena);
+  printf("area: %u collections scanning %lu bytes in %g seconds"
+         " (%g bytes/second)\n", niter, (unsigned long)area_size,
+         seconds, (double)niter * (double)area_size / seconds);
+  mps_root_destroy(root);
+  free(area);
+  (void)tree; /* keep the tree alive so that there is something to collect */
   return NULL;
 }
 
@@ -176,11 +325,17 @@ static void *gc_tree(gcthread_t thread) {
 static void *start(void *p) {
   gcthread_t thread = p;
   void *marker;
+  unsigned i;
+  for (i = 0; i < histLIMIT; ++i)
+    thread->hist[i] = 0;
+  thread->last = now();
   RESMUST(mps_thread_reg(&thread->mps_thread, arena));
   RESMUST(mps_root_create_thread(&thread->reg_root, arena,
                                  thread->mps_thread, &marker));
   RESMUST(mps_ap_create_k(&thread->ap, pool, mps_args_none));
   thread->fn(thread);
+  if (histogram)
+    tick(thread); /* include any pause at the end */
   mps_ap_destroy(thread->ap);
   mps_root_destroy(thread->reg_root);
   mps_thread_dereg(thread->mps_thread);
@@ -198,16 +353,24 @@ static void weave(gcthread_fn_t fn)
     testthr_create(&thread->thread, start, thread);
   }
   
-  for (t = 0; t < nthreads; ++t)
+  for (t = 0; t < nthreads; ++t) {
+    unsigned i;
     testthr_join(&threads[t].thread, NULL);
+    for (i = 0; i < histLIMIT; ++i)
+      hist[i] += threads[t].hist[i];
+  }
 }
 
 static void weave1(gcthread_fn_t fn)
 {
   gcthread_t thread = alloca(sizeof(thread[0]));
   
+  unsigned i;
+  
   thread->fn = fn;
   start(thread);
+  for (i = 0; i < histLIMIT; ++i)
+    hist[i] += thread->hist[i];
 }
 
 
@@ -226,19 +389,68 @@ static void watch(gcthread_fn_t fn, const char *name)
 }
 
 
+/* report -- report collector throughput
+ *
+ * The arena accumulates the tracing work it has done and the time
+ * spent doing it (see ArenaAccumulateTime), so the ratio is the
+ * collector's throughput in bytes per second. Comparing this figure
+ * across runs with different --old sizes shows how the cost of a
+ * collection depends on the amount of long-lived data.
+ *
+ * The collector traces on one thread, whatever --nthreads says:
+ * --nthreads varies the number of mutator threads, which changes how
+ * often the collector runs but not how fast it traces, so this figure
+ * is not a measure of parallel tracing (see <design/trace/#scan.single>).
+ */
+
+static void report(const char *name)
+{
+  double work = arena->tracedWork, seconds = arena->tracedTime;
+  Epoch collections = ArenaHistory(arena)->epoch;
+  printf("%s: traced %.0f bytes in %g seconds", name, work, seconds);
+  if (seconds > 0.0)
+    printf(" (%g bytes/second)", work / seconds);
+  putchar('\n');
+
+  /* Each collection that may move objects advances the location
+     dependency epoch, so this only counts collections in AMC. */
+  if (collections > 0)
+    printf("%s: %lu collections (%g seconds each)\n", name,
+           (unsigned long)collections, seconds / (double)collections);
+
+  if (histogram) {
+    unsigned i;
+    for (i = 0; i < histLIMIT; ++i)
+      if (hist[i] > 0) {
+        printf("%s: pauses in [%lu, ", name, 1ul << i);
+        if (i + 1 < histLIMIT)
+          printf("%lu", 1ul << (i + 1));
+        else
+          printf("inf");
+        printf(") us: %lu\n", hist[i]);
+      }
+  }
+}
+
+
 /* Setup MPS arena and call benchmark. */
 
 static void arena_setup(gcthread_fn_t fn,
                         mps_pool_class_t pool_class,
                         const char *name)
 {
+  unsigned i;
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, arena_size);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_GRAIN_SIZE, arena_grain_size);
     MPS_ARGS_ADD(args, MPS_KEY_ARENA_ZONED, zoned);
     MPS_ARGS_ADD(args, MPS_KEY_PAUSE_TIME, pause_time);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SOFT_BARRIER, soft_barrier);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_BACKGROUND_COLLECTOR, background);
     RESMUST(mps_arena_create_k(&arena, mps_arena_class_vm(), args));
   } MPS_ARGS_END(args);
+  for (i = 0; i < histLIMIT; ++i)
+    hist[i] = 0;
   RESMUST(dylan_fmt(&format, arena));
   /* Make wrappers now to avoid race condition. */
   /* dylan_make_wrappers() uses malloc. */
@@ -253,6 +465,7 @@ static void arena_setup(gcthread_fn_t fn,
   } MPS_ARGS_END(args);
   watch(fn, name);
   mps_arena_park(arena);
+  report(name);
   mps_pool_destroy(pool);
   mps_fmt_destroy(format);
   if (ngen > 0)
@@ -279,6 +492,11 @@ static struct option longopts[] = {
   {"seed",             required_argument, NULL, 'x'},
   {"arena-unzoned",    no_argument,       NULL, 'z'},
   {"pause-time",       required_argument, NULL, 'P'},
+  {"soft-barrier",     no_argument,       NULL, 'B'},
+  {"background",       no_argument,       NULL, 'C'},
+  {"histogram",        no_argument,       NULL, 'H'},
+  {"old",              required_argument, NULL, 'o'},
+  {"area-size",        required_argument, NULL, 's'},
   {NULL,               0,                 NULL, 0  }
 };
 
@@ -290,6 +508,7 @@ static struct {
 } pools[] = {
   {"amc", gc_tree, mps_class_amc},
   {"ams", gc_tree, mps_class_ams},
+  {"area", gc_area, mps_class_amc},
 };
 
 
@@ -302,7 +521,7 @@ int main(int argc, char *argv[]) {
 
   seed = rnd_seed();
   
-  while ((ch = getopt_long(argc, argv, "ht:i:p:g:m:a:w:d:r:u:lx:zP:",
+  while ((ch = getopt_long(argc, argv, "ht:i:p:g:m:a:w:d:r:u:lx:zP:BCHo:s:",
                            longopts, NULL)) != -1)
     switch (ch) {
     case 't':
@@ -396,6 +615,43 @@ int main(int argc, char *argv[]) {
     case 'P':
       pause_time = strtod(optarg, NULL);
       break;
+    case 'B':
+      soft_barrier = TRUE;
+      break;
+    case 'C':
+      background = TRUE;
+      break;
+    case 'H':
+      histogram = TRUE;
+      break;
+    case 'o': {
+        char *p;
+        old_size = (size_t)strtoul(optarg, &p, 10);
+        switch(toupper(*p)) {
+        case 'G': old_size <<= 30; break;
+        case 'M': old_size <<= 20; break;
+        case 'K': old_size <<= 10; break;
+        case '\0': break;
+        default:
+          fprintf(stderr, "Bad old size %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+      }
+      break;
+    case 's': {
+        char *p;
+        area_size = (size_t)strtoul(optarg, &p, 10);
+        switch(toupper(*p)) {
+        case 'G': area_size <<= 30; break;
+        case 'M': area_size <<= 20; break;
+        case 'K': area_size <<= 10; break;
+        case '\0': break;
+        default:
+          fprintf(stderr, "Bad area size %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+      }
+      break;
     default:
       /* This is printed in parts to keep within the 509 character
          limit for string literals in portable standard C. */
@@ -443,15 +699,36 @@ int main(int argc, char *argv[]) {
               "    Disable zoned allocation in the arena\n"
               "  -P t, --pause-time\n"
               "    Maximum pause time in seconds (default %f) \n"
+              "  -B, --soft-barrier\n"
+              "    Use a software write barrier instead of protection\n"
+              "    (only with one thread)\n"
+              "  -C, --background\n"
+              "    Collect in a background thread\n"
+              "  -H, --histogram\n"
+              "    Report a histogram of mutator pauses\n"
+              "  -o n, --old=n[KMG]\n"
+              "    Make n bytes of long-lived data in each thread\n",
+              pause_time);
+      fprintf(stderr,
+              "  -s n, --area-size=n[KMG]\n"
+              "    Size of the ambiguous area for the area test\n"
+              "    (default %lu)\n"
               "Tests:\n"
               "  amc   pool class AMC\n"
-              "  ams   pool class AMS\n",
-              pause_time);
+              "  ams   pool class AMS\n"
+              "  area  time mps_scan_area on an ambiguous root\n",
+              (unsigned long)area_size);
       return EXIT_FAILURE;
     }
   argc -= optind;
   argv += optind;
 
+  /* <design/write-barrier/#soft.threads> */
+  if (soft_barrier && nthreads > 1) {
+    fprintf(stderr, "--soft-barrier needs --nthreads=1\n");
+    return EXIT_FAILURE;
+  }
+
   if (!seed_specified) {
     printf("seed: %lu\n", seed);
     (void)fflush(stdout);
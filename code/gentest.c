@@ -0,0 +1,229 @@
+/* gentest.c: TEST FOR ALLOCATION INTO OLDER GENERATIONS
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * Checks that an allocation point created with MPS_KEY_GEN in an AMC
+ * pool allocates into the generation it names, and that in a pool
+ * created with MPS_KEY_AMC_PRETENURE, an allocation point whose
+ * objects survive moves to an older generation while one whose
+ * objects die stays in the nursery (see <design/poolamc/#pretenure>).
+ */
+
+#include "fmtdy.h"
+#include "fmtdytst.h"
+#include "mpm.h"
+#include "mps.h"
+#include "mpsavm.h"
+#include "mpscamc.h"
+#include "testlib.h"
+
+#include <stdio.h> /* printf */
+
+#define genCOUNT        3
+#define keepCOUNT       50000
+#define objectSLOTS     2
+#define allocLIMIT      10000000ul
+#define testARENA_SIZE  ((size_t)64 << 20)
+
+static mps_gen_param_s testChain[genCOUNT] = {
+  { 256, 0.9 }, { 512, 0.5 }, { 1024, 0.5 }
+};
+
+
+static mps_addr_t keep[keepCOUNT];
+
+
+static mps_addr_t alloc(mps_ap_t ap)
+{
+  mps_word_t v;
+  die(make_dylan_vector(&v, ap, objectSLOTS), "make_dylan_vector");
+  return (mps_addr_t)v;
+}
+
+
+/* objectGen -- return the generation in the chain containing an object
+ *
+ * Returns genCOUNT if the object is not in any of the chain's
+ * generations (that is, if it is in the arena's top generation).
+ */
+
+static unsigned objectGen(mps_arena_t mps_arena, mps_chain_t chain,
+                          mps_addr_t addr)
+{
+  Arena arena = (Arena)mps_arena;
+  Seg seg;
+  unsigned i;
+  Insist(SegOfAddr(&seg, arena, (Addr)addr));
+  for (i = 0; i < genCOUNT; ++i) {
+    Ring node, next;
+    RING_FOR(node, &ChainGen(chain, i)->segRing, next) {
+      if (RING_ELT(GCSeg, genRing, node) == SegGCSeg(seg))
+        return i;
+    }
+  }
+  return genCOUNT;
+}
+
+
+/* test -- check allocation into a chosen generation */
+
+static void test(mps_arena_t arena, mps_chain_t chain, mps_fmt_t format)
+{
+  mps_pool_t pool;
+  mps_ap_t ap[genCOUNT + 1];
+  unsigned gen;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create");
+  } MPS_ARGS_END(args);
+
+  mps_arena_park(arena);
+  for (gen = 0; gen <= genCOUNT; ++gen) {
+    MPS_ARGS_BEGIN(args) {
+      MPS_ARGS_ADD(args, MPS_KEY_GEN, gen);
+      die(mps_ap_create_k(&ap[gen], pool, args), "ap_create");
+    } MPS_ARGS_END(args);
+    Insist(objectGen(arena, chain, alloc(ap[gen])) == gen);
+  }
+  for (gen = 0; gen <= genCOUNT; ++gen)
+    mps_ap_destroy(ap[gen]);
+  mps_arena_release(arena);
+
+  mps_pool_destroy(pool);
+}
+
+
+/* adapt -- check that allocation points adapt their generations */
+
+static void adapt(mps_arena_t arena, mps_chain_t chain, mps_fmt_t format)
+{
+  mps_pool_t pool;
+  mps_ap_t keepAp, dropAp;
+  mps_addr_t kept, dropped;
+  unsigned long i;
+  unsigned keepGen = 0, dropGen = 0;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    MPS_ARGS_ADD(args, MPS_KEY_AMC_PRETENURE, TRUE);
+    die(mps_pool_create_k(&pool, arena, mps_class_amc(), args),
+        "pool_create");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create_k(&keepAp, pool, mps_args_none), "ap_create");
+  die(mps_ap_create_k(&dropAp, pool, mps_args_none), "ap_create");
+
+  for (i = 0; i < allocLIMIT; ++i) {
+    kept = alloc(keepAp);
+    keep[i % keepCOUNT] = kept;
+    dropped = alloc(dropAp);
+    if (i % keepCOUNT == 0) {
+      mps_arena_park(arena);
+      keepGen = objectGen(arena, chain, kept);
+      dropGen = objectGen(arena, chain, dropped);
+      mps_arena_release(arena);
+      if (keepGen > 0)
+        break;
+    }
+  }
+  printf("after %lu allocations, surviving objects are allocated in "
+         "generation %u and dying objects in generation %u\n",
+         i, keepGen, dropGen);
+  Insist(keepGen > 0);
+  Insist(dropGen == 0);
+
+  mps_arena_park(arena);
+  for (i = 0; i < keepCOUNT; ++i)
+    keep[i] = NULL;
+  mps_ap_destroy(dropAp);
+  mps_ap_destroy(keepAp);
+  mps_arena_release(arena);
+  mps_pool_destroy(pool);
+}
+
+
+int main(int argc, char *argv[])
+{
+  mps_arena_t arena;
+  mps_thr_t thread;
+  mps_root_t stackRoot, keepRoot;
+  mps_fmt_t format;
+  mps_chain_t chain;
+  void *marker = &marker;
+
+  testlib_init(argc, argv);
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testARENA_SIZE);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+  die(mps_thread_reg(&thread, arena), "thread_reg");
+  die(mps_root_create_thread(&stackRoot, arena, thread, marker),
+      "root_create_thread");
+  die(mps_root_create_table(&keepRoot, arena, mps_rank_exact(), 0,
+                            keep, keepCOUNT),
+      "root_create_table");
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&chain, arena, genCOUNT, testChain), "chain_create");
+
+  test(arena, chain, format);
+  adapt(arena, chain, format);
+
+  mps_arena_park(arena);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_root_destroy(keepRoot);
+  mps_root_destroy(stackRoot);
+  mps_thread_dereg(thread);
+  mps_arena_destroy(arena);
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs, such as windowing system software.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -722,6 +722,24 @@ void (ArenaPoll)(Globals globals)
 }
 
 
+/* arenaSweep -- do some deferred reclaim work in one of the pools
+ *
+ * Returns TRUE if any pool had some to do.  See PoolSweep.
+ */
+
+static Bool arenaSweep(Globals globals)
+{
+  Ring node, nextNode;
+
+  RING_FOR(node, &globals->poolRing, nextNode) {
+    Pool pool = RING_ELT(Pool, arenaRing, node);
+    if (PoolSweep(pool))
+      return TRUE;
+  }
+  return FALSE;
+}
+
+
 /* ArenaStep -- use idle time for collection work */
 
 Bool ArenaStep(Globals globals, double interval, double multiplier)
@@ -747,9 +765,7 @@ Bool ArenaStep(Globals globals, double interval, double multiplier)
   /* loop while there is work to do and time on the clock. */
   do {
     Trace trace;
-    if (arena->busyTraces != TraceSetEMPTY) {
-      trace = ArenaTrace(arena, (TraceId)0);
-    } else {
+    if (!TraceFirstBusy(&trace, arena)) {
       /* No traces are running: consider collecting the world. */
       if (PolicyShouldCollectWorld(arena, (double)(availableEnd - now), now,
                                    clocks_per_sec))
@@ -762,8 +778,14 @@ Bool ArenaStep(Globals globals, double interval, double multiplier)
       } else {
         /* Not worth collecting the world; consider starting a trace. */
         Bool worldCollected;
-        if (!PolicyStartTrace(&trace, &worldCollected, arena, FALSE))
-          break;
+        if (!PolicyStartTrace(&trace, &worldCollected, arena, FALSE)) {
+          /* Nothing to collect: catch up on deferred sweeping. */
+          if (!arenaSweep(globals))
+            break;
+          workWasDone = TRUE;
+          now = ClockNow();
+          continue;
+        }
       }
     }
     TraceAdvance(trace);
@@ -780,10 +802,141 @@ Bool ArenaStep(Globals globals, double interval, double multiplier)
   return workWasDone;
 }
 
+
+/* ArenaCollectorStep -- do collection work in the background
+ *
+ * Called by the background collector thread, without the arena lock.
+ * Return the time, in seconds, that the thread should wait before
+ * calling again.  See <design/arena/#collector>.
+ */
+
+double ArenaCollectorStep(Arena arena)
+{
+  Globals globals;
+  Clock start, now;
+  Bool worldCollected = FALSE;
+  Bool moreWork = FALSE, workWasDone = FALSE;
+  Work tracedWork;
+  double interval;
+
+  ArenaEnter(arena);
+  globals = ArenaGlobals(arena);
+
+  start = now = ClockNow();
+  if (!globals->clamped) {
+    do {
+      moreWork = TracePoll(&tracedWork, &worldCollected, globals,
+                           !worldCollected);
+      if (moreWork)
+        workWasDone = TRUE;
+      now = ClockNow();
+    } while (moreWork
+             && now - start < ArenaPauseTime(arena) * ClocksPerSec());
+
+    /* <design/arena/#collector.poll> */
+    if (globals->pollThreshold
+        < globals->fillMutatorSize + ArenaPollBACKGROUNDALLOCTIME)
+      globals->pollThreshold
+        = globals->fillMutatorSize + ArenaPollBACKGROUNDALLOCTIME;
+  }
+
+  if (workWasDone)
+    ArenaAccumulateTime(arena, start, now);
+
+  interval = PolicyCollectorInterval(arena, moreWork,
+                                     (double)(now - start) / ClocksPerSec());
+  EVENT3(ArenaCollectorStep, arena, start, BOOLOF(workWasDone));
+
+  ArenaLeave(arena);
+  return interval;
+}
+
+
+/* ArenaStartCollector -- start the background collector, if requested
+ *
+ * Called without the arena lock, after the arena has been created.
+ */
+
+Res ArenaStartCollector(Arena arena)
+{
+  Collector collector;
+  void *p;
+  Res res;
+
+  ArenaEnter(arena);
+  if (!arena->backgroundCollector) {
+    ArenaLeave(arena);
+    return ResOK;
+  }
+  AVER(arena->collector == NULL);
+
+  res = ControlAlloc(&p, arena, CollectorSize());
+  if (res != ResOK)
+    goto failAlloc;
+  collector = p;
+
+  /* The thread can't start work until we leave the arena. */
+  res = CollectorInit(collector, arena);
+  if (res != ResOK)
+    goto failInit;
+  arena->collector = collector;
+
+  ArenaLeave(arena);
+  return ResOK;
+
+failInit:
+  ControlFree(arena, p, CollectorSize());
+failAlloc:
+  ArenaLeave(arena);
+  return res;
+}
+
+
+/* ArenaStopCollector -- stop the background collector, if running
+ *
+ * Called without the arena lock, before the arena is destroyed.
+ */
+
+void ArenaStopCollector(Arena arena)
+{
+  Collector collector;
+
+  ArenaEnter(arena);
+  collector = arena->collector;
+  arena->collector = NULL;
+  ArenaLeave(arena);
+
+  if (collector == NULL)
+    return;
+
+  CollectorFinish(collector);
+
+  ArenaEnter(arena);
+  ControlFree(arena, collector, CollectorSize());
+  ArenaLeave(arena);
+}
+
+
 /* ArenaFinalize -- registers an object for finalization
  *
  * See <design/finalize/>.  */
 
+static Res arenaFinalPool(Arena arena)
+{
+  Res res;
+  Pool finalpool;
+
+  if (arena->isFinalPool)
+    return ResOK;
+
+  res = PoolCreate(&finalpool, arena, PoolClassMRG(), argsNone);
+  if (res != ResOK)
+    return res;
+  arena->finalPool = finalpool;
+  arena->isFinalPool = TRUE;
+  return ResOK;
+}
+
 Res ArenaFinalize(Arena arena, Ref obj)
 {
   Res res;
@@ -793,21 +946,36 @@ Res ArenaFinalize(Arena arena, Ref obj)
   AVER(PoolOfAddr(&refpool, arena, (Addr)obj));
   AVER(PoolHasAttr(refpool, AttrGC));
 
-  if (!arena->isFinalPool) {
-    Pool finalpool;
-
-    res = PoolCreate(&finalpool, arena, PoolClassMRG(), argsNone);
-    if (res != ResOK)
-      return res;
-    arena->finalPool = finalpool;
-    arena->isFinalPool = TRUE;
-  }
+  res = arenaFinalPool(arena);
+  if (res != ResOK)
+    return res;
 
   res = MRGRegister(arena->finalPool, obj);
   return res;
 }
 
 
+/* ArenaFinalizeMany -- registers many objects for finalization
+ *
+ * The references are read from refs[0] to refs[count-1].  Either all
+ * of the objects are registered, or none of them are.  See
+ * <design/finalize/>.  */
+
+Res ArenaFinalizeMany(Arena arena, Ref *refs, Count count)
+{
+  Res res;
+
+  AVERT(Arena, arena);
+  AVER(refs != NULL);
+
+  res = arenaFinalPool(arena);
+  if (res != ResOK)
+    return res;
+
+  return MRGRegisterMany(arena->finalPool, refs, count);
+}
+
+
 /* ArenaDefinalize -- removes one finalization registration of an object
  *
  * See <design/finalize>.  */
@@ -890,6 +1058,12 @@ void ArenaPokeSeg(Arena arena, Seg seg, Ref *p, Ref ref)
   summary = SegSummary(seg);
   summary = RefSetAdd(arena, summary, (Addr)ref);
   SegSetSummary(seg, summary);
+  if (summary != RefSetUNIV) {
+    /* <design/write-barrier/#gen.zones> */
+    ZoneSet zones = ZoneSetAddAddr(arena, ZoneSetEMPTY, (Addr)ref);
+    SegSetRemembered(seg, GenSetUnion(SegRemembered(seg),
+                                      GenSetOfZones(arena, zones)));
+  }
   ShieldCover(arena, seg);
 }
 
@@ -3,7 +3,7 @@
  * $Id$
  * Copyright (c) 2001-2014 Ravenbrook Limited.  See end of file for license.
  *
- * Test all three Land implementations against duplicate operations on
+ * Test all four Land implementations against duplicate operations on
  * a bit-table.
  */
 
@@ -29,6 +29,7 @@ SRCID(landtest, "$Id$");
 #define nCBSOperations ((Size)125000)
 #define nFLOperations ((Size)12500)
 #define nFOOperations ((Size)12500)
+#define nSFOperations ((Size)125000)
 
 static Count NAllocateTried, NAllocateSucceeded, NDeallocateTried,
   NDeallocateSucceeded;
@@ -41,6 +42,7 @@ typedef struct TestStateStruct {
   Addr block;
   Size size;
   Land land;
+  Bool goodFit;         /* find methods are not address-ordered */
 } TestStateStruct, *TestState;
 
 typedef struct CheckTestClosureStruct {
@@ -374,7 +376,37 @@ static void find(TestState state, Size size, Bool high, FindDelete findDelete)
 
   Insist(found == expected);
 
-  if (found) {
+  if (found && state->goodFit) {
+    /* Any isolated range that is big enough will do. */
+    Index oldBase = indexOfAddr(state, RangeBase(&oldRange));
+    Index oldLimit = indexOfAddr(state, RangeLimit(&oldRange));
+    Insist(BTIsResRange(state->allocTable, oldBase, oldLimit));
+    Insist(oldBase == 0 || BTGet(state->allocTable, oldBase - 1));
+    Insist(oldLimit == state->size || BTGet(state->allocTable, oldLimit));
+    Insist(RangesNest(&oldRange, &foundRange));
+    switch(findDelete) {
+    case FindDeleteNONE:
+    case FindDeleteENTIRE:
+      Insist(RangesEqual(&foundRange, &oldRange));
+      Insist(RangeSize(&foundRange) >= size * state->align);
+      break;
+    case FindDeleteLOW:
+      Insist(RangeBase(&foundRange) == RangeBase(&oldRange));
+      Insist(RangeSize(&foundRange) == size * state->align);
+      break;
+    case FindDeleteHIGH:
+      Insist(RangeLimit(&foundRange) == RangeLimit(&oldRange));
+      Insist(RangeSize(&foundRange) == size * state->align);
+      break;
+    default:
+      cdie(0, "invalid findDelete");
+      break;
+    }
+    if (findDelete != FindDeleteNONE)
+      BTSetRange(state->allocTable,
+                 indexOfAddr(state, RangeBase(&foundRange)),
+                 indexOfAddr(state, RangeLimit(&foundRange)));
+  } else if (found) {
     Insist(expectedBase == indexOfAddr(state, RangeBase(&foundRange)));
     Insist(expectedLimit == indexOfAddr(state, RangeLimit(&foundRange)));
 
@@ -439,7 +471,9 @@ extern int main(int argc, char *argv[])
   CBSStruct cbsStruct;
   FreelistStruct flStruct;
   FailoverStruct foStruct;
+  CBSSegFitStruct sfStruct;
   Land cbs = CBSLand(&cbsStruct);
+  Land sf = CBSLand(&sfStruct.cbsStruct);
   Land fl = FreelistLand(&flStruct);
   Land fo = FailoverLand(&foStruct);
   Pool mfs = MFSPool(&blockPool);
@@ -448,6 +482,7 @@ extern int main(int argc, char *argv[])
   testlib_init(argc, argv);
   state.size = ArraySize;
   state.align = (1 << rnd() % 4) * MPS_PF_ALIGN;
+  state.goodFit = FALSE;
 
   NAllocateTried = NAllocateSucceeded = NDeallocateTried =
     NDeallocateSucceeded = 0;
@@ -527,6 +562,18 @@ extern int main(int argc, char *argv[])
       PoolFinish(mfs);
   }
 
+  /* 4. Test segregated-fit CBS */
+
+  MPS_ARGS_BEGIN(args) {
+    die((mps_res_t)LandInit(sf, CLASS(CBSSegFit), arena, state.align,
+                            NULL, args),
+        "failed to initialise CBSSegFit");
+  } MPS_ARGS_END(args);
+  state.land = sf;
+  state.goodFit = TRUE;
+  test(&state, nSFOperations);
+  LandFinish(sf);
+
   ControlFree(arena, p, (state.size + 1) * state.align);
   mps_arena_destroy(arena);
 
@@ -0,0 +1,349 @@
+/* lobench.c -- LO fragmentation and throughput benchmark
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * This benchmark allocates many short-lived leaf objects of random
+ * sizes in an LO pool, keeping a fixed number of them alive at random,
+ * and measures the allocation time and how much of the pool's memory
+ * is occupied by live objects. The tests compare first-fit allocation
+ * with size class segments (see <design/poollo/#class>):
+ *
+ *   fit     first fit, one allocation point
+ *   class   size classes, one allocation point per class
+ *   class1  size classes, one allocation point
+ */
+
+#include "mps.c"
+#include "testlib.h"
+#include "fmtvec.h"
+#include "mpsclo.h"
+
+#ifdef MPS_OS_W3
+#include "getopt.h"
+#else
+#include <getopt.h>
+#endif
+
+#include <stdio.h> /* fprintf, printf, stderr */
+#include <stdlib.h> /* calloc, free, EXIT_FAILURE, EXIT_SUCCESS, strtoul */
+#include <string.h> /* strcmp */
+#include <time.h> /* clock, CLOCKS_PER_SEC */
+
+static rnd_state_t seed = 0;      /* random number seed */
+static unsigned long nalloc = 500000; /* objects to allocate */
+static size_t nlive = 20000;      /* objects kept alive */
+static size_t minwords = 2;       /* minimum object size in words */
+static size_t maxwords = 256;     /* maximum object size in words */
+static unsigned long nsample = 1000; /* allocations between samples */
+static size_t arena_size = 256ul * 1024 * 1024; /* arena size */
+
+static mps_gen_param_s gen[] = {
+  { 4096, 0.5 }
+};
+
+#define NAPS 9  /* one per power of two up to 128 words, and one more */
+
+
+static mps_arena_t arena;
+static mps_fmt_t format;
+static mps_chain_t chain;
+static mps_pool_t pool;
+static mps_ap_t aps[NAPS];
+static mps_word_t **live;         /* objects kept alive */
+
+
+/* apIndex -- choose the allocation point for an object
+ *
+ * Objects that would fall into the same size class share an
+ * allocation point.
+ */
+
+static size_t apIndex(size_t words)
+{
+  size_t i = 0;
+  while (i < NAPS - 1 && ((size_t)1 << i) < words)
+    ++i;
+  return i;
+}
+
+
+/* randomWords -- choose an object size
+ *
+ * The size is distributed log-uniformly between minwords and
+ * maxwords, so that there are many more small objects than large.
+ */
+
+static size_t randomWords(void)
+{
+  size_t words = minwords;
+  size_t limit = minwords + rnd() % (maxwords - minwords + 1);
+  while (words < limit && rnd() % 2 == 0)
+    words *= 2;
+  if (words > limit)
+    words = limit;
+  return words;
+}
+
+
+/* bench -- run one test */
+
+static void bench(const char *name, mps_bool_t sizeClasses,
+                  mps_bool_t segregate)
+{
+  mps_thr_t thread;
+  mps_root_t stackroot, liveroot;
+  clock_t begin, end;
+  unsigned long i, collections = 0, samples = 0;
+  size_t j, liveSize = 0, peakSize = 0;
+  double occupancy = 0.0;
+  mps_message_t message;
+  void *marker;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, arena_size);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+  die(mps_thread_reg(&thread, arena), "thread_reg");
+  die(mps_root_create_thread(&stackroot, arena, thread, &marker),
+      "root_create_thread");
+  die(mps_root_create_table(&liveroot, arena, mps_rank_exact(), 0,
+                            (mps_addr_t *)live, nlive),
+      "root_create_table");
+  die(vec_fmt(&format, arena), "vec_fmt");
+  die(mps_chain_create(&chain, arena, NELEMS(gen), gen), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    MPS_ARGS_ADD(args, MPS_KEY_LO_SIZE_CLASSES, sizeClasses);
+    die(mps_pool_create_k(&pool, arena, mps_class_lo(), args),
+        "pool_create(lo)");
+  } MPS_ARGS_END(args);
+  for (j = 0; j < NAPS; ++j)
+    die(mps_ap_create_k(&aps[j], pool, mps_args_none), "ap_create");
+
+  mps_message_type_enable(arena, mps_message_type_gc());
+  begin = clock();
+  for (i = 0; i < nalloc; ++i) {
+    size_t words = randomWords();
+    size_t size = words * sizeof(mps_word_t);
+    mps_ap_t ap = aps[segregate ? apIndex(words) : 0];
+    mps_word_t *p;
+    size_t k = rnd() % nlive;
+
+    die(make_vec(&p, ap, words, VEC_LEAF), "make_vec");
+    if (live[k] != NULL)
+      liveSize -= VEC_WORDS(live[k][0]) * sizeof(mps_word_t);
+    live[k] = p;
+    liveSize += size;
+
+    if (i % nsample == nsample - 1) {
+      size_t total = mps_pool_total_size(pool);
+      if (total > peakSize)
+        peakSize = total;
+      occupancy += (double)liveSize / (double)total;
+      ++samples;
+    }
+  }
+  end = clock();
+
+  mps_arena_park(arena);
+  while (mps_message_get(&message, arena, mps_message_type_gc())) {
+    ++collections;
+    mps_message_discard(arena, message);
+  }
+  printf("%s: %g seconds, %lu collections, peak pool size %lu, "
+         "mean occupancy %.3f\n", name,
+         (double)(end - begin) / CLOCKS_PER_SEC, collections,
+         (unsigned long)peakSize,
+         samples > 0 ? occupancy / (double)samples : 0.0);
+
+  for (j = 0; j < NAPS; ++j)
+    mps_ap_destroy(aps[j]);
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_root_destroy(liveroot);
+  mps_root_destroy(stackroot);
+  mps_thread_dereg(thread);
+  mps_arena_destroy(arena);
+}
+
+
+/* Command-line options definitions.  See getopt_long(3). */
+
+static struct option longopts[] = {
+  {"help",             no_argument,       NULL, 'h'},
+  {"nalloc",           required_argument, NULL, 'n'},
+  {"nlive",            required_argument, NULL, 'l'},
+  {"min-words",        required_argument, NULL, 's'},
+  {"max-words",        required_argument, NULL, 'S'},
+  {"arena-size",       required_argument, NULL, 'm'},
+  {"seed",             required_argument, NULL, 'x'},
+  {NULL,               0,                 NULL, 0  }
+};
+
+
+static struct {
+  const char *name;
+  mps_bool_t sizeClasses;
+  mps_bool_t segregate;
+} tests[] = {
+  {"fit",    FALSE, FALSE},
+  {"class",  TRUE,  TRUE},
+  {"class1", TRUE,  FALSE},
+};
+
+
+/* Command-line driver */
+
+int main(int argc, char *argv[])
+{
+  int ch;
+  unsigned i;
+  mps_bool_t seed_specified = FALSE;
+
+  seed = rnd_seed();
+
+  while ((ch = getopt_long(argc, argv, "hn:l:s:S:m:x:",
+                           longopts, NULL)) != -1)
+    switch (ch) {
+    case 'n':
+      nalloc = strtoul(optarg, NULL, 10);
+      break;
+    case 'l':
+      nlive = (size_t)strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      minwords = (size_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'S':
+      maxwords = (size_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'm': {
+        char *p;
+        arena_size = (unsigned)strtoul(optarg, &p, 10);
+        switch(toupper(*p)) {
+        case 'G': arena_size <<= 30; break;
+        case 'M': arena_size <<= 20; break;
+        case 'K': arena_size <<= 10; break;
+        case '\0': break;
+        default:
+          fprintf(stderr, "Bad arena size %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+      }
+      break;
+    case 'x':
+      seed = strtoul(optarg, NULL, 10);
+      seed_specified = TRUE;
+      break;
+    default:
+      fprintf(stderr,
+              "Usage: %s [option...] [test...]\n"
+              "Options:\n"
+              "  -m n, --arena-size=n[KMG]?\n"
+              "    Initial size of arena (default %lu).\n"
+              "  -n n, --nalloc=n\n"
+              "    Number of objects to allocate (default %lu).\n"
+              "  -l n, --nlive=n\n"
+              "    Number of objects kept alive (default %lu).\n",
+              argv[0],
+              (unsigned long)arena_size,
+              nalloc,
+              (unsigned long)nlive);
+      fprintf(stderr,
+              "  -s n, --min-words=n\n"
+              "    Minimum object size in words (default %lu).\n"
+              "  -S n, --max-words=n\n"
+              "    Maximum object size in words (default %lu).\n"
+              "  -x n, --seed=n\n"
+              "    Random number seed (default from entropy).\n"
+              "Tests:\n"
+              "  fit     first fit, one allocation point\n"
+              "  class   size classes, one allocation point per class\n"
+              "  class1  size classes, one allocation point\n",
+              (unsigned long)minwords,
+              (unsigned long)maxwords);
+      return EXIT_FAILURE;
+    }
+  argc -= optind;
+  argv += optind;
+
+  if (nlive == 0 || minwords < VEC_MIN_WORDS || maxwords < minwords) {
+    fprintf(stderr, "Bad arguments; try --help\n");
+    return EXIT_FAILURE;
+  }
+
+  if (!seed_specified) {
+    printf("seed: %lu\n", seed);
+    (void)fflush(stdout);
+  }
+
+  live = calloc(nlive, sizeof live[0]);
+  if (live == NULL) {
+    fprintf(stderr, "Couldn't allocate roots\n");
+    return EXIT_FAILURE;
+  }
+
+  while (argc > 0) {
+    for (i = 0; i < NELEMS(tests); ++i)
+      if (strcmp(argv[0], tests[i].name) == 0)
+        goto found;
+    fprintf(stderr, "unknown test \"%s\"\n", argv[0]);
+    return EXIT_FAILURE;
+  found:
+    (void)mps_lib_assert_fail_install(assert_die);
+    rnd_state_set(seed);
+    memset(live, 0, nlive * sizeof live[0]);
+    bench(tests[i].name, tests[i].sizeClasses, tests[i].segregate);
+    --argc;
+    ++argv;
+  }
+
+  free(live);
+  return EXIT_SUCCESS;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -107,6 +107,7 @@ Bool GenDescCheck(GenDesc gen)
 {
   CHECKS(GenDesc, gen);
   /* nothing to check for zones */
+  CHECKL(BS_IS_SINGLE(gen->genSet));
   /* nothing to check for capacity */
   CHECKL(gen->mortality >= 0.0);
   CHECKL(gen->mortality <= 1.0);
@@ -129,13 +130,29 @@ static Bool GenParamCheck(GenParamStruct *params)
 }
 
 
+/* genDescSerial -- give a generation the next serial number
+ *
+ * The generation set of the generation has the bit for the serial
+ * number modulo the word width.  Two generations may share a bit, and
+ * this only makes the remembered set less precise.  See
+ * <design/write-barrier/#gen.set>.
+ */
+
+static void genDescSerial(GenDesc gen, Arena arena)
+{
+  gen->genSet = BS_SINGLE(GenSet, arena->genSerial % MPS_WORD_WIDTH);
+  ++arena->genSerial;
+}
+
+
 /* GenDescInit -- initialize a generation in a chain */
 
-static void GenDescInit(GenDesc gen, GenParamStruct *params)
+static void GenDescInit(GenDesc gen, Arena arena, GenParamStruct *params)
 {
   AVER(gen != NULL);
   AVER(GenParamCheck(params));
   gen->zones = ZoneSetEMPTY;
+  genDescSerial(gen, arena);
   gen->capacity = params->capacity;
   gen->mortality = params->mortality;
   RingInit(&gen->locusRing);
@@ -281,6 +298,7 @@ Res GenDescDescribe(GenDesc gen, mps_lib_FILE *stream, Count depth)
   res = WriteF(stream, depth,
                "GenDesc $P {\n", (WriteFP)gen,
                "  zones $B\n", (WriteFB)gen->zones,
+               "  genSet $B\n", (WriteFB)gen->genSet,
                "  capacity $W\n", (WriteFW)gen->capacity,
                "  mortality $D\n", (WriteFD)gen->mortality,
                NULL);
@@ -311,6 +329,40 @@ Res GenDescDescribe(GenDesc gen, mps_lib_FILE *stream, Count depth)
 }
 
 
+/* GenSetOfZones -- generations that may have segments in some zones
+ *
+ * Returns the union of the generation sets of all the generations in
+ * the arena that have allocated segments in any of the zones.  A
+ * reference whose zone is in zones can only refer to a segment in one
+ * of these generations.  See <design/write-barrier/#gen.zones>.
+ */
+
+GenSet GenSetOfZones(Arena arena, ZoneSet zones)
+{
+  GenSet gens = GenSetEMPTY;
+  Ring node, nextNode;
+  Index i;
+
+  AVERT(Arena, arena);
+
+  if (zones == ZoneSetEMPTY)
+    return GenSetEMPTY;
+
+  RING_FOR(node, &arena->chainRing, nextNode) {
+    Chain chain = RING_ELT(Chain, chainRing, node);
+    for (i = 0; i < chain->genCount; ++i) {
+      GenDesc gen = &chain->gens[i];
+      if (ZoneSetInter(gen->zones, zones) != ZoneSetEMPTY)
+        gens = GenSetUnion(gens, gen->genSet);
+    }
+  }
+  if (ZoneSetInter(arena->topGen.zones, zones) != ZoneSetEMPTY)
+    gens = GenSetUnion(gens, arena->topGen.genSet);
+
+  return gens;
+}
+
+
 /* ChainInit -- initialize a generation chain */
 
 static void ChainInit(ChainStruct *chain, Arena arena, GenDescStruct *gens,
@@ -356,7 +408,7 @@ Res ChainCreate(Chain *chainReturn, Arena arena, size_t genCount,
   gens = (GenDescStruct *)p;
 
   for (i = 0; i < genCount; ++i)
-    GenDescInit(&gens[i], &params[i]);
+    GenDescInit(&gens[i], arena, &params[i]);
 
   res = ControlAlloc(&p, arena, sizeof(ChainStruct));
   if (res != ResOK)
@@ -638,6 +690,7 @@ Res PoolGenAlloc(Seg *segReturn, PoolGen pgen, SegClass class, Size size,
     return res;
 
   RingAppend(&gen->segRing, &SegGCSeg(seg)->genRing);
+  SegGCSeg(seg)->genSet = gen->genSet;
 
   moreZones = ZoneSetUnion(zones, ZoneSetOfSeg(arena, seg));
   gen->zones = moreZones;
@@ -885,6 +938,8 @@ void LocusInit(Arena arena)
   /* Can't check arena, because it's not been inited. */
 
   gen->zones = ZoneSetEMPTY;
+  arena->genSerial = 0;
+  genDescSerial(gen, arena);
   gen->capacity = 0; /* unused */
   gen->mortality = 0.5;
   RingInit(&gen->locusRing);
@@ -42,6 +42,7 @@ typedef struct GenDescStruct *GenDesc;
 typedef struct GenDescStruct {
   Sig sig;
   ZoneSet zones;        /* zoneset for this generation */
+  GenSet genSet;        /* <design/write-barrier/#gen.set> */
   Size capacity;        /* capacity in kB */
   double mortality;     /* predicted mortality */
   RingStruct locusRing; /* Ring of all PoolGen's in this GenDesc (locus) */
@@ -95,6 +96,7 @@ extern Size GenDescTotalSize(GenDesc gen);
 extern void GenDescCondemned(GenDesc gen, Trace trace, Size size);
 extern void GenDescSurvived(GenDesc gen, Trace trace, Size forwarded, Size preservedInPlace);
 extern Res GenDescDescribe(GenDesc gen, mps_lib_FILE *stream, Count depth);
+extern GenSet GenSetOfZones(Arena arena, ZoneSet zones);
 
 extern Res ChainCreate(Chain *chainReturn, Arena arena, size_t genCount,
                        GenParam params);
@@ -41,6 +41,70 @@ static mps_fmt_A_s locv_fmt =
 
 static mps_addr_t roots[4];
 
+#define lazyRootsCOUNT  100
+#define lazyObjectCOUNT 1000
+
+static mps_addr_t lazyRoots[lazyRootsCOUNT];
+
+
+/* reclaim -- test LO reclaim with lazy sweeping or size classes
+ *
+ * Allocate objects, keeping only the last lazyRootsCOUNT alive, and
+ * check that the dead ones aren't walked after a collection, and that
+ * their space can be reused.  See <design/poollo/#sweep.lazy> and
+ * <design/poollo/#class>.
+ */
+
+static void reclaim(mps_arena_t arena, mps_fmt_t format,
+                 mps_bool_t lazySweep, mps_bool_t sizeClasses)
+{
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_root_t root;
+  size_t i, pass;
+
+  die(mps_root_create_table(&root, arena, mps_rank_exact(), (mps_rm_t)0,
+                            lazyRoots, lazyRootsCOUNT),
+      "RootCreate lazy");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_LO_LAZY_SWEEP, lazySweep);
+    MPS_ARGS_ADD(args, MPS_KEY_LO_SIZE_CLASSES, sizeClasses);
+    die(mps_pool_create_k(&pool, arena, mps_class_lo(), args),
+        "LOCreate lazy");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create_k(&ap, pool, mps_args_none), "APCreate lazy");
+
+  for (pass = 0; pass < 3; ++pass) {
+    size_t count = 0;
+    for (i = 0; i < lazyObjectCOUNT; ++i) {
+      mps_addr_t p;
+      size_t size = (1 + i % 4) * sizeof(void *);
+      if (i % 97 == 0)
+        size *= 1000; /* too big for any size class */
+      do {
+        die(mps_reserve(&p, ap, size), "mps_reserve lazy");
+        *(mps_word_t *)p = size;
+        lazyRoots[i % lazyRootsCOUNT] = p;
+      } while (!mps_commit(ap, p, size));
+    }
+    mps_arena_collect(arena);
+    if (pass == 1) {
+      /* Leave sweeping to idle time. */
+      while (mps_arena_step(arena, 0.0, 0.0))
+        /* do nothing */;
+    }
+    mps_arena_formatted_objects_walk(arena, stepper, &count, 0);
+    cdie(count == lazyRootsCOUNT, "walk lazy survivors");
+    mps_arena_release(arena);
+  }
+
+  mps_arena_park(arena);
+  mps_ap_destroy(ap);
+  mps_pool_destroy(pool);
+  mps_root_destroy(root);
+}
+
 
 int main(int argc, char *argv[])
 {
@@ -93,6 +157,12 @@ int main(int argc, char *argv[])
   
   mps_ap_destroy(ap);
   mps_pool_destroy(pool);
+  roots[1] = NULL;
+
+  reclaim(arena, format, TRUE, FALSE);
+  reclaim(arena, format, FALSE, TRUE);
+  reclaim(arena, format, TRUE, TRUE);
+
   mps_fmt_destroy(format);
   mps_root_destroy(root);
   mps_arena_destroy(arena);
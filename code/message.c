@@ -73,6 +73,8 @@ Bool MessageClassCheck(MessageClass klass)
   CHECKL(FUNCHECK(klass->gcLiveSize));
   CHECKL(FUNCHECK(klass->gcCondemnedSize));
   CHECKL(FUNCHECK(klass->gcNotCondemnedSize));
+  CHECKL(FUNCHECK(klass->gcCopiedSize));
+  CHECKL(FUNCHECK(klass->gcMarkedSize));
   CHECKL(FUNCHECK(klass->gcStartWhy));
   CHECKL(klass->endSig == MessageClassSig);
 
@@ -279,6 +281,33 @@ void MessageDiscard(Arena arena, Message message)
 }
 
 
+/* MessageGetFinalizationRefs -- get many finalization messages
+ *
+ * Gets up to count finalization messages, writes their references to
+ * refs[0], refs[1], ... (which may be protected), and discards them.
+ * Returns the number of references written.
+ */
+
+Count MessageGetFinalizationRefs(Ref *refs, Arena arena, Count count)
+{
+  Message message;
+  Ref ref;
+  Index i;
+
+  AVER(refs != NULL);
+  AVERT(Arena, arena);
+
+  for (i = 0; i < count; ++i) {
+    if (!MessageGet(&message, arena, MessageTypeFINALIZATION))
+      break;
+    MessageFinalizationRef(&ref, arena, message);
+    ArenaPoke(arena, &refs[i], ref);
+    MessageDiscard(arena, message);
+  }
+  return i;
+}
+
+
 /* Message Methods, Generic
  *
  * (Some of these dispatch on message->klass).
@@ -362,6 +391,22 @@ Size MessageGCNotCondemnedSize(Message message)
   return (*message->klass->gcNotCondemnedSize)(message);
 }
 
+Size MessageGCCopiedSize(Message message)
+{
+  AVERT(Message, message);
+  AVER(MessageGetType(message) == MessageTypeGC);
+
+  return (*message->klass->gcCopiedSize)(message);
+}
+
+Size MessageGCMarkedSize(Message message)
+{
+  AVERT(Message, message);
+  AVER(MessageGetType(message) == MessageTypeGC);
+
+  return (*message->klass->gcMarkedSize)(message);
+}
+
 const char *MessageGCStartWhy(Message message)
 {
   AVERT(Message, message);
@@ -416,6 +461,26 @@ Size MessageNoGCNotCondemnedSize(Message message)
   return (Size)0;
 }
 
+Size MessageNoGCCopiedSize(Message message)
+{
+  AVERT(Message, message);
+  UNUSED(message);
+
+  NOTREACHED;
+
+  return (Size)0;
+}
+
+Size MessageNoGCMarkedSize(Message message)
+{
+  AVERT(Message, message);
+  UNUSED(message);
+
+  NOTREACHED;
+
+  return (Size)0;
+}
+
 const char *MessageNoGCStartWhy(Message message)
 {
   AVERT(Message, message);
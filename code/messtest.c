@@ -36,6 +36,8 @@ static MessageClassStruct DFMessageClassStruct = {
   MessageNoGCLiveSize,         /* GCLiveSize */   
   MessageNoGCCondemnedSize,    /* GCCondemnedSize */
   MessageNoGCNotCondemnedSize, /* GCNotCondemnedSize */
+  MessageNoGCCopiedSize,       /* GCCopiedSize */
+  MessageNoGCMarkedSize,       /* GCMarkedSize */
   MessageNoGCStartWhy,         /* GCStartWhy */
   MessageClassSig              /* <design/message/#class.sig.double> */
 };
@@ -52,6 +54,8 @@ static MessageClassStruct DGCMessageClassStruct = {
   MessageNoGCLiveSize,         /* GCLiveSize */   
   MessageNoGCCondemnedSize,    /* GCCondemnedSize */
   MessageNoGCNotCondemnedSize, /* GCNoteCondemnedSize */
+  MessageNoGCCopiedSize,       /* GCCopiedSize */
+  MessageNoGCMarkedSize,       /* GCMarkedSize */
   MessageNoGCStartWhy,         /* GCStartWhy */
   MessageClassSig              /* <design/message/#class.sig.double> */
 };
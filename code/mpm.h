@@ -18,6 +18,7 @@
 
 #include "event.h"
 #include "lock.h"
+#include "coll.h"
 #include "prot.h"
 #include "sp.h"
 #include "th.h"
@@ -219,6 +220,8 @@ extern void PoolDestroy(Pool pool);
 extern BufferClass PoolDefaultBufferClass(Pool pool);
 extern Res PoolAlloc(Addr *pReturn, Pool pool, Size size);
 extern void PoolFree(Pool pool, Addr old, Size size);
+extern Bool PoolTryAlloc(Addr *pReturn, Pool pool, Size size);
+extern Bool PoolTryFree(Pool pool, Addr old, Size size);
 extern Res PoolTraceBegin(Pool pool, Trace trace);
 extern Res PoolAccess(Pool pool, Seg seg, Addr addr,
                       AccessSet mode, MutatorFaultContext context);
@@ -230,6 +233,7 @@ extern Res PoolFix(Pool pool, ScanState ss, Seg seg, Addr *refIO);
 extern Res PoolFixEmergency(Pool pool, ScanState ss, Seg seg, Addr *refIO);
 extern void PoolReclaim(Pool pool, Trace trace, Seg seg);
 extern void PoolTraceEnd(Pool pool, Trace trace);
+extern Bool PoolSweep(Pool pool);
 extern Res PoolAddrObject(Addr *pReturn, Pool pool, Seg seg, Addr addr);
 extern void PoolWalk(Pool pool, Seg seg, FormattedObjectsVisitor f,
                      void *v, size_t s);
@@ -243,6 +247,8 @@ extern Res PoolNoAlloc(Addr *pReturn, Pool pool, Size size);
 extern Res PoolTrivAlloc(Addr *pReturn, Pool pool, Size size);
 extern void PoolNoFree(Pool pool, Addr old, Size size);
 extern void PoolTrivFree(Pool pool, Addr old, Size size);
+extern Bool PoolTrivTryAlloc(Addr *pReturn, Pool pool, Size size);
+extern Bool PoolTrivTryFree(Pool pool, Addr old, Size size);
 extern Res PoolNoBufferFill(Addr *baseReturn, Addr *limitReturn,
                             Pool pool, Buffer buffer, Size size);
 extern Res PoolTrivBufferFill(Addr *baseReturn, Addr *limitReturn,
@@ -270,6 +276,7 @@ extern Res PoolNoScan(Bool *totalReturn, ScanState ss, Pool pool, Seg seg);
 extern Res PoolNoFix(Pool pool, ScanState ss, Seg seg, Ref *refIO);
 extern void PoolNoReclaim(Pool pool, Trace trace, Seg seg);
 extern void PoolTrivTraceEnd(Pool pool, Trace trace);
+extern Bool PoolTrivSweep(Pool pool);
 extern void PoolNoRampBegin(Pool pool, Buffer buf, Bool collectAll);
 extern void PoolTrivRampBegin(Pool pool, Buffer buf, Bool collectAll);
 extern void PoolNoRampEnd(Pool pool, Buffer buf);
@@ -329,9 +336,13 @@ extern Clock MessageGetClock(Message message);
 /* -- Message Method Dispatchers, Type-specific */
 extern void MessageFinalizationRef(Ref *refReturn,
                                    Arena arena, Message message);
+extern Count MessageGetFinalizationRefs(Ref *refs, Arena arena,
+                                        Count count);
 extern Size MessageGCLiveSize(Message message);
 extern Size MessageGCCondemnedSize(Message message);
 extern Size MessageGCNotCondemnedSize(Message message);
+extern Size MessageGCCopiedSize(Message message);
+extern Size MessageGCMarkedSize(Message message);
 extern const char *MessageGCStartWhy(Message message);
 /* -- Message Method Stubs, Type-specific */
 extern void MessageNoFinalizationRef(Ref *refReturn,
@@ -339,6 +350,8 @@ extern void MessageNoFinalizationRef(Ref *refReturn,
 extern Size MessageNoGCLiveSize(Message message);
 extern Size MessageNoGCCondemnedSize(Message message);
 extern Size MessageNoGCNotCondemnedSize(Message message);
+extern Size MessageNoGCCopiedSize(Message message);
+extern Size MessageNoGCMarkedSize(Message message);
 extern const char *MessageNoGCStartWhy(Message message);
 
 
@@ -370,6 +383,8 @@ extern void ScanStateFinish(ScanState ss);
 extern Bool ScanStateCheck(ScanState ss);
 extern void ScanStateSetSummary(ScanState ss, RefSet summary);
 extern RefSet ScanStateSummary(ScanState ss);
+extern GenSet ScanStateRemembered(ScanState ss);
+extern void ScanStateAccumulate(ScanState ss, ScanState nested);
 
 /* See impl.h.mpmst.ss */
 #define ScanStateZoneShift(ss)             ((Shift)(ss)->ss_s._zs)
@@ -391,11 +406,13 @@ extern Res TraceAddWhite(Trace trace, Seg seg);
 extern void TraceCondemnStart(Trace trace);
 extern void TraceCondemnEnd(Trace trace);
 extern Res TraceStart(Trace trace, double mortality, double finishingTime);
+extern Bool TraceFirstBusy(Trace *traceReturn, Arena arena);
 extern Bool TracePoll(Work *workReturn, Bool *collectWorldReturn,
                       Globals globals, Bool collectWorldAllowed);
 
 extern Rank TraceRankForAccess(Arena arena, Seg seg);
 extern void TraceSegAccess(Arena arena, Seg seg, AccessSet mode);
+extern void TraceSoftBarrierFlush(Arena arena);
 
 extern void TraceAdvance(Trace trace);
 extern Res TraceStartCollectAll(Trace *traceReturn, Arena arena, int why);
@@ -538,6 +555,9 @@ extern void ArenaEnterRecursive(Arena arena);
 extern void ArenaLeaveRecursive(Arena arena);
 
 extern Bool (ArenaStep)(Globals globals, double interval, double multiplier);
+extern double ArenaCollectorStep(Arena arena);
+extern Res ArenaStartCollector(Arena arena);
+extern void ArenaStopCollector(Arena arena);
 extern void ArenaClamp(Globals globals);
 extern void ArenaRelease(Globals globals);
 extern void ArenaPark(Globals globals);
@@ -615,6 +635,7 @@ extern Res ArenaExtend(Arena, Addr base, Size size);
 extern void ArenaCompact(Arena arena, Trace trace);
 
 extern Res ArenaFinalize(Arena arena, Ref obj);
+extern Res ArenaFinalizeMany(Arena arena, Ref *refs, Count count);
 extern Res ArenaDefinalize(Arena arena, Ref obj);
 
 extern Res ArenaAlloc(Addr *baseReturn, LocusPref pref,
@@ -636,6 +657,8 @@ extern Bool PolicyStartTrace(Trace *traceReturn, Bool *collectWorldReturn,
                              Arena arena, Bool collectWorldAllowed);
 extern Bool PolicyPoll(Arena arena);
 extern Bool PolicyPollAgain(Arena arena, Clock start, Bool moreWork, Work tracedWork);
+extern double PolicyCollectorInterval(Arena arena, Bool moreWork,
+                                      double workTime);
 
 
 /* Locus interface */
@@ -670,6 +693,7 @@ extern Res SegSplit(Seg *segLoReturn, Seg *segHiReturn, Seg seg, Addr at);
 extern Res SegAbsDescribe(Inst seg, mps_lib_FILE *stream, Count depth);
 extern Res SegDescribe(Seg seg, mps_lib_FILE *stream, Count depth);
 extern void SegSetSummary(Seg seg, RefSet summary);
+extern void SegSetRemembered(Seg seg, GenSet remembered);
 extern Bool SegHasBuffer(Seg seg);
 extern Bool SegBuffer(Buffer *bufferReturn, Seg seg);
 extern void SegSetBuffer(Seg seg, Buffer buffer);
@@ -706,6 +730,9 @@ extern Addr (SegLimit)(Seg seg);
                                    ->segStruct))
 
 #define SegSummary(seg)         (((GCSeg)(seg))->summary)
+#define SegRemembered(seg)      (((GCSeg)(seg))->remembered)
+#define SegGenSet(seg) \
+  (IsA(GCSeg, seg) ? ((GCSeg)(seg))->genSet : GenSetEMPTY)
 
 #define SegSetPM(seg, mode)     ((void)((seg)->pm = BS_BITFIELD(Access, (mode))))
 #define SegSetSM(seg, mode)     ((void)((seg)->sm = BS_BITFIELD(Access, (mode))))
@@ -810,6 +837,9 @@ extern void FormatDestroy(Format format);
 extern Arena FormatArena(Format format);
 extern Res FormatDescribe(Format format, mps_lib_FILE *stream, Count depth);
 extern Res FormatScan(Format format, ScanState ss, Addr base, Addr limit);
+extern Res FormatScanPart(Format format, ScanState ss, Addr obj,
+                          Addr base, Addr limit);
+#define FormatCanScanPart(format) ((format)->scanPart != NULL)
 
 
 /* Reference Interface -- see <code/ref.c> */
@@ -853,6 +883,12 @@ extern Bool RankSetCheck(RankSet rankSet);
 #define ZoneSetIsMember(zs, z) BS_IS_MEMBER(zs, z)
 
 
+/* Generation sets -- see <design/write-barrier/#gen.set> */
+
+#define GenSetUnion(gs1, gs2)  BS_UNION(gs1, gs2)
+#define GenSetInter(gs1, gs2)  BS_INTER(gs1, gs2)
+
+
 extern ZoneSet ZoneSetOfRange(Arena arena, Addr base, Addr limit);
 extern ZoneSet ZoneSetOfSeg(Arena arena, Seg seg);
 typedef Bool (*RangeInZoneSet)(Addr *baseReturn, Addr *limitReturn,
@@ -175,6 +175,8 @@ static void testInArena(mps_arena_class_t arena_class, mps_arg_s *arena_args,
     MPS_ARGS_ADD(args, MPS_KEY_MVFF_ARENA_HIGH, TRUE);
     MPS_ARGS_ADD(args, MPS_KEY_MVFF_SLOT_HIGH, TRUE);
     MPS_ARGS_ADD(args, MPS_KEY_MVFF_FIRST_FIT, TRUE);
+    MPS_ARGS_ADD(args, MPS_KEY_MVFF_SEGREGATED_FIT, rnd() % 2);
+    MPS_ARGS_ADD(args, MPS_KEY_MVFF_POOL_LOCK, rnd() % 2);
     MPS_ARGS_ADD(args, MPS_KEY_SPARE, rnd_double());
     die(stress(arena, NULL, randomSize8, align, "MVFF",
                mps_class_mvff(), args), "stress MVFF");
@@ -186,6 +188,7 @@ static void testInArena(mps_arena_class_t arena_class, mps_arg_s *arena_args,
     MPS_ARGS_ADD(args, MPS_KEY_MVFF_ARENA_HIGH, TRUE);
     MPS_ARGS_ADD(args, MPS_KEY_MVFF_SLOT_HIGH, TRUE);
     MPS_ARGS_ADD(args, MPS_KEY_MVFF_FIRST_FIT, TRUE);
+    MPS_ARGS_ADD(args, MPS_KEY_MVFF_POOL_LOCK, rnd() % 2);
     MPS_ARGS_ADD(args, MPS_KEY_SPARE, rnd_double());
     MPS_ARGS_ADD(args, MPS_KEY_POOL_DEBUG_OPTIONS, options);
     die(stress(arena, options, randomSize8, align, "MVFF debug",
@@ -210,6 +213,8 @@ static void testInArena(mps_arena_class_t arena_class, mps_arg_s *arena_args,
   MPS_ARGS_BEGIN(args) {
     fixedSizeSize = 1 + rnd() % 64;
     MPS_ARGS_ADD(args, MPS_KEY_MFS_UNIT_SIZE, fixedSizeSize);
+    MPS_ARGS_ADD(args, MPS_KEY_MFS_MAGAZINE_SIZE,
+                 rnd() % 2 == 0 ? 0 : 1 + rnd() % 16);
     MPS_ARGS_ADD(args, MPS_KEY_EXTEND_BY, 100000);
     die(stress(arena, NULL, fixedSize, MPS_PF_ALIGN, "MFS",
                mps_class_mfs(), args), "stress MFS");
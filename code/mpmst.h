@@ -56,6 +56,8 @@ typedef struct mps_pool_class_s {
   PoolInitMethod init;          /* initialize the pool descriptor */
   PoolAllocMethod alloc;        /* allocate memory from pool */
   PoolFreeMethod free;          /* free memory to pool */
+  PoolTryAllocMethod tryAlloc;  /* allocate without the arena lock */
+  PoolTryFreeMethod tryFree;    /* free without the arena lock */
   PoolBufferFillMethod bufferFill;      /* out-of-line reserve */
   PoolBufferEmptyMethod bufferEmpty;    /* out-of-line commit */
   PoolAccessMethod access;      /* handles read/write accesses */
@@ -67,6 +69,7 @@ typedef struct mps_pool_class_s {
   PoolFixEmergencyMethod fixEmergency;  /* as fix, no failure allowed */
   PoolReclaimMethod reclaim;    /* reclaim dead objects after tracing */
   PoolTraceEndMethod traceEnd;  /* do something after all reclaims */
+  PoolSweepMethod sweep;        /* do some deferred reclaim work */
   PoolRampBeginMethod rampBegin;/* begin a ramp pattern */
   PoolRampEndMethod rampEnd;    /* end a ramp pattern */
   PoolFramePushMethod framePush; /* push an allocation frame */
@@ -132,6 +135,7 @@ typedef struct MFSStruct {      /* MFS outer structure */
   Size total;                   /* total size allocated from arena */
   Size free;                    /* free space in pool */
   Tract tractList;              /* the first tract */
+  struct MFSMagazinesStruct *magazines; /* magazine layer, or NULL */
   Sig sig;                      /* <design/sig/> */
 } MFSStruct;
 
@@ -183,6 +187,8 @@ typedef struct MessageClassStruct {
   MessageGCLiveSizeMethod gcLiveSize;
   MessageGCCondemnedSizeMethod gcCondemnedSize;
   MessageGCNotCondemnedSizeMethod gcNotCondemnedSize;
+  MessageGCCopiedSizeMethod gcCopiedSize;
+  MessageGCMarkedSizeMethod gcMarkedSize;
 
   /* methods specific to MessageTypeGCStart */
   MessageGCStartWhyMethod gcStartWhy;
@@ -269,8 +275,10 @@ typedef struct GCSegStruct {    /* GC segment structure */
   SegStruct segStruct;          /* superclass fields must come first */
   RingStruct greyRing;          /* link in list of grey segs */
   RefSet summary;               /* summary of references out of seg */
+  GenSet remembered;            /* <design/write-barrier/#gen.seg> */
   Buffer buffer;                /* non-NULL if seg is buffered */
   RingStruct genRing;           /* link in list of segs in gen */
+  GenSet genSet;                /* generation of seg, or empty */
   Sig sig;                      /* <design/sig/> */
 } GCSegStruct;
 
@@ -381,6 +389,7 @@ typedef struct mps_fmt_s {
   Count poolCount;              /* number of pools using the format */
   Align alignment;              /* alignment of formatted objects */
   mps_fmt_scan_t scan;
+  mps_fmt_scan_part_t scanPart; /* NULL or scans part of an object */
   mps_fmt_skip_t skip;
   mps_fmt_fwd_t move;
   mps_fmt_isfwd_t isMoved;
@@ -424,6 +433,8 @@ typedef struct ScanStateStruct {
   Rank rank;                    /* reference rank of scanning */
   Bool wasMarked;               /* design.mps.fix.protocol.was-ready */
   RefSet fixedSummary;          /* accumulated summary of fixed references */
+  Bool rememberGens;            /* <design/write-barrier/#gen.cost> */
+  GenSet fixedGens;             /* <design/write-barrier/#gen.fix> */
   STATISTIC_DECL(Count fixRefCount) /* refs which pass zone check */
   STATISTIC_DECL(Count segRefCount) /* refs which refer to segs */
   STATISTIC_DECL(Count whiteSegRefCount) /* refs which refer to white segs */
@@ -433,6 +444,9 @@ typedef struct ScanStateStruct {
   STATISTIC_DECL(Count preservedInPlaceCount) /* objects preserved in place */
   STATISTIC_DECL(Size copiedSize) /* bytes copied */
   Size scannedSize;             /* bytes scanned */
+  Size budget;                  /* <design/scan/#suspend.budget> */
+  Bool suspended;               /* <design/scan/#suspend.grey> */
+  Count nesting;                /* <design/poolamc/#copy.nesting> */
 } ScanStateStruct;
 
 
@@ -446,6 +460,7 @@ typedef struct TraceStruct {
   Arena arena;                  /* owning arena */
   int why;                      /* why the trace began */
   ZoneSet white;                /* zones in the white set */
+  GenSet whiteGens;             /* <design/write-barrier/#gen.white> */
   ZoneSet mayMove;              /* zones containing possibly moving objs */
   TraceState state;             /* current state of trace */
   Rank band;                    /* current band */
@@ -624,6 +639,27 @@ typedef struct CBSStruct {
 } CBSStruct;
 
 
+/* CBSSegFitStruct -- segregated-fit coalescing block structure
+ *
+ * CBSSegFit is a CBS that also keeps its blocks on free lists
+ * segregated by size, so that a block can be found without searching
+ * the splay tree.
+ *
+ * See <code/cbs.c#segfit>.
+ */
+
+#define CBSSegFitSig ((Sig)0x519CB5F1) /* SIGnature CBS Seg FIt */
+
+typedef struct CBSSegFitStruct {
+  CBSStruct cbsStruct;          /* superclass fields come first */
+  Shift alignShift;             /* log2 of land alignment */
+  Word binMap;                  /* bins with a non-empty sub-bin */
+  Word subBinMap[MPS_WORD_WIDTH]; /* non-empty sub-bins of each bin */
+  Ring subBins;                 /* array of sub-bin rings */
+  Sig sig;                      /* .class.end-sig */
+} CBSSegFitStruct;
+
+
 /* FailoverStruct -- fail over from one land to another
  *
  * Failover is a Land implementation that combines two other Lands,
@@ -748,6 +784,7 @@ typedef struct mps_arena_s {
   Chunk primary;                /* the primary chunk */
   RingStruct chunkRing;         /* all the chunks, in a ring for iteration */
   Tree chunkTree;               /* all the chunks, in a tree for fast lookup */
+  Chunk chunkCache[ChunkCacheLENGTH]; /* direct-mapped cache of chunkTree */
   Serial chunkSerial;           /* next chunk number */
 
   Bool hasFreeLand;              /* Is freeLand available? */
@@ -755,9 +792,15 @@ typedef struct mps_arena_s {
   CBSStruct freeLandStruct;
   ZoneSet freeZones;            /* zones not yet allocated */
   Bool zoned;                   /* use zoned allocation? */
+  Bool softBarrier;             /* <design/write-barrier/#soft> */
+  Count wbCount;                /* stores recorded in wbBuffer */
+  Addr wbBuffer[WB_SOFT_BUFFER_LENGTH]; /* <design/write-barrier/#soft.buffer> */
+  Bool backgroundCollector;     /* <design/arena/#collector> */
+  Collector collector;          /* background collector, or NULL */
 
   /* locus fields (<code/locus.c>) */
   GenDescStruct topGen;         /* generation descriptor for dynamic gen */
+  Serial genSerial;             /* serial of next generation */
 
   /* format fields (<code/format.c>) */
   RingStruct formatRing;        /* ring of formats attached to arena */
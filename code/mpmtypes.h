@@ -53,6 +53,7 @@ typedef mps_key_t Key;
 
 typedef Word RefSet;                    /* design.mps.refset */
 typedef Word ZoneSet;                   /* design.mps.refset */
+typedef Word GenSet;                    /* <design/write-barrier/#gen.set> */
 typedef unsigned Rank;
 typedef unsigned RankSet;
 typedef unsigned RootMode;
@@ -72,6 +73,7 @@ typedef struct BufferClassStruct *BufferClass; /* <design/buffer/> */
 typedef unsigned BufferMode;            /* <design/buffer/> */
 typedef struct mps_fmt_s *Format;       /* design.mps.format */
 typedef struct LockStruct *Lock;        /* <code/lock.c>* */
+typedef struct CollectorStruct *Collector; /* <code/coll.h> */
 typedef struct mps_pool_s *Pool;        /* <design/pool/> */
 typedef Pool AbstractPool;
 typedef struct mps_pool_class_s *PoolClass;  /* <code/poolclas.c> */
@@ -80,7 +82,6 @@ typedef struct ScanStateStruct *ScanState; /* <design/trace/> */
 typedef struct mps_chain_s *Chain;      /* <design/trace/> */
 typedef struct TractStruct *Tract;      /* <design/arena/> */
 typedef struct ChunkStruct *Chunk;      /* <code/tract.c> */
-typedef struct ChunkCacheEntryStruct *ChunkCacheEntry; /* <code/tract.c> */
 typedef union PageUnion *Page;          /* <code/tract.c> */
 typedef struct SegStruct *Seg;          /* <code/seg.c> */
 typedef struct GCSegStruct *GCSeg;      /* <code/seg.c> */
@@ -187,6 +188,8 @@ typedef void (*PoolVarargsMethod)(ArgStruct args[], va_list varargs);
 typedef Res (*PoolInitMethod)(Pool pool, Arena arena, PoolClass klass, ArgList args);
 typedef Res (*PoolAllocMethod)(Addr *pReturn, Pool pool, Size size);
 typedef void (*PoolFreeMethod)(Pool pool, Addr old, Size size);
+typedef Bool (*PoolTryAllocMethod)(Addr *pReturn, Pool pool, Size size);
+typedef Bool (*PoolTryFreeMethod)(Pool pool, Addr old, Size size);
 typedef Res (*PoolBufferFillMethod)(Addr *baseReturn, Addr *limitReturn,
                                     Pool pool, Buffer buffer, Size size);
 typedef void (*PoolBufferEmptyMethod)(Pool pool, Buffer buffer,
@@ -205,6 +208,7 @@ typedef Res (*PoolFixEmergencyMethod)(Pool pool, ScanState ss,
                                       Seg seg, Ref *refIO);
 typedef void (*PoolReclaimMethod)(Pool pool, Trace trace, Seg seg);
 typedef void (*PoolTraceEndMethod)(Pool pool, Trace trace);
+typedef Bool (*PoolSweepMethod)(Pool pool);
 typedef void (*PoolRampBeginMethod)(Pool pool, Buffer buf, Bool collectAll);
 typedef void (*PoolRampEndMethod)(Pool pool, Buffer buf);
 typedef Res (*PoolFramePushMethod)(AllocFrame *frameReturn,
@@ -238,6 +242,8 @@ typedef void (*MessageFinalizationRefMethod)
 typedef Size (*MessageGCLiveSizeMethod)(Message message);
 typedef Size (*MessageGCCondemnedSizeMethod)(Message message);
 typedef Size (*MessageGCNotCondemnedSizeMethod)(Message message);
+typedef Size (*MessageGCCopiedSizeMethod)(Message message);
+typedef Size (*MessageGCMarkedSizeMethod)(Message message);
 typedef const char * (*MessageGCStartWhyMethod)(Message message);
 
 /* Message Types -- <design/message/> and elsewhere */
@@ -275,6 +281,8 @@ typedef Res (*LandFindInZonesMethod)(Bool *foundReturn, Range rangeReturn, Range
 #define RefSetUNIV      BS_UNIV(RefSet)
 #define ZoneSetEMPTY    BS_EMPTY(ZoneSet)
 #define ZoneSetUNIV     BS_UNIV(ZoneSet)
+#define GenSetEMPTY     BS_EMPTY(GenSet)
+#define GenSetUNIV      BS_UNIV(GenSet)
 #define ZoneShiftUNSET  ((Shift)-1)  
 #define TraceSetEMPTY   BS_EMPTY(TraceSet)
 #define TraceSetUNIV    ((TraceSet)((1u << TraceLIMIT) - 1))
@@ -103,6 +103,7 @@
 #if defined(PLATFORM_ANSI)
 
 #include "lockan.c"     /* generic locks */
+#include "collan.c"     /* generic background collector */
 #include "than.c"       /* generic threads manager */
 #include "vman.c"       /* malloc-based pseudo memory mapping */
 #include "protan.c"     /* generic memory protection */
@@ -115,6 +116,7 @@
 #elif defined(MPS_PF_XCI3LL) || defined(MPS_PF_XCI3GC)
 
 #include "lockix.c"     /* Posix locks */
+#include "collix.c"     /* Posix background collector */
 #include "thxc.c"       /* OS X Mach threading */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
@@ -129,6 +131,7 @@
 #elif defined(MPS_PF_XCI6LL) || defined(MPS_PF_XCI6GC)
 
 #include "lockix.c"     /* Posix locks */
+#include "collix.c"     /* Posix background collector */
 #include "thxc.c"       /* OS X Mach threading */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
@@ -143,6 +146,7 @@
 #elif defined(MPS_PF_FRI3GC) || defined(MPS_PF_FRI3LL)
 
 #include "lockix.c"     /* Posix locks */
+#include "collix.c"     /* Posix background collector */
 #include "thix.c"       /* Posix threading */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
@@ -158,6 +162,7 @@
 #elif defined(MPS_PF_FRI6GC) || defined(MPS_PF_FRI6LL)
 
 #include "lockix.c"     /* Posix locks */
+#include "collix.c"     /* Posix background collector */
 #include "thix.c"       /* Posix threading */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
@@ -173,11 +178,13 @@
 #elif defined(MPS_PF_LII3GC)
 
 #include "lockix.c"     /* Posix locks */
+#include "collix.c"     /* Posix background collector */
 #include "thix.c"       /* Posix threading */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
 #include "protli.c"     /* Linux protection */
+#include "protuffd.c"   /* Linux userfaultfd protection */
 #include "proti3.c"     /* 32-bit Intel mutator context */
 #include "prmci3li.c"   /* 32-bit Intel for Linux mutator context */
 #include "span.c"       /* generic stack probe */
@@ -188,11 +195,13 @@
 #elif defined(MPS_PF_LII6GC) || defined(MPS_PF_LII6LL)
 
 #include "lockix.c"     /* Posix locks */
+#include "collix.c"     /* Posix background collector */
 #include "thix.c"       /* Posix threading */
 #include "pthrdext.c"   /* Posix thread extensions */
 #include "vmix.c"       /* Posix virtual memory */
 #include "protix.c"     /* Posix protection */
 #include "protli.c"     /* Linux protection */
+#include "protuffd.c"   /* Linux userfaultfd protection */
 #include "proti6.c"     /* 64-bit Intel mutator context */
 #include "prmci6li.c"   /* 64-bit Intel for Linux mutator context */
 #include "span.c"       /* generic stack probe */
@@ -203,6 +212,7 @@
 #elif defined(MPS_PF_W3I3MV)
 
 #include "lockw3.c"     /* Windows locks */
+#include "collw3.c"     /* Windows background collector */
 #include "thw3.c"       /* Windows threading */
 #include "thw3i3.c"     /* Windows on 32-bit Intel thread stack scan */
 #include "vmw3.c"       /* Windows virtual memory */
@@ -218,6 +228,7 @@
 #elif defined(MPS_PF_W3I6MV)
 
 #include "lockw3.c"     /* Windows locks */
+#include "collw3.c"     /* Windows background collector */
 #include "thw3.c"       /* Windows threading */
 #include "thw3i6.c"     /* Windows on 64-bit Intel thread stack scan */
 #include "vmw3.c"       /* Windows virtual memory */
@@ -233,6 +244,7 @@
 #elif defined(MPS_PF_W3I3PC)
 
 #include "lockw3.c"     /* Windows locks */
+#include "collw3.c"     /* Windows background collector */
 #include "thw3.c"       /* Windows threading */
 #include "thw3i3.c"     /* Windows on 32-bit Intel thread stack scan */
 #include "vmw3.c"       /* Windows virtual memory */
@@ -248,6 +260,7 @@
 #elif defined(MPS_PF_W3I6PC)
 
 #include "lockw3.c"     /* Windows locks */
+#include "collw3.c"     /* Windows background collector */
 #include "thw3.c"       /* Windows threading */
 #include "thw3i6.c"     /* Windows on 64-bit Intel thread stack scan */
 #include "vmw3.c"       /* Windows virtual memory */
@@ -111,6 +111,8 @@ typedef struct mps_scan_tag_s {
 typedef mps_res_t (*mps_root_scan_t)(mps_ss_t, void *, size_t);
 typedef mps_res_t (*mps_area_scan_t)(mps_ss_t, void *, void *, void *);
 typedef mps_res_t (*mps_fmt_scan_t)(mps_ss_t, mps_addr_t, mps_addr_t);
+typedef mps_res_t (*mps_fmt_scan_part_t)(mps_ss_t, mps_addr_t,
+                                         mps_addr_t, mps_addr_t);
 typedef mps_res_t (*mps_reg_scan_t)(mps_ss_t, mps_thr_t,
                                     void *, size_t);
 typedef mps_addr_t (*mps_fmt_skip_t)(mps_addr_t);
@@ -149,6 +151,7 @@ typedef struct mps_arg_s {
     void *p;
     mps_rank_t rank;
     mps_fmt_scan_t fmt_scan;
+    mps_fmt_scan_part_t fmt_scan_part;
     mps_fmt_skip_t fmt_skip;
     mps_fmt_fwd_t fmt_fwd;
     mps_fmt_isfwd_t fmt_isfwd;
@@ -171,6 +174,12 @@ extern const struct mps_key_s _mps_key_ARENA_SIZE;
 extern const struct mps_key_s _mps_key_ARENA_ZONED;
 #define MPS_KEY_ARENA_ZONED     (&_mps_key_ARENA_ZONED)
 #define MPS_KEY_ARENA_ZONED_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_SOFT_BARRIER;
+#define MPS_KEY_ARENA_SOFT_BARRIER (&_mps_key_ARENA_SOFT_BARRIER)
+#define MPS_KEY_ARENA_SOFT_BARRIER_FIELD b
+extern const struct mps_key_s _mps_key_ARENA_BACKGROUND_COLLECTOR;
+#define MPS_KEY_ARENA_BACKGROUND_COLLECTOR (&_mps_key_ARENA_BACKGROUND_COLLECTOR)
+#define MPS_KEY_ARENA_BACKGROUND_COLLECTOR_FIELD b
 extern const struct mps_key_s _mps_key_FORMAT;
 #define MPS_KEY_FORMAT          (&_mps_key_FORMAT)
 #define MPS_KEY_FORMAT_FIELD    format
@@ -217,6 +226,9 @@ extern const struct mps_key_s _mps_key_SPARE;
 extern const struct mps_key_s _mps_key_INTERIOR;
 #define MPS_KEY_INTERIOR        (&_mps_key_INTERIOR)
 #define MPS_KEY_INTERIOR_FIELD  b
+extern const struct mps_key_s _mps_key_SAC_TABLE_LIMIT;
+#define MPS_KEY_SAC_TABLE_LIMIT (&_mps_key_SAC_TABLE_LIMIT)
+#define MPS_KEY_SAC_TABLE_LIMIT_FIELD size
 
 extern const struct mps_key_s _mps_key_VMW3_TOP_DOWN;
 #define MPS_KEY_VMW3_TOP_DOWN   (&_mps_key_VMW3_TOP_DOWN)
@@ -231,6 +243,9 @@ extern const struct mps_key_s _mps_key_FMT_HEADER_SIZE;
 extern const struct mps_key_s _mps_key_FMT_SCAN;
 #define MPS_KEY_FMT_SCAN   (&_mps_key_FMT_SCAN)
 #define MPS_KEY_FMT_SCAN_FIELD fmt_scan
+extern const struct mps_key_s _mps_key_FMT_SCAN_PART;
+#define MPS_KEY_FMT_SCAN_PART   (&_mps_key_FMT_SCAN_PART)
+#define MPS_KEY_FMT_SCAN_PART_FIELD fmt_scan_part
 extern const struct mps_key_s _mps_key_FMT_SKIP;
 #define MPS_KEY_FMT_SKIP   (&_mps_key_FMT_SKIP)
 #define MPS_KEY_FMT_SKIP_FIELD fmt_skip
@@ -330,6 +345,7 @@ typedef struct mps_ap_s {       /* allocation point descriptor */
 typedef struct _mps_sac_s *mps_sac_t;
 
 #define MPS_SAC_CLASS_LIMIT ((size_t)8)
+#define MPS_SAC_TABLE_CLASS_LIMIT ((size_t)127)
 
 typedef struct _mps_sac_freelist_block_s {
   size_t _size;
@@ -341,6 +357,9 @@ typedef struct _mps_sac_freelist_block_s {
 typedef struct _mps_sac_s {
   size_t _middle;
   mps_bool_t _trapped;
+  size_t _table_limit;          /* look up sizes up to this in _table */
+  size_t _table_shift;          /* log2 of the sizes per table entry */
+  const unsigned char *_table;  /* freelist index for each size */
   _mps_sac_freelist_block_s _freelists[2 * MPS_SAC_CLASS_LIMIT];
 } _mps_sac_s;
 
@@ -465,6 +484,7 @@ extern mps_bool_t mps_arena_busy(mps_arena_t);
 extern mps_bool_t mps_arena_has_addr(mps_arena_t, mps_addr_t);
 extern mps_bool_t mps_addr_pool(mps_pool_t *, mps_arena_t, mps_addr_t);
 extern mps_bool_t mps_addr_fmt(mps_fmt_t *, mps_arena_t, mps_addr_t);
+extern void mps_write_barrier(mps_arena_t, mps_addr_t);
 
 /* Client memory arenas */
 extern mps_res_t mps_arena_extend(mps_arena_t, mps_addr_t, size_t);
@@ -554,29 +574,46 @@ extern mps_res_t mps_ap_alloc_pattern_reset(mps_ap_t);
 
 extern mps_res_t mps_sac_create(mps_sac_t *, mps_pool_t, size_t,
                                 mps_sac_classes_s *);
+extern mps_res_t mps_sac_create_k(mps_sac_t *, mps_pool_t, size_t,
+                                  mps_sac_classes_s *, mps_arg_s []);
 extern void mps_sac_destroy(mps_sac_t);
 extern mps_res_t mps_sac_alloc(mps_addr_t *, mps_sac_t, size_t, mps_bool_t);
 extern void mps_sac_free(mps_sac_t, mps_addr_t, size_t);
 extern void mps_sac_flush(mps_sac_t);
+extern void mps_sac_free_remote(mps_sac_t, mps_addr_t, size_t);
 
 /* Direct access to mps_sac_fill and mps_sac_empty is not supported. */
 extern mps_res_t mps_sac_fill(mps_addr_t *, mps_sac_t, size_t, mps_bool_t);
 extern void mps_sac_empty(mps_sac_t, mps_addr_t, size_t);
 
+/* _MPS_SAC_FIND -- find the freelist index for a size
+ *
+ * Sizes up to _table_limit are looked up in the table.  Size 0 wraps
+ * round and misses the table.  Other sizes are found by searching up
+ * or down from the middle.
+ */
+
+#define _MPS_SAC_FIND(i_o, sac, s) \
+  MPS_BEGIN \
+    if ((s) - 1 < (sac)->_table_limit) { \
+      (i_o) = (sac)->_table[((s) - 1) >> (sac)->_table_shift]; \
+    } else if ((s) > (sac)->_middle) { \
+      (i_o) = 0; \
+      while ((s) > (sac)->_freelists[i_o]._size) \
+        (i_o) += 2; \
+    } else { \
+      (i_o) = 1; \
+      while ((s) <= (sac)->_freelists[i_o]._size) \
+        (i_o) += 2; \
+    } \
+  MPS_END
+
 #define MPS_SAC_ALLOC_FAST(res_o, p_o, sac, size, has_reservoir_permit) \
   MPS_BEGIN \
     size_t _mps_i, _mps_s; \
     \
     _mps_s = (size); \
-    if (_mps_s > (sac)->_middle) { \
-      _mps_i = 0; \
-      while (_mps_s > (sac)->_freelists[_mps_i]._size) \
-        _mps_i += 2; \
-    } else { \
-      _mps_i = 1; \
-      while (_mps_s <= (sac)->_freelists[_mps_i]._size) \
-        _mps_i += 2; \
-    } \
+    _MPS_SAC_FIND(_mps_i, sac, _mps_s); \
     if ((sac)->_freelists[_mps_i]._count != 0) { \
       (p_o) = (sac)->_freelists[_mps_i]._blocks; \
       (sac)->_freelists[_mps_i]._blocks = *(mps_addr_t *)(p_o); \
@@ -592,15 +629,7 @@ extern void mps_sac_empty(mps_sac_t, mps_addr_t, size_t);
     size_t _mps_i, _mps_s; \
     \
     _mps_s = (size); \
-    if (_mps_s > (sac)->_middle) { \
-      _mps_i = 0; \
-      while (_mps_s > (sac)->_freelists[_mps_i]._size) \
-        _mps_i += 2; \
-    } else { \
-      _mps_i = 1; \
-      while (_mps_s <= (sac)->_freelists[_mps_i]._size) \
-        _mps_i += 2; \
-    } \
+    _MPS_SAC_FIND(_mps_i, sac, _mps_s); \
     if ((sac)->_freelists[_mps_i]._count \
         < (sac)->_freelists[_mps_i]._count_max) { \
        *(mps_addr_t *)(p) = (sac)->_freelists[_mps_i]._blocks; \
@@ -748,12 +777,16 @@ extern mps_clock_t mps_message_clock(mps_arena_t, mps_message_t);
 /* -- mps_message_type_finalization */
 extern void mps_message_finalization_ref(mps_addr_t *,
                                          mps_arena_t, mps_message_t);
+extern size_t mps_message_get_finalization_refs(mps_arena_t,
+                                                mps_addr_t *, size_t);
 
 /* -- mps_message_type_gc */
 extern size_t mps_message_gc_live_size(mps_arena_t, mps_message_t);
 extern size_t mps_message_gc_condemned_size(mps_arena_t, mps_message_t);
 extern size_t mps_message_gc_not_condemned_size(mps_arena_t,
                                                 mps_message_t);
+extern size_t mps_message_gc_copied_size(mps_arena_t, mps_message_t);
+extern size_t mps_message_gc_marked_size(mps_arena_t, mps_message_t);
 
 /* -- mps_message_type_gc_start */
 extern const char *mps_message_gc_start_why(mps_arena_t, mps_message_t);
@@ -762,6 +795,7 @@ extern const char *mps_message_gc_start_why(mps_arena_t, mps_message_t);
 /* Finalization */
 
 extern mps_res_t mps_finalize(mps_arena_t, mps_addr_t *);
+extern mps_res_t mps_finalize_many(mps_arena_t, mps_addr_t *, size_t);
 extern mps_res_t mps_definalize(mps_arena_t, mps_addr_t *);
 
 
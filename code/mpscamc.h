@@ -12,6 +12,16 @@
 extern mps_pool_class_t mps_class_amc(void);
 extern mps_pool_class_t mps_class_amcz(void);
 
+extern const struct mps_key_s _mps_key_AMC_MARK_THRESHOLD;
+#define MPS_KEY_AMC_MARK_THRESHOLD (&_mps_key_AMC_MARK_THRESHOLD)
+#define MPS_KEY_AMC_MARK_THRESHOLD_FIELD d
+extern const struct mps_key_s _mps_key_AMC_COPY_DEPTH;
+#define MPS_KEY_AMC_COPY_DEPTH (&_mps_key_AMC_COPY_DEPTH)
+#define MPS_KEY_AMC_COPY_DEPTH_FIELD count
+extern const struct mps_key_s _mps_key_AMC_PRETENURE;
+#define MPS_KEY_AMC_PRETENURE (&_mps_key_AMC_PRETENURE)
+#define MPS_KEY_AMC_PRETENURE_FIELD b
+
 typedef void (*mps_amc_apply_stepper_t)(mps_addr_t, void *, size_t);
 extern void mps_amc_apply(mps_pool_t, mps_amc_apply_stepper_t,
                           void *, size_t);
@@ -12,11 +12,16 @@
 extern const struct mps_key_s _mps_key_AWL_FIND_DEPENDENT;
 #define MPS_KEY_AWL_FIND_DEPENDENT (&_mps_key_AWL_FIND_DEPENDENT)
 #define MPS_KEY_AWL_FIND_DEPENDENT_FIELD addr_method
+extern const struct mps_key_s _mps_key_AWL_SINGLE_ACCESS_LIMIT;
+#define MPS_KEY_AWL_SINGLE_ACCESS_LIMIT (&_mps_key_AWL_SINGLE_ACCESS_LIMIT)
+#define MPS_KEY_AWL_SINGLE_ACCESS_LIMIT_FIELD count
 
 extern mps_pool_class_t mps_class_awl(void);
 
 typedef mps_addr_t (*mps_awl_find_dependent_t)(mps_addr_t addr);
 
+extern void mps_awl_scan_segment_hint(mps_pool_t, mps_addr_t);
+
 #endif /* mpscawl_h */
 
 
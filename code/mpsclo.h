@@ -10,6 +10,13 @@
 
 #include "mps.h"
 
+extern const struct mps_key_s _mps_key_LO_LAZY_SWEEP;
+#define MPS_KEY_LO_LAZY_SWEEP (&_mps_key_LO_LAZY_SWEEP)
+#define MPS_KEY_LO_LAZY_SWEEP_FIELD b
+extern const struct mps_key_s _mps_key_LO_SIZE_CLASSES;
+#define MPS_KEY_LO_SIZE_CLASSES (&_mps_key_LO_SIZE_CLASSES)
+#define MPS_KEY_LO_SIZE_CLASSES_FIELD b
+
 extern mps_pool_class_t mps_class_lo(void);
 
 #endif /* mpsclo_h */
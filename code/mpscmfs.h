@@ -12,6 +12,9 @@
 extern const struct mps_key_s _mps_key_MFS_UNIT_SIZE;
 #define MPS_KEY_MFS_UNIT_SIZE (&_mps_key_MFS_UNIT_SIZE)
 #define MPS_KEY_MFS_UNIT_SIZE_FIELD size
+extern const struct mps_key_s _mps_key_MFS_MAGAZINE_SIZE;
+#define MPS_KEY_MFS_MAGAZINE_SIZE (&_mps_key_MFS_MAGAZINE_SIZE)
+#define MPS_KEY_MFS_MAGAZINE_SIZE_FIELD count
 
 extern mps_pool_class_t mps_class_mfs(void);
 
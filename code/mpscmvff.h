@@ -18,6 +18,12 @@ extern const struct mps_key_s _mps_key_MVFF_ARENA_HIGH;
 extern const struct mps_key_s _mps_key_MVFF_FIRST_FIT;
 #define MPS_KEY_MVFF_FIRST_FIT (&_mps_key_MVFF_FIRST_FIT)
 #define MPS_KEY_MVFF_FIRST_FIT_FIELD b
+extern const struct mps_key_s _mps_key_MVFF_SEGREGATED_FIT;
+#define MPS_KEY_MVFF_SEGREGATED_FIT (&_mps_key_MVFF_SEGREGATED_FIT)
+#define MPS_KEY_MVFF_SEGREGATED_FIT_FIELD b
+extern const struct mps_key_s _mps_key_MVFF_POOL_LOCK;
+#define MPS_KEY_MVFF_POOL_LOCK (&_mps_key_MVFF_POOL_LOCK)
+#define MPS_KEY_MVFF_POOL_LOCK_FIELD b
 
 #define mps_mvff_free_size mps_pool_free_size
 #define mps_mvff_size mps_pool_total_size
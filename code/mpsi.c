@@ -35,6 +35,12 @@
  * ArenaPoll to allow the MPM to "steal" CPU time and get on with
  * background tasks such as incremental GC.
  *
+ * .try: mps_alloc and mps_free first offer the request to the pool
+ * without entering the arena, so that a pool with its own lock can
+ * serve it without serializing the client's threads on the arena
+ * lock.  Requests served this way don't poll (.poll).  See
+ * <design/pool/#lock>.
+ *
  * .root-mode: (rule.universal.complete) The root "mode", which
  * specifies things like the protectability of roots, is ignored at
  * present.  This is because the MPM doesn't ever try to protect them.
@@ -369,6 +375,14 @@ mps_res_t mps_arena_create_k(mps_arena_t *mps_arena_o,
     return (mps_res_t)res;
 
   ArenaLeave(arena);
+
+  res = ArenaStartCollector(arena);
+  if (res != ResOK) {
+    ArenaEnter(arena);
+    ArenaDestroy(arena);
+    return (mps_res_t)res;
+  }
+
   *mps_arena_o = (mps_arena_t)arena;
   return MPS_RES_OK;
 }
@@ -378,6 +392,9 @@ mps_res_t mps_arena_create_k(mps_arena_t *mps_arena_o,
 
 void mps_arena_destroy(mps_arena_t arena)
 {
+  /* The background collector must be stopped before entering the
+     arena, because it might be waiting for the arena lock. */
+  ArenaStopCollector(arena);
   ArenaEnter(arena);
   ArenaDestroy(arena);
 }
@@ -411,6 +428,42 @@ mps_bool_t mps_arena_has_addr(mps_arena_t arena, mps_addr_t p)
 }
 
 
+/* mps_write_barrier -- note that a reference has been stored
+ *
+ * The store is recorded in the arena's buffer without the arena lock,
+ * which is safe because an arena with the software barrier has at most
+ * one registered thread.  The collector applies the recorded stores
+ * before it relies on a summary.  Consecutive stores to the same arena
+ * grain are recorded once.  See <design/write-barrier/#soft.buffer>.
+ */
+
+void mps_write_barrier(mps_arena_t arena, mps_addr_t p)
+{
+  Addr grain;
+  Count i;
+
+  /* The barrier mode is fixed when the arena is created, so it can be
+     tested without the arena lock, making the call cheap in arenas
+     that use the hardware barrier. */
+  AVER(TESTT(Arena, arena));
+  if (!arena->softBarrier)
+    return;
+
+  grain = AddrAlignDown((Addr)p, ArenaGrainSize(arena));
+  i = arena->wbCount;
+  if (i > 0 && arena->wbBuffer[i - 1] == grain)
+    return;
+  arena->wbBuffer[i] = grain;
+  arena->wbCount = ++i;
+
+  if (i == WB_SOFT_BUFFER_LENGTH) {
+    ArenaEnter(arena);
+    TraceSoftBarrierFlush(arena);
+    ArenaLeave(arena);
+  }
+}
+
+
 /* mps_addr_pool -- return the pool containing the given address
  *
  * Wrapper for PoolOfAddr.  Note: may return an MPS-internal pool.
@@ -766,15 +819,20 @@ mps_res_t mps_alloc(mps_addr_t *p_o, mps_pool_t pool, size_t size)
   Res res;
 
   AVER_CRITICAL(TESTT(Pool, pool));
+  AVER_CRITICAL(p_o != NULL);
+  AVER_CRITICAL(size > 0);
   arena = PoolArena(pool);
 
+  if (PoolTryAlloc(&p, pool, size)) { /* .try */
+    *p_o = (mps_addr_t)p;
+    return MPS_RES_OK;
+  }
+
   ArenaEnter(arena);
 
   ArenaPoll(ArenaGlobals(arena)); /* .poll */
 
-  AVER_CRITICAL(p_o != NULL);
   AVERT_CRITICAL(Pool, pool);
-  AVER_CRITICAL(size > 0);
   /* Note: class may allow unaligned size, see */
   /* <design/class-interface/#alloc.size.align>. */
   /* Rest ignored, see .varargs. */
@@ -808,14 +866,17 @@ void mps_free(mps_pool_t pool, mps_addr_t p, size_t size)
   Arena arena;
 
   AVER_CRITICAL(TESTT(Pool, pool));
+  AVER_CRITICAL(size > 0);
+  /* Note: class may allow unaligned size, see */
+  /* <design/class-interface/#alloc.size.align>. */
   arena = PoolArena(pool);
 
+  if (PoolTryFree(pool, (Addr)p, size)) /* .try */
+    return;
+
   ArenaEnter(arena);
 
   AVERT_CRITICAL(Pool, pool);
-  AVER_CRITICAL(size > 0);
-  /* Note: class may allow unaligned size, see */
-  /* <design/class-interface/#alloc.size.align>. */
 
   PoolFree(pool, (Addr)p, size);
   ArenaLeave(arena);
@@ -1145,7 +1206,35 @@ mps_res_t mps_sac_create(mps_sac_t *mps_sac_o, mps_pool_t pool,
 
   ArenaEnter(arena);
 
-  res = SACCreate(&sac, pool, (Count)classes_count, classes);
+  res = SACCreate(&sac, pool, (Count)classes_count, classes, mps_args_none);
+
+  ArenaLeave(arena);
+
+  if (res != ResOK)
+    return (mps_res_t)res;
+  *mps_sac_o = ExternalSACOfSAC(sac);
+  return (mps_res_t)res;
+}
+
+
+/* mps_sac_create_k -- create an SAC object with keyword arguments */
+
+mps_res_t mps_sac_create_k(mps_sac_t *mps_sac_o, mps_pool_t pool,
+                           size_t classes_count, mps_sac_classes_s *classes,
+                           mps_arg_s args[])
+{
+  Arena arena;
+  SAC sac;
+  Res res;
+
+  AVER(mps_sac_o != NULL);
+  AVER(TESTT(Pool, pool));
+  arena = PoolArena(pool);
+
+  ArenaEnter(arena);
+
+  AVERT(ArgList, args);
+  res = SACCreate(&sac, pool, (Count)classes_count, classes, args);
 
   ArenaLeave(arena);
 
@@ -1266,6 +1355,23 @@ void mps_sac_free(mps_sac_t mps_sac, mps_addr_t p, size_t size)
 }
 
 
+/* mps_sac_free_remote -- free an object to another thread's SAC
+ *
+ * Doesn't take the arena lock: see <code/sac.c#remote>.
+ */
+
+void mps_sac_free_remote(mps_sac_t mps_sac, mps_addr_t p, size_t size)
+{
+  SAC sac = SACOfExternalSAC(mps_sac);
+
+  AVER(TESTT(SAC, sac));
+  /* Can't check p outside arena lock */
+  AVER(size > 0);
+
+  SACFreeRemote(sac, (Addr)p, (Size)size);
+}
+
+
 /* Roots */
 
 
@@ -1618,7 +1724,13 @@ mps_res_t mps_thread_reg(mps_thr_t *mps_thr_o, mps_arena_t arena)
   AVER(mps_thr_o != NULL);
   AVERT(Arena, arena);
 
-  res = ThreadRegister(&thread, arena);
+  /* mps_write_barrier records stores without the arena lock, so it
+     can't allow for a second thread.  See
+     <design/write-barrier/#soft.threads>. */
+  if (arena->softBarrier && !RingIsSingle(ArenaThreadRing(arena)))
+    res = ResPARAM;
+  else
+    res = ThreadRegister(&thread, arena);
 
   ArenaLeave(arena);
 
@@ -1728,6 +1840,22 @@ mps_res_t mps_finalize(mps_arena_t arena, mps_addr_t *refref)
 }
 
 
+/* mps_finalize_many -- register many objects for finalization */
+
+mps_res_t mps_finalize_many(mps_arena_t arena, mps_addr_t *refs,
+                            size_t count)
+{
+  Res res;
+
+  ArenaEnter(arena);
+
+  res = ArenaFinalizeMany(arena, (Ref *)refs, count);
+
+  ArenaLeave(arena);
+  return (mps_res_t)res;
+}
+
+
 /* mps_definalize -- deregister for finalization */
 
 mps_res_t mps_definalize(mps_arena_t arena, mps_addr_t *refref)
@@ -1883,6 +2011,21 @@ void mps_message_finalization_ref(mps_addr_t *mps_addr_return,
   ArenaLeave(arena);
 }
 
+size_t mps_message_get_finalization_refs(mps_arena_t arena,
+                                         mps_addr_t *refs, size_t count)
+{
+  Count got;
+
+  AVER(refs != NULL);
+
+  ArenaEnter(arena);
+
+  got = MessageGetFinalizationRefs((Ref *)refs, arena, count);
+
+  ArenaLeave(arena);
+  return got;
+}
+
 /* -- mps_message_type_gc */
 
 size_t mps_message_gc_live_size(mps_arena_t arena,
@@ -1927,6 +2070,34 @@ size_t mps_message_gc_not_condemned_size(mps_arena_t arena,
   return (size_t)size;
 }
 
+size_t mps_message_gc_copied_size(mps_arena_t arena,
+                                  mps_message_t message)
+{
+  Size size;
+
+  ArenaEnter(arena);
+
+  AVERT(Arena, arena);
+  size = MessageGCCopiedSize(message);
+
+  ArenaLeave(arena);
+  return (size_t)size;
+}
+
+size_t mps_message_gc_marked_size(mps_arena_t arena,
+                                  mps_message_t message)
+{
+  Size size;
+
+  ArenaEnter(arena);
+
+  AVERT(Arena, arena);
+  size = MessageGCMarkedSize(message);
+
+  ArenaLeave(arena);
+  return (size_t)size;
+}
+
 /* -- mps_message_type_gc_start */
 
 const char *mps_message_gc_start_why(mps_arena_t arena,
@@ -379,6 +379,37 @@ Bool PolicyPoll(Arena arena)
 }
 
 
+/* PolicyCollectorInterval -- how long should the background collector wait?
+ *
+ * Return the time, in seconds, that the background collector should
+ * wait before its next step.  moreWork is TRUE if the last step
+ * stopped because it ran out of time rather than work, and workTime
+ * is the time it spent working.  See <design/arena/#collector.interval>.
+ */
+
+double PolicyCollectorInterval(Arena arena, Bool moreWork, double workTime)
+{
+  double interval;
+
+  AVERT(Arena, arena);
+  AVER(workTime >= 0.0);
+
+  /* Hold the arena lock for at most half the time, so that mutators
+     needing it aren't kept waiting. */
+  if (moreWork)
+    return workTime;
+
+  /* Nothing to do.  Check again after a fraction of the time it
+     would take to collect the world, so that a generation going over
+     capacity is noticed promptly without polling a big quiet heap
+     too often. */
+  interval = policyCollectionTime(arena) * ARENA_MAX_COLLECT_FRACTION;
+  if (interval > ARENA_COLLECTOR_MAX_INTERVAL)
+    interval = ARENA_COLLECTOR_MAX_INTERVAL;
+  return interval;
+}
+
+
 /* PolicyPollAgain -- do another unit of work?
  *
  * Return TRUE if the MPS should do another unit of work; FALSE if it
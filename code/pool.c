@@ -45,6 +45,8 @@ Bool PoolClassCheck(PoolClass klass)
   CHECKL(FUNCHECK(klass->init));
   CHECKL(FUNCHECK(klass->alloc));
   CHECKL(FUNCHECK(klass->free));
+  CHECKL(FUNCHECK(klass->tryAlloc));
+  CHECKL(FUNCHECK(klass->tryFree));
   CHECKL(FUNCHECK(klass->bufferFill));
   CHECKL(FUNCHECK(klass->bufferEmpty));
   CHECKL(FUNCHECK(klass->access));
@@ -56,6 +58,7 @@ Bool PoolClassCheck(PoolClass klass)
   CHECKL(FUNCHECK(klass->fixEmergency));
   CHECKL(FUNCHECK(klass->reclaim));
   CHECKL(FUNCHECK(klass->traceEnd));
+  CHECKL(FUNCHECK(klass->sweep));
   CHECKL(FUNCHECK(klass->rampBegin));
   CHECKL(FUNCHECK(klass->rampEnd));
   CHECKL(FUNCHECK(klass->framePush));
@@ -71,6 +74,8 @@ Bool PoolClassCheck(PoolClass klass)
   /* Check that pool classes overide sets of related methods. */
   CHECKL((klass->init == PoolAbsInit) ==
          (klass->instClassStruct.finish == PoolAbsFinish));
+  CHECKL((klass->tryAlloc == PoolTrivTryAlloc) ==
+         (klass->tryFree == PoolTrivTryFree));
   CHECKL((klass->bufferFill == PoolNoBufferFill) ==
          (klass->bufferEmpty == PoolNoBufferEmpty));
   CHECKL((klass->framePush == PoolNoFramePush) ==
@@ -278,6 +283,38 @@ void PoolFree(Pool pool, Addr old, Size size)
 }
 
 
+/* PoolTryAlloc, PoolTryFree -- allocate or free without the arena lock
+ *
+ * These are called by mps_alloc and mps_free *without* entering the
+ * arena.  They return TRUE if the pool did the work under its own
+ * lock, or FALSE if the caller must enter the arena and call
+ * PoolAlloc or PoolFree instead.  See <design/pool/#lock>.
+ *
+ * .try.unlocked: Nothing here may look at state that is protected by
+ * the arena lock, so the pool is only checked for its signature,
+ * the allocation clock isn't advanced, and no events are emitted.
+ */
+
+Bool PoolTryAlloc(Addr *pReturn, Pool pool, Size size)
+{
+  AVER_CRITICAL(pReturn != NULL);
+  AVER_CRITICAL(TESTT(Pool, pool));
+  AVER_CRITICAL(size > 0);
+
+  return Method(Pool, pool, tryAlloc)(pReturn, pool, size);
+}
+
+Bool PoolTryFree(Pool pool, Addr old, Size size)
+{
+  AVER_CRITICAL(TESTT(Pool, pool));
+  AVER_CRITICAL(old != NULL);
+  AVER_CRITICAL(size > 0);
+  AVER_CRITICAL(AddrIsAligned(old, pool->alignment));
+
+  return Method(Pool, pool, tryFree)(pool, old, size);
+}
+
+
 Res PoolAccess(Pool pool, Seg seg, Addr addr,
                AccessSet mode, MutatorFaultContext context)
 {
@@ -424,6 +461,22 @@ void PoolTraceEnd(Pool pool, Trace trace)
 }
 
 
+/* PoolSweep -- do some deferred reclaim work
+ *
+ * A pool class that defers some of the work of reclaiming segments
+ * until after the trace has finished (for example, LO with lazy
+ * sweeping, see <design/poollo/#sweep.lazy>) does a bounded amount of
+ * it, and returns TRUE if there was any to do.  Called by ArenaStep
+ * when there's no collection work to do.
+ */
+
+Bool PoolSweep(Pool pool)
+{
+  AVERT(Pool, pool);
+  return Method(Pool, pool, sweep)(pool);
+}
+
+
 /* PoolAddrObject -- find client pointer to object containing addr
  * See user documentation for mps_addr_object.
  * addr is known to belong to seg, which belongs to pool.
@@ -195,6 +195,8 @@ DEFINE_CLASS(Pool, AbstractPool, klass)
   klass->init = PoolAbsInit;
   klass->alloc = PoolNoAlloc;
   klass->free = PoolNoFree;
+  klass->tryAlloc = PoolTrivTryAlloc;
+  klass->tryFree = PoolTrivTryFree;
   klass->bufferFill = PoolNoBufferFill;
   klass->bufferEmpty = PoolNoBufferEmpty;
   klass->access = PoolNoAccess;
@@ -206,6 +208,7 @@ DEFINE_CLASS(Pool, AbstractPool, klass)
   klass->fixEmergency = PoolNoFix;
   klass->reclaim = PoolNoReclaim;
   klass->traceEnd = PoolTrivTraceEnd;
+  klass->sweep = PoolTrivSweep;
   klass->rampBegin = PoolNoRampBegin;
   klass->rampEnd = PoolNoRampEnd;
   klass->framePush = PoolNoFramePush;
@@ -299,6 +302,22 @@ void PoolTrivFree(Pool pool, Addr old, Size size)
   NOOP;                         /* trivial free has no effect */
 }
 
+Bool PoolTrivTryAlloc(Addr *pReturn, Pool pool, Size size)
+{
+  AVER(pReturn != NULL);
+  AVER(TESTT(Pool, pool));      /* see <code/pool.c#try.unlocked> */
+  AVER(size > 0);
+  return FALSE;                 /* always enter the arena */
+}
+
+Bool PoolTrivTryFree(Pool pool, Addr old, Size size)
+{
+  AVER(TESTT(Pool, pool));      /* see <code/pool.c#try.unlocked> */
+  AVER(old != NULL);
+  AVER(size > 0);
+  return FALSE;                 /* always enter the arena */
+}
+
 
 Res PoolNoBufferFill(Addr *baseReturn, Addr *limitReturn,
                      Pool pool, Buffer buffer, Size size)
@@ -525,6 +544,11 @@ Res PoolSingleAccess(Pool pool, Seg seg, Addr addr,
     /* .tagging: ought to check the reference for a tag.  But
      * this is conservative. */
     SegSetSummary(seg, RefSetAdd(arena, SegSummary(seg), ref));
+    if (SegSummary(seg) != RefSetUNIV) {
+      ZoneSet zones = ZoneSetAddAddr(arena, ZoneSetEMPTY, ref);
+      SegSetRemembered(seg, GenSetUnion(SegRemembered(seg),
+                                        GenSetOfZones(arena, zones)));
+    }
 
     ShieldCover(arena, seg);
 
@@ -637,6 +661,12 @@ void PoolTrivTraceEnd(Pool pool, Trace trace)
   NOOP;
 }
 
+Bool PoolTrivSweep(Pool pool)
+{
+  AVERT(Pool, pool);
+  return FALSE;
+}
+
 
 void PoolNoRampBegin(Pool pool, Buffer buf, Bool collectAll)
 {
@@ -17,6 +17,7 @@ SRCID(poolamc, "$Id$");
 
 typedef struct AMCStruct *AMC;
 typedef struct amcGenStruct *amcGen;
+typedef struct amcBufStruct *amcBuf;
 
 /* Function returning TRUE if block in nailboarded segment is pinned. */
 typedef Bool (*amcPinnedFunction)(AMC amc, Nailboard board, Addr base, Addr limit);
@@ -25,6 +26,7 @@ typedef Bool (*amcPinnedFunction)(AMC amc, Nailboard board, Addr base, Addr limi
 
 static Bool amcSegHasNailboard(Seg seg);
 static Nailboard amcSegNailboard(Seg seg);
+static void amcSegMarkRangeReset(Seg seg);
 static Bool AMCCheck(AMC amc);
 static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO);
 
@@ -106,6 +108,15 @@ typedef struct amcSegStruct {
   BOOLFIELD(accountedAsBuffered); /* .seg.accounted-as-buffered */
   BOOLFIELD(old);           /* .seg.old */
   BOOLFIELD(deferred);      /* .seg.deferred */
+  BOOLFIELD(marking);       /* <design/poolamc/#mark> */
+  Addr markLow, markHigh;   /* <design/poolamc/#mark.scan> */
+  Addr scanObj;             /* <design/poolamc/#suspend.cursor> */
+  Addr scanPart;            /* <design/poolamc/#suspend.part> */
+  TraceSet scanTraces;      /* <design/poolamc/#suspend.valid> */
+  Rank scanRank;            /* <design/poolamc/#suspend.valid> */
+  Epoch scanEpoch;          /* <design/poolamc/#suspend.valid> */
+  RefSet scanSummary;       /* <design/poolamc/#suspend.summary> */
+  amcBuf site;              /* <design/poolamc/#pretenure.site> */
   Sig sig;                  /* <code/misc.h#sig> */
 } amcSegStruct;
 
@@ -119,10 +130,21 @@ static Bool amcSegCheck(amcSeg amcseg)
   if (amcseg->board) {
     CHECKD(Nailboard, amcseg->board);
     CHECKL(SegNailed(MustBeA(Seg, amcseg)) != TraceSetEMPTY);
+  } else {
+    CHECKL(!amcseg->marking);
+  }
+  if (amcseg->scanObj == NULL) {
+    CHECKL(amcseg->scanPart == NULL);
+  } else {
+    CHECKL(SegBase(MustBeA(Seg, amcseg)) < amcseg->scanObj);
+    CHECKL(amcseg->scanObj <= SegLimit(MustBeA(Seg, amcseg)));
+    CHECKL(TraceSetCheck(amcseg->scanTraces));
+    CHECKL(RankCheck(amcseg->scanRank));
   }
   /* CHECKL(BoolCheck(amcseg->accountedAsBuffered)); <design/type/#bool.bitfield.check> */
   /* CHECKL(BoolCheck(amcseg->old)); <design/type/#bool.bitfield.check> */
   /* CHECKL(BoolCheck(amcseg->deferred)); <design/type/#bool.bitfield.check> */
+  /* CHECKL(BoolCheck(amcseg->marking)); <design/type/#bool.bitfield.check> */
   return TRUE;
 }
 
@@ -153,6 +175,16 @@ static Res AMCSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   amcseg->accountedAsBuffered = FALSE;
   amcseg->old = FALSE;
   amcseg->deferred = FALSE;
+  amcseg->marking = FALSE;
+  amcseg->markLow = SegLimit(seg);
+  amcseg->markHigh = SegBase(seg);
+  amcseg->scanObj = NULL;
+  amcseg->scanPart = NULL;
+  amcseg->scanTraces = TraceSetEMPTY;
+  amcseg->scanRank = RankEXACT;
+  amcseg->scanEpoch = 0;
+  amcseg->scanSummary = RefSetEMPTY;
+  amcseg->site = NULL;
 
   SetClassOfPoly(seg, CLASS(amcSeg));
   amcseg->sig = amcSegSig;
@@ -361,6 +393,19 @@ static Nailboard amcSegNailboard(Seg seg)
 }
 
 
+/* amcSegMarkRangeReset -- forget the range of newly marked objects
+ *
+ * See <design/poolamc/#mark.scan>.
+ */
+
+static void amcSegMarkRangeReset(Seg seg)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+  amcseg->markLow = SegLimit(seg);
+  amcseg->markHigh = SegBase(seg);
+}
+
+
 /* amcSegGen -- get the generation structure for this segment */
 
 static amcGen amcSegGen(Seg seg)
@@ -392,6 +437,10 @@ typedef struct AMCStruct { /* <design/poolamc/#struct> */
   amcPinnedFunction pinned; /* function determining if block is pinned */
   Size extendBy;           /* segment size to extend pool by */
   Size largeSize;          /* min size of "large" segments */
+  Size fillLimit;          /* <design/poolamc/#fill.adapt.limit> */
+  double markThreshold;    /* <design/poolamc/#mark.threshold> */
+  Count copyDepth;         /* <design/poolamc/#copy.depth> */
+  Bool pretenure;          /* <design/poolamc/#pretenure.adapt> */
   Sig sig;                 /* <design/pool/#outer-structure.sig> */
 } AMCStruct;
 
@@ -421,12 +470,15 @@ static Bool amcGenCheck(amcGen gen)
 
 #define amcBufSig ((Sig)0x519A3CBF) /* SIGnature AMC BuFfer  */
 
-typedef struct amcBufStruct *amcBuf;
-
 typedef struct amcBufStruct {
   SegBufStruct segbufStruct;    /* superclass fields must come first */
   amcGen gen;                   /* The AMC generation */
+  amcGen baseGen;               /* <design/poolamc/#pretenure.gen> */
+  Size agedSize;                /* <design/poolamc/#pretenure.survival> */
+  Size survivedSize;            /* <design/poolamc/#pretenure.survival> */
   Bool forHashArrays;           /* allocates hash table arrays, see AMCBufferFill */
+  Size fillSize;                /* <design/poolamc/#fill.adapt> */
+  Clock lastFill;               /* time of previous fill */
   Sig sig;                      /* <design/sig/> */
 } amcBufStruct;
 
@@ -440,7 +492,11 @@ static Bool amcBufCheck(amcBuf amcbuf)
   CHECKD(SegBuf, &amcbuf->segbufStruct);
   if(amcbuf->gen != NULL)
     CHECKD(amcGen, amcbuf->gen);
+  if(amcbuf->baseGen != NULL)
+    CHECKD(amcGen, amcbuf->baseGen);
+  CHECKL(amcbuf->survivedSize <= amcbuf->agedSize);
   CHECKL(BoolCheck(amcbuf->forHashArrays));
+  CHECKL(amcbuf->fillSize > 0);
   /* hash array buffers only created by mutator */
   CHECKL(BufferIsMutator(MustBeA(Buffer, amcbuf)) || !amcbuf->forHashArrays);
   return TRUE;
@@ -478,10 +534,16 @@ static Res AMCBufInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
   amcBuf amcbuf;
   Res res;
   Bool forHashArrays = FALSE;
+  amcGen gen = amc->nursery;
   ArgStruct arg;
 
   if (ArgPick(&arg, args, amcKeyAPHashArrays))
     forHashArrays = arg.val.b;
+  /* <design/poolamc/#pretenure.gen> */
+  if (ArgPick(&arg, args, MPS_KEY_GEN)) {
+    AVER(arg.val.u <= amc->gens);
+    gen = amc->gen[arg.val.u];
+  }
 
   /* call next method */
   res = NextMethod(Buffer, amcBuf, init)(buffer, pool, isMutator, args);
@@ -490,13 +552,20 @@ static Res AMCBufInit(Buffer buffer, Pool pool, Bool isMutator, ArgList args)
   amcbuf = CouldBeA(amcBuf, buffer);
 
   if (BufferIsMutator(buffer)) {
-    /* Set up the buffer to be allocating in the nursery. */
-    amcbuf->gen = amc->nursery;
+    /* Set up the buffer to be allocating in the nursery, unless the
+     * client chose another generation. */
+    amcbuf->gen = gen;
+    amcbuf->baseGen = gen;
   } else {
     /* No gen yet -- see <design/poolamc/#gen.forward>. */
     amcbuf->gen = NULL;
+    amcbuf->baseGen = NULL;
   }
+  amcbuf->agedSize = 0;
+  amcbuf->survivedSize = 0;
   amcbuf->forHashArrays = forHashArrays;
+  amcbuf->fillSize = amc->extendBy;
+  amcbuf->lastFill = ClockNow();
 
   SetClassOfPoly(buffer, CLASS(amcBuf));
   amcbuf->sig = amcBufSig;
@@ -514,6 +583,19 @@ static void AMCBufFinish(Inst inst)
 {
   Buffer buffer = MustBeA(Buffer, inst);
   amcBuf amcbuf = MustBeA(amcBuf, buffer);
+  Pool pool = BufferPool(buffer);
+
+  /* Forget the segments that the buffer filled and that haven't yet
+   * been reclaimed.  See <design/poolamc/#pretenure.site>. */
+  if (MustBeA(AMCZPool, pool)->pretenure && BufferIsMutator(buffer)) {
+    Ring node, next;
+    RING_FOR(node, PoolSegRing(pool), next) {
+      amcSeg amcseg = MustBeA(amcSeg, SegOfPoolRing(node));
+      if (amcseg->site == amcbuf)
+        amcseg->site = NULL;
+    }
+  }
+
   amcbuf->sig = SigInvalid;
   NextMethod(Inst, amcBuf, finish)(inst);
 }
@@ -676,6 +758,11 @@ static void AMCVarargs(ArgStruct args[MPS_ARGS_MAX], va_list varargs)
 }
 
 
+ARG_DEFINE_KEY(AMC_MARK_THRESHOLD, double);
+ARG_DEFINE_KEY(AMC_COPY_DEPTH, Count);
+ARG_DEFINE_KEY(AMC_PRETENURE, Bool);
+
+
 /* amcInitComm -- initialize AMC/Z pool
  *
  * See <design/poolamc/#init>.
@@ -693,6 +780,9 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
   Chain chain;
   Size extendBy = AMC_EXTEND_BY_DEFAULT;
   Size largeSize = AMC_LARGE_SIZE_DEFAULT;
+  double markThreshold = AMC_MARK_THRESHOLD_DEFAULT;
+  Count copyDepth = AMC_COPY_DEPTH_DEFAULT;
+  Bool pretenure = AMC_PRETENURE_DEFAULT;
   ArgStruct arg;
   
   AVER(pool != NULL);
@@ -711,6 +801,12 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
     extendBy = arg.val.size;
   if (ArgPick(&arg, args, MPS_KEY_LARGE_SIZE))
     largeSize = arg.val.size;
+  if (ArgPick(&arg, args, MPS_KEY_AMC_MARK_THRESHOLD))
+    markThreshold = arg.val.d;
+  if (ArgPick(&arg, args, MPS_KEY_AMC_COPY_DEPTH))
+    copyDepth = arg.val.count;
+  if (ArgPick(&arg, args, MPS_KEY_AMC_PRETENURE))
+    pretenure = arg.val.b;
   
   AVERT(Chain, chain);
   AVER(chain->arena == arena);
@@ -721,6 +817,10 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
    * unacceptable fragmentation due to the padding objects. This
    * assertion catches this bad case. */
   AVER(largeSize >= extendBy);
+  AVER(markThreshold >= 0.0);
+  AVER(markThreshold <= 1.0);
+  AVER(copyDepth <= AMC_COPY_DEPTH_MAX);
+  AVERT(Bool, pretenure);
 
   res = PoolAbsInit(pool, arena, klass, args);
   if (res != ResOK)
@@ -737,6 +837,7 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
   /* amc gets checked before the generations get created, but they */
   /* do get created later in this function. */
   amc->gen = NULL;
+  amc->gens = 0;
   amc->nursery = NULL;
   amc->rampGen = NULL;
   amc->afterRampGen = NULL;
@@ -753,6 +854,18 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
   /* .extend-by.aligned: extendBy is aligned to the arena alignment. */
   amc->extendBy = SizeArenaGrains(extendBy, arena);
   amc->largeSize = largeSize;
+  /* <design/poolamc/#fill.adapt.limit> */
+  if (amc->extendBy <= SizeMAX / AMCFillGROWTH_LIMIT)
+    amc->fillLimit = amc->extendBy * AMCFillGROWTH_LIMIT;
+  else
+    amc->fillLimit = amc->extendBy;
+  if (amc->fillLimit >= largeSize)
+    amc->fillLimit = SizeAlignDown(largeSize - 1, ArenaGrainSize(arena));
+  if (amc->fillLimit < amc->extendBy)
+    amc->fillLimit = amc->extendBy;
+  amc->markThreshold = markThreshold;
+  amc->copyDepth = copyDepth;
+  amc->pretenure = pretenure;
 
   SetClassOfPoly(pool, klass);
   amc->sig = AMCSig;
@@ -784,6 +897,7 @@ static Res amcInitComm(Pool pool, Arena arena, PoolClass klass,
   amc->nursery = amc->gen[0];
   amc->rampGen = amc->gen[genCount-1]; /* last ephemeral gen */
   amc->afterRampGen = amc->gen[genCount];
+  amc->gens = genCount;
   amc->gensBooted = TRUE;
 
   AVERT(AMC, amc);
@@ -876,6 +990,46 @@ static void AMCFinish(Inst inst)
 }
 
 
+/* amcBufFillSize -- adapt the size of a buffer's small fills
+ *
+ * Return the segment size to use for a fill of a small request, and
+ * adapt it for next time according to how long it has been since the
+ * previous fill.  See <design/poolamc/#fill.adapt>.
+ */
+
+static Size amcBufFillSize(AMC amc, amcBuf amcbuf)
+{
+  Buffer buffer = MustBeA(Buffer, amcbuf);
+  Clock now, interval;
+  Size fillSize;
+
+  /* Forwarding buffers fill at the rate the collector copies, which
+     says nothing about the mutator: <design/poolamc/#fill.adapt.mutator>. */
+  if (!BufferIsMutator(buffer))
+    return amc->extendBy;
+
+  now = ClockNow();
+  interval = now - amcbuf->lastFill;
+  amcbuf->lastFill = now;
+
+  fillSize = amcbuf->fillSize;
+  if (interval < AMCFillFAST * ClocksPerSec()) {
+    if (fillSize <= amc->fillLimit / 2)
+      fillSize *= 2;
+    else
+      fillSize = amc->fillLimit;
+  } else if (interval > AMCFillSLOW * ClocksPerSec()) {
+    fillSize = SizeArenaGrains(fillSize / 2, PoolArena(MustBeA(AbstractPool, amc)));
+    if (fillSize < amc->extendBy)
+      fillSize = amc->extendBy;
+  }
+  amcbuf->fillSize = fillSize;
+
+  EVENT4(AMCFill, amc, buffer, fillSize, interval);
+  return fillSize;
+}
+
+
 /* AMCBufferFill -- refill an allocation buffer
  *
  * See <design/poolamc/#fill>.
@@ -892,6 +1046,7 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
   amcGen gen;
   PoolGen pgen;
   amcBuf amcbuf = MustBeA(amcBuf, buffer);
+  Size minSize, fillSize;
 
   AVER(baseReturn != NULL);
   AVER(limitReturn != NULL);
@@ -909,13 +1064,25 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
   /* expressed via the pool generation. We rely on the arena to */
   /* organize locations appropriately.  */
   if (size < amc->extendBy) {
-    grainsSize = amc->extendBy; /* .extend-by.aligned */
+    minSize = amc->extendBy; /* .extend-by.aligned */
+  } else {
+    minSize = SizeArenaGrains(size, arena);
+  }
+  fillSize = amcBufFillSize(amc, amcbuf);
+  if (size < fillSize && size < amc->largeSize) {
+    grainsSize = fillSize; /* <design/poolamc/#fill.adapt> */
   } else {
-    grainsSize = SizeArenaGrains(size, arena);
+    grainsSize = minSize;
   }
   MPS_ARGS_BEGIN(args) {
     MPS_ARGS_ADD_FIELD(args, amcKeySegGen, p, gen);
     res = PoolGenAlloc(&seg, pgen, CLASS(amcSeg), grainsSize, args);
+    if (res != ResOK && grainsSize > minSize) {
+      /* <design/poolamc/#fill.adapt.fail> */
+      amcbuf->fillSize = amc->extendBy;
+      grainsSize = minSize;
+      res = PoolGenAlloc(&seg, pgen, CLASS(amcSeg), grainsSize, args);
+    }
   } MPS_ARGS_END(args);
   if(res != ResOK)
     return res;
@@ -963,6 +1130,10 @@ static Res AMCBufferFill(Addr *baseReturn, Addr *limitReturn,
   PoolGenAccountForFill(pgen, SegSize(seg));
   MustBeA(amcSeg, seg)->accountedAsBuffered = TRUE;
 
+  /* <design/poolamc/#pretenure.site> */
+  if (amc->pretenure && BufferIsMutator(buffer))
+    MustBeA(amcSeg, seg)->site = amcbuf;
+
   *baseReturn = base;
   *limitReturn = limit;
   return ResOK;
@@ -1180,6 +1351,18 @@ static Res AMCWhiten(Pool pool, Trace trace, Seg seg)
 
   gen = amcSegGen(seg);
   AVERT(amcGen, gen);
+
+  /* <design/poolamc/#mark.whiten> */
+  if (1.0 - gen->pgen.gen->mortality > amc->markThreshold) {
+    if (SegNailed(seg) == TraceSetEMPTY
+        && amcSegCreateNailboard(seg, pool) == ResOK)
+      SegSetNailed(seg, TraceSetSingle(trace));
+    if (amcSegHasNailboard(seg)) {
+      amcseg->marking = TRUE;
+      amcSegMarkRangeReset(seg);
+    }
+  }
+
   if (!amcseg->old) {
     amcseg->old = TRUE;
     if (amcseg->accountedAsBuffered) {
@@ -1276,6 +1459,7 @@ static Res amcScanNailedOnce(Bool *totalReturn, Bool *moreReturn,
   *totalReturn = TRUE;
   board = amcSegNailboard(seg);
   NailboardClearNewNails(board);
+  amcSegMarkRangeReset(seg);
 
   p = SegBase(seg);
   while (SegBuffer(&buffer, seg)) {
@@ -1306,17 +1490,62 @@ returnGood:
 }
 
 
+/* amcScanMarkedOnce -- rescan objects newly marked in a segment
+ *
+ * Scan only the objects between the lowest and highest objects marked
+ * in place since the previous pass.  See <design/poolamc/#mark.scan>.
+ */
+static Res amcScanMarkedOnce(Bool *moreReturn, ScanState ss, Seg seg,
+                             AMC amc)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+  Format format = MustBeA(AbstractPool, amc)->format;
+  Nailboard board;
+  Addr base, limit;
+  Bool total;
+  Res res;
+
+  AVER(amcseg->marking);
+  AVER(amcseg->markLow <= amcseg->markHigh);
+
+  EVENT3(AMCScanBegin, amc, seg, ss);
+
+  base = AddrSub(amcseg->markLow, format->headerSize);
+  limit = AddrSub((*format->skip)(amcseg->markHigh), format->headerSize);
+  board = amcSegNailboard(seg);
+  NailboardClearNewNails(board);
+  amcSegMarkRangeReset(seg);
+  res = amcScanNailedRange(&total, moreReturn, ss, amc, board, base, limit);
+  if (res != ResOK)
+    return res;
+
+  EVENT3(AMCScanEnd, amc, seg, ss);
+
+  *moreReturn = NailboardNewNails(board);
+  return ResOK;
+}
+
+
 /* amcScanNailed -- scan a nailed segment */
 
 static Res amcScanNailed(Bool *totalReturn, ScanState ss, Pool pool,
                          Seg seg, AMC amc)
 {
+  amcSeg amcseg = MustBeA(amcSeg, seg);
   Bool total, moreScanning;
   size_t loops = 0;
 
   do {
     Res res;
-    res = amcScanNailedOnce(&total, &moreScanning, ss, seg, amc);
+    /* After the first pass over a segment that is being marked in */
+    /* place, only the newly marked objects need scanning, unless */
+    /* emergency fixing has added nails that weren't recorded. */
+    if (loops > 0 && amcseg->marking
+        && !ArenaEmergency(PoolArena(pool))
+        && amcseg->markLow <= amcseg->markHigh)
+      res = amcScanMarkedOnce(&moreScanning, ss, seg, amc);
+    else
+      res = amcScanNailedOnce(&total, &moreScanning, ss, seg, amc);
     if(res != ResOK) {
       *totalReturn = FALSE;
       return res;
@@ -1327,7 +1556,10 @@ static Res amcScanNailed(Bool *totalReturn, ScanState ss, Pool pool,
   if(loops > 1) {
     RefSet refset;
 
-    AVER(ArenaEmergency(PoolArena(pool)));
+    /* Only emergency fixing and marking in place can nail objects */
+    /* in a segment while it is being scanned. */
+    AVER(ArenaEmergency(PoolArena(pool))
+         || MustBeA(amcSeg, seg)->marking);
 
     /* Looped: fixed refs (from 1st pass) were seen by MPS_FIX1
      * (in later passes), so the "ss.unfixedSummary" is _not_
@@ -1352,6 +1584,152 @@ static Res amcScanNailed(Bool *totalReturn, ScanState ss, Pool pool,
 }
 
 
+/* amcScanSuspend -- suspend the scan of a segment
+ *
+ * Records where the scan should resume: at the object obj, and if
+ * part is not NULL, at the address part within that object.  See
+ * <design/poolamc/#suspend>.
+ */
+
+static void amcScanSuspend(ScanState ss, Seg seg, Addr obj, Addr part)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+
+  amcseg->scanObj = obj;
+  amcseg->scanPart = part;
+  amcseg->scanTraces = ss->traces;
+  amcseg->scanRank = ss->rank;
+  amcseg->scanEpoch = ArenaEpoch(ss->arena);
+  amcseg->scanSummary = RefSetUnion(amcseg->scanSummary,
+                                    ScanStateSummary(ss));
+  ss->suspended = TRUE;
+}
+
+
+/* amcScanResumable -- can the scan resume where it was suspended?
+ *
+ * See <design/poolamc/#suspend.valid>.
+ */
+
+static Bool amcScanResumable(ScanState ss, Seg seg)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+
+  return amcseg->scanObj != NULL
+    && amcseg->scanTraces == ss->traces
+    && amcseg->scanRank == ss->rank
+    && amcseg->scanEpoch == ArenaEpoch(ss->arena);
+}
+
+
+/* amcScanPart -- scan a large object in parts
+ *
+ * Scans the object obj from the address part onwards, one part at a
+ * time, suspending the scan when the budget runs out.  See
+ * <design/poolamc/#suspend.part>.
+ */
+
+static Res amcScanPart(ScanState ss, Seg seg, Format format,
+                       Addr obj, Addr part)
+{
+  Addr limit = AddrSub((*format->skip)(obj), format->headerSize);
+
+  AVER(AddrSub(obj, format->headerSize) <= part);
+  AVER(part < limit);
+
+  while (part < limit) {
+    Addr next;
+    Res res;
+
+    if (ss->scannedSize >= ss->budget) {
+      amcScanSuspend(ss, seg, obj, part);
+      return ResOK;
+    }
+    next = AddrAlignUp(AddrAdd(part, ss->budget - ss->scannedSize),
+                       format->alignment);
+    if (next > limit || next < part) /* overflow */
+      next = limit;
+    res = FormatScanPart(format, ss, obj, part, next);
+    if (res != ResOK)
+      return res;
+    part = next;
+  }
+  return ResOK;
+}
+
+
+/* amcScanRange -- scan the objects in a range, within the budget
+ *
+ * Scans objects from *baseIO up to limit, and updates *baseIO to
+ * limit.  If the budget runs out first, suspends the scan, and updates
+ * *baseIO to where it will resume.  See <design/poolamc/#suspend>.
+ */
+
+static Res amcScanRange(Addr *baseIO, ScanState ss, Seg seg,
+                        Format format, Addr limit)
+{
+  Addr base = *baseIO;
+  Res res;
+
+  AVER(base < limit);
+
+  while (base < limit) {
+    Size budget;
+    Addr p, next;
+
+    if (ss->scannedSize >= ss->budget) {
+      amcScanSuspend(ss, seg, base, NULL);
+      break;
+    }
+    budget = ss->budget - ss->scannedSize;
+
+    /* The common case: the rest of the range fits in the budget. */
+    if (AddrOffset(base, limit) <= budget) {
+      res = FormatScan(format, ss, base, limit);
+      if (res != ResOK)
+        return res;
+      base = limit;
+      break;
+    }
+
+    /* Find as many whole objects as fit in the budget. */
+    p = base;
+    do {
+      next = (*format->skip)(p);
+      if (AddrOffset(base, next) > budget)
+        break;
+      p = next;
+    } while (p < limit);
+
+    if (p > base) {
+      res = FormatScan(format, ss, base, p);
+      base = p;
+    } else if (FormatCanScanPart(format)) {
+      /* The next object alone is bigger than the budget. */
+      res = amcScanPart(ss, seg, format, base,
+                        AddrSub(base, format->headerSize));
+      if (res == ResOK && !ss->suspended)
+        base = next;
+    } else if (ss->scannedSize > 0) {
+      /* Leave the object for the next increment. */
+      amcScanSuspend(ss, seg, base, NULL);
+      break;
+    } else {
+      /* The object can't be divided, so scan it all. */
+      res = FormatScan(format, ss, base, next);
+      base = next;
+    }
+    if (res != ResOK)
+      return res;
+    if (ss->suspended)
+      break;
+  }
+
+  *baseIO = base;
+  return ResOK;
+}
+
+
 /* AMCScan -- scan a single seg, turning it black
  *
  * See <design/poolamc/#seg-scan>.
@@ -1361,8 +1739,10 @@ static Res AMCScan(Bool *totalReturn, ScanState ss, Pool pool, Seg seg)
   Addr base, limit;
   Format format;
   AMC amc = MustBeA(AMCZPool, pool);
+  amcSeg amcseg = MustBeA(amcSeg, seg);
   Res res;
   Buffer buffer;
+  Bool resumed;
 
   AVER(totalReturn != NULL);
   AVERT(ScanState, ss);
@@ -1372,12 +1752,37 @@ static Res AMCScan(Bool *totalReturn, ScanState ss, Pool pool, Seg seg)
   format = pool->format;
 
   if(amcSegHasNailboard(seg)) {
+    /* <design/poolamc/#suspend.nailed> */
+    amcseg->scanObj = NULL;
+    amcseg->scanPart = NULL;
+    amcseg->scanSummary = RefSetEMPTY;
     return amcScanNailed(totalReturn, ss, pool, seg, amc);
   }
 
   EVENT3(AMCScanBegin, amc, seg, ss);
 
-  base = AddrAdd(SegBase(seg), format->headerSize);
+  resumed = amcScanResumable(ss, seg);
+  if (resumed) {
+    /* <design/poolamc/#suspend.resume> */
+    Addr part = amcseg->scanPart;
+    base = amcseg->scanObj;
+    amcseg->scanObj = NULL;
+    amcseg->scanPart = NULL;
+    if (part != NULL) {
+      res = amcScanPart(ss, seg, format, base, part);
+      if (res != ResOK || ss->suspended) {
+        *totalReturn = FALSE;
+        return res;
+      }
+      base = (*format->skip)(base);
+    }
+  } else {
+    base = AddrAdd(SegBase(seg), format->headerSize);
+    amcseg->scanObj = NULL;
+    amcseg->scanPart = NULL;
+    amcseg->scanSummary = RefSetEMPTY;
+  }
+
   /* <design/poolamc/#seg-scan.loop> */
   while (SegBuffer(&buffer, seg)) {
     limit = AddrAdd(BufferScanLimit(buffer),
@@ -1386,15 +1791,13 @@ static Res AMCScan(Bool *totalReturn, ScanState ss, Pool pool, Seg seg)
       /* @@@@ Are we sure we don't need scan the rest of the */
       /* segment? */
       AVER(base == limit);
-      *totalReturn = TRUE;
-      return ResOK;
+      goto done;
     }
-    res = FormatScan(format, ss, base, limit);
-    if(res != ResOK) {
+    res = amcScanRange(&base, ss, seg, format, limit);
+    if(res != ResOK || ss->suspended) {
       *totalReturn = FALSE;
       return res;
     }
-    base = limit;
   }
 
   /* <design/poolamc/#seg-scan.finish> @@@@ base? */
@@ -1402,13 +1805,20 @@ static Res AMCScan(Bool *totalReturn, ScanState ss, Pool pool, Seg seg)
   AVER(SegBase(seg) <= base);
   AVER(base <= AddrAdd(SegLimit(seg), format->headerSize));
   if(base < limit) {
-    res = FormatScan(format, ss, base, limit);
-    if(res != ResOK) {
+    res = amcScanRange(&base, ss, seg, format, limit);
+    if(res != ResOK || ss->suspended) {
       *totalReturn = FALSE;
       return res;
     }
   }
 
+done:
+  /* <design/poolamc/#suspend.summary> */
+  if (resumed)
+    ScanStateSetSummary(ss, RefSetUnion(amcseg->scanSummary,
+                                        ScanStateSummary(ss)));
+  amcseg->scanSummary = RefSetEMPTY;
+
   EVENT3(AMCScanEnd, amc, seg, ss);
 
   *totalReturn = TRUE;
@@ -1457,6 +1867,28 @@ static void amcFixInPlace(Pool pool, Seg seg, ScanState ss, Ref *refIO)
 }
 
 
+/* amcFixedGens -- note the generation of a forwarded object
+ *
+ * A reference to an object in seg that has been forwarded now refers
+ * to a segment allocated by the forwarding buffer of the object's
+ * generation, so the scan state must remember that buffer's
+ * generation.  See <design/write-barrier/#gen.fix.move>.
+ */
+
+static void amcFixedGens(ScanState ss, Seg seg)
+{
+  amcGen gen;
+  amcBuf forward;
+
+  if (!ss->rememberGens)
+    return;
+  gen = amcSegGen(seg);
+  forward = MustBeA_CRITICAL(amcBuf, gen->forward);
+  ss->fixedGens = GenSetUnion(ss->fixedGens,
+                              forward->gen->pgen.gen->genSet);
+}
+
+
 /* AMCFixEmergency -- fix a reference, without allocating
  *
  * See <design/poolamc/#emergency.fix>.
@@ -1487,6 +1919,7 @@ static Res AMCFixEmergency(Pool pool, ScanState ss, Seg seg,
     /* TODO: Implement weak pointer semantics in emergency fixing.  This
        would be a good idea since we really want to reclaim as much as
        possible in an emergency. */
+    amcFixedGens(ss, seg);
     *refIO = newRef;
     return ResOK;
   }
@@ -1497,6 +1930,42 @@ fixInPlace: /* see <design/poolamc/>.Nailboard.emergency */
 }
 
 
+/* amcCopyChildren -- copy the children of a newly copied object
+ *
+ * Scans the new copy of an object, from ref to limit in the segment
+ * toSeg, so that the objects it refers to are copied next to it in
+ * the forwarding buffers.  See <design/poolamc/#copy.depth>.
+ */
+static Res amcCopyChildren(AMC amc, ScanState ss, Seg toSeg,
+                           Ref ref, Addr limit)
+{
+  Pool pool = MustBeA(AbstractPool, amc);
+  Arena arena = PoolArena(pool);
+  ScanStateStruct ssStruct;
+  Res res;
+
+  AVER(ss->nesting < amc->copyDepth);
+  AVER(ss->rank == RankEXACT);
+
+  ScanStateInit(&ssStruct, ss->traces, arena, ss->rank,
+                ScanStateWhite(ss));
+  ssStruct.nesting = ss->nesting + 1;
+  ShieldExpose(arena, toSeg);
+  res = FormatScan(pool->format, &ssStruct, ref, limit);
+  ShieldCover(arena, toSeg);
+
+  /* <design/poolamc/#copy.summary> */
+  SegSetSummary(toSeg, RefSetUnion(SegSummary(toSeg),
+                                   ScanStateSummary(&ssStruct)));
+  if (SegSummary(toSeg) != RefSetUNIV)
+    SegSetRemembered(toSeg, GenSetUnion(SegRemembered(toSeg),
+                                        ScanStateRemembered(&ssStruct)));
+  ScanStateAccumulate(ss, &ssStruct);
+  ScanStateFinish(&ssStruct);
+  return res;
+}
+
+
 /* AMCFix -- fix a reference to the pool
  *
  * See <design/poolamc/#fix>.
@@ -1592,6 +2061,18 @@ static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
       /* Object is not preserved (neither moved, nor nailed) */
       /* hence, reference should be splatted. */
       goto updateReference;
+    } else if(MustBeA_CRITICAL(amcSeg, seg)->marking) {
+      /* Preserve the object by marking it in the nailboard rather */
+      /* than copying it.  See <design/poolamc/#mark.fix>. */
+      amcSeg amcseg = MustBeA_CRITICAL(amcSeg, seg);
+      ss->wasMarked = FALSE;
+      amcFixInPlace(pool, seg, ss, refIO);
+      if (ref < amcseg->markLow)
+        amcseg->markLow = ref;
+      if (ref > amcseg->markHigh)
+        amcseg->markHigh = ref;
+      res = ResOK;
+      goto returnRes;
     }
     /* Object is not preserved yet (neither moved, nor nailed) */
     /* so should be preserved by forwarding. */
@@ -1616,11 +2097,15 @@ static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
       ShieldExpose(arena, toSeg);
 
       /* Since we're moving an object from one segment to another, */
-      /* union the greyness and the summaries together. */
+      /* union the greyness, the summaries, and the remembered sets */
+      /* together.  See <design/write-barrier/#gen.copy>. */
       grey = SegGrey(seg);
       if(SegRankSet(seg) != RankSetEMPTY) { /* not for AMCZ */
         grey = TraceSetUnion(grey, ss->traces);
         SegSetSummary(toSeg, RefSetUnion(SegSummary(toSeg), SegSummary(seg)));
+        if (SegSummary(toSeg) != RefSetUNIV)
+          SegSetRemembered(toSeg, GenSetUnion(SegRemembered(toSeg),
+                                              SegRemembered(seg)));
       } else {
         AVER(SegRankSet(toSeg) == RankSetEMPTY);
       }
@@ -1640,6 +2125,15 @@ static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
     (*format->move)(ref, newRef);  /* .exposed.seg */
 
     EVENT1(AMCFixForward, newRef);
+
+    /* <design/poolamc/#copy.depth> */
+    if (ss->nesting < amc->copyDepth && ss->rank == RankEXACT
+        && SegRankSet(toSeg) != RankSetEMPTY) {
+      res = amcCopyChildren(amc, ss, toSeg, newRef,
+                            AddrAdd(newRef, length));
+      if (res != ResOK)
+        goto returnRes; /* object is forwarded, so a retry will snap */
+    }
   } else {
     /* reference to broken heart (which should be snapped out -- */
     /* consider adding to (non-existent) snap-out cache here) */
@@ -1649,6 +2143,8 @@ static Res AMCFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
   /* .fix.update: update the reference to whatever the above code */
   /* decided it should be */
 updateReference:
+  if (newRef != (Ref)0)
+    amcFixedGens(ss, seg);
   *refIO = newRef;
   res = ResOK;
 
@@ -1658,6 +2154,50 @@ returnRes:
 }
 
 
+/* amcSegSurvived -- account for the survivors of a segment
+ *
+ * If the segment was filled by a mutator buffer that adapts its
+ * generation, and is in the buffer's current generation, add the size
+ * of the segment and of its survivors to the buffer's statistics, and
+ * move the buffer to an older or younger generation once it has
+ * enough of them.  See <design/poolamc/#pretenure.adapt>.
+ */
+static void amcSegSurvived(AMC amc, Seg seg, Size survived)
+{
+  amcSeg amcseg = MustBeA(amcSeg, seg);
+  amcBuf amcbuf = amcseg->site;
+  double survival;
+  Index i;
+
+  if (amcbuf == NULL)
+    return;
+  AVERT(amcBuf, amcbuf);
+  AVER(survived <= SegSize(seg));
+
+  amcseg->site = NULL;
+  if (amcseg->gen != amcbuf->gen)
+    return;
+  amcbuf->agedSize += SegSize(seg);
+  amcbuf->survivedSize += survived;
+  if (amcbuf->agedSize < AMCPretenureSAMPLE)
+    return;
+
+  survival = (double)amcbuf->survivedSize / (double)amcbuf->agedSize;
+  amcbuf->agedSize = 0;
+  amcbuf->survivedSize = 0;
+
+  i = 0;
+  while (amc->gen[i] != amcbuf->gen) {
+    ++i;
+    AVER(i <= amc->gens);
+  }
+  if (survival > AMCPretenureHIGH && i < amc->gens)
+    amcbuf->gen = amc->gen[i + 1];
+  else if (survival < AMCPretenureLOW && amcbuf->gen != amcbuf->baseGen)
+    amcbuf->gen = amc->gen[i - 1];
+}
+
+
 /* amcReclaimNailed -- reclaim what you can from a nailed segment */
 
 static void amcReclaimNailed(Pool pool, Trace trace, Seg seg)
@@ -1738,6 +2278,7 @@ static void amcReclaimNailed(Pool pool, Trace trace, Seg seg)
   if(SegNailed(seg) == TraceSetEMPTY && amcSegHasNailboard(seg)) {
     NailboardDestroy(amcSegNailboard(seg), arena);
     MustBeA(amcSeg, seg)->board = NULL;
+    MustBeA(amcSeg, seg)->marking = FALSE;
   }
 
   STATISTIC(AVER(bytesReclaimed <= SegSize(seg)));
@@ -1752,6 +2293,8 @@ static void amcReclaimNailed(Pool pool, Trace trace, Seg seg)
   }
   GenDescSurvived(pgen->gen, trace, MustBeA(amcSeg, seg)->forwarded[trace->ti],
                   preservedInPlaceSize);
+  amcSegSurvived(amc, seg, MustBeA(amcSeg, seg)->forwarded[trace->ti]
+                 + preservedInPlaceSize);
 
   /* Free the seg if we can; fixes .nailboard.limitations.middle. */
   if(preservedInPlaceCount == 0
@@ -1807,6 +2350,7 @@ static void AMCReclaim(Pool pool, Trace trace, Seg seg)
   STATISTIC(trace->reclaimSize += SegSize(seg));
 
   GenDescSurvived(gen->pgen.gen, trace, amcseg->forwarded[trace->ti], 0);
+  amcSegSurvived(amc, seg, amcseg->forwarded[trace->ti]);
   PoolGenFree(&gen->pgen, seg, 0, SegSize(seg), 0, amcseg->deferred);
 }
 
@@ -2178,6 +2722,14 @@ static Bool AMCCheck(AMC amc)
     CHECKD(amcGen, amc->afterRampGen);
   }
 
+  CHECKL(amc->fillLimit >= amc->extendBy);
+  CHECKL(amc->fillLimit < amc->largeSize
+         || amc->fillLimit == amc->extendBy);
+  CHECKL(amc->markThreshold >= 0.0);
+  CHECKL(amc->markThreshold <= 1.0);
+  CHECKL(amc->copyDepth <= AMC_COPY_DEPTH_MAX);
+  CHECKL(BoolCheck(amc->pretenure));
+
   CHECKL(amc->rampMode >= RampOUTSIDE);
   CHECKL(amc->rampMode <= RampCOLLECTING);
 
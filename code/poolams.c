@@ -70,6 +70,8 @@ Bool AMSSegCheck(AMSSeg amsseg)
 
   CHECKL(BoolCheck(amsseg->marksChanged));
   CHECKL(BoolCheck(amsseg->ambiguousFixes));
+  CHECKL(amsseg->greyCount <= AMSGreyStackLENGTH);
+  CHECKL(BoolCheck(amsseg->greyOverflow));
   CHECKL(BoolCheck(amsseg->colourTablesInUse));
   CHECKD_NOSIG(BT, amsseg->nongreyTable);
   CHECKD_NOSIG(BT, amsseg->nonwhiteTable);
@@ -241,6 +243,8 @@ static Res AMSSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   amsseg->oldGrains = (Count)0;
   amsseg->marksChanged = FALSE; /* <design/poolams/#marked.unused> */
   amsseg->ambiguousFixes = FALSE;
+  amsseg->greyCount = 0;
+  amsseg->greyOverflow = FALSE;
 
   res = amsCreateTables(ams, &amsseg->allocTable,
                         &amsseg->nongreyTable, &amsseg->nonwhiteTable,
@@ -340,6 +344,7 @@ static Res AMSSegMerge(Seg seg, Seg segHi,
   /* checks for .empty */
   AVER(amssegHi->freeGrains == hiGrains);
   AVER(!amssegHi->marksChanged);
+  AVER(amssegHi->greyCount == 0);
 
   /* .alloc-early  */
   res = amsCreateTables(ams, &allocTable, &nongreyTable, &nonwhiteTable,
@@ -467,6 +472,8 @@ static Res AMSSegSplit(Seg seg, Seg segHi,
   amssegHi->oldGrains = (Count)0;
   amssegHi->marksChanged = FALSE; /* <design/poolams/#marked.unused> */
   amssegHi->ambiguousFixes = FALSE;
+  amssegHi->greyCount = 0;
+  amssegHi->greyOverflow = FALSE;
 
   /* start off using firstFree, see <design/poolams/#no-bit> */
   amssegHi->allocTableInUse = FALSE;
@@ -1133,6 +1140,8 @@ static Res AMSWhiten(Pool pool, Trace trace, Seg seg)
   amsseg->newGrains = 0;
   amsseg->marksChanged = FALSE; /* <design/poolams/#marked.condemn> */
   amsseg->ambiguousFixes = FALSE;
+  amsseg->greyCount = 0; /* <design/poolams/#scan.stack.reset> */
+  amsseg->greyOverflow = FALSE;
 
   if (amsseg->oldGrains > 0) {
     GenDescCondemned(ams->pgen->gen, trace,
@@ -1296,6 +1305,79 @@ static Res amsScanObject(Seg seg, Index i, Addr p, Addr next, void *clos)
 }
 
 
+/* amsGreyPush -- remember a newly grey object for scanning
+ *
+ * See <design/poolams/#scan.stack>.  */
+
+static void amsGreyPush(AMSSeg amsseg, Index i)
+{
+  if (amsseg->greyCount < AMSGreyStackLENGTH) {
+    amsseg->greyStack[amsseg->greyCount] = i;
+    ++amsseg->greyCount;
+  } else {
+    amsseg->greyOverflow = TRUE;
+  }
+}
+
+
+/* amsObjectLimit -- find the extent of the object at grain i
+ *
+ * Returns the index of the grain following the object, and the client
+ * pointers to the object and to the next object in *clientPReturn and
+ * *clientNextReturn.  */
+
+static Index amsObjectLimit(Addr *clientPReturn, Addr *clientNextReturn,
+                            Seg seg, Index i)
+{
+  AMSSeg amsseg = Seg2AMSSeg(seg);
+  Pool pool = AMSPool(amsseg->ams);
+  Format format = pool->format;
+  Addr p, next, clientP, clientNext;
+
+  p = AMS_INDEX_ADDR(seg, i);
+  clientP = AddrAdd(p, format->headerSize);
+  if (format->skip != NULL) {
+    clientNext = (*format->skip)(clientP);
+    next = AddrSub(clientNext, format->headerSize);
+  } else {
+    clientNext = AddrAdd(clientP, PoolAlignment(pool));
+    next = AddrAdd(p, PoolAlignment(pool));
+  }
+  *clientPReturn = clientP;
+  *clientNextReturn = clientNext;
+  return AMS_ADDR_INDEX(seg, next);
+}
+
+
+/* amsScanGrey -- scan and blacken the grey object at grain i
+ *
+ * On success, returns the index of the grain following the object in
+ * *nextReturn.  */
+
+static Res amsScanGrey(Index *nextReturn, ScanState ss, Seg seg, Index i)
+{
+  AMSSeg amsseg = Seg2AMSSeg(seg);
+  Format format = AMSPool(amsseg->ams)->format;
+  Addr clientP, clientNext;
+  Index j;
+  Res res;
+
+  AVER(!AMS_IS_INVALID_COLOUR(seg, i));
+  j = amsObjectLimit(&clientP, &clientNext, seg, i);
+  res = FormatScan(format, ss, clientP, clientNext);
+  if (res != ResOK)
+    return res;
+  /* Check that there haven't been any ambiguous fixes during the */
+  /* scan, because AMSFindGrey won't work otherwise. */
+  AVER_CRITICAL(!amsseg->ambiguousFixes);
+  AMS_GREY_BLACKEN(seg, i);
+  if (i+1 < j)
+    AMS_RANGE_WHITE_BLACKEN(seg, i+1, j);
+  *nextReturn = j;
+  return ResOK;
+}
+
+
 /* AMSScan -- the pool class segment scanning method
  *
  * See <design/poolams/#scan>
@@ -1307,8 +1389,6 @@ Res AMSScan(Bool *totalReturn, ScanState ss, Pool pool, Seg seg)
   Arena arena;
   AMSSeg amsseg;
   struct amsScanClosureStruct closureStruct;
-  Format format;
-  Align alignment;
 
   AVER(totalReturn != NULL);
   AVERT(ScanState, ss);
@@ -1339,13 +1419,14 @@ Res AMSScan(Bool *totalReturn, ScanState ss, Pool pool, Seg seg)
   } else {
     AVER(amsseg->marksChanged); /* something must have changed */
     AVER(amsseg->colourTablesInUse);
-    format = pool->format;
-    AVERT(Format, format);
-    alignment = PoolAlignment(AMSPool(ams));
     do { /* <design/poolams/#scan.iter> */
       amsseg->marksChanged = FALSE; /* <design/poolams/#marked.scan> */
       /* <design/poolams/#ambiguous.middle> */
       if (amsseg->ambiguousFixes) {
+        /* The iteration finds every grey object, so the stack is */
+        /* redundant.  <design/poolams/#scan.stack.ambig> */
+        amsseg->greyCount = 0;
+        amsseg->greyOverflow = FALSE;
         res = amsIterate(seg, amsScanObject, &closureStruct);
         if (res != ResOK) {
           /* <design/poolams/#marked.scan.fail> */
@@ -1354,36 +1435,39 @@ Res AMSScan(Bool *totalReturn, ScanState ss, Pool pool, Seg seg)
           return res;
         }
       } else {
-        Index i, j = 0;
-        Addr p, next;
-
-        while(j < amsseg->grains
-              && AMSFindGrey(&i, &j, seg, j, amsseg->grains)) {
-          Addr clientP, clientNext;
-          AVER(!AMS_IS_INVALID_COLOUR(seg, i));
-          p = AMS_INDEX_ADDR(seg, i);
-          clientP = AddrAdd(p, format->headerSize);
-          if (format->skip != NULL) {
-            clientNext = (*format->skip)(clientP);
-            next = AddrSub(clientNext, format->headerSize);
-          } else {
-            clientNext = AddrAdd(clientP, alignment);
-            next = AddrAdd(p, alignment);
+        Index i, j;
+
+        /* <design/poolams/#scan.stack> */
+        while (amsseg->greyCount > 0) {
+          --amsseg->greyCount;
+          i = amsseg->greyStack[amsseg->greyCount];
+          if (AMS_IS_GREY(seg, i)) {
+            res = amsScanGrey(&j, ss, seg, i);
+            if (res != ResOK) {
+              /* <design/poolams/#marked.scan.fail> */
+              amsGreyPush(amsseg, i);
+              amsseg->marksChanged = TRUE;
+              *totalReturn = FALSE;
+              return res;
+            }
           }
-          j = AMS_ADDR_INDEX(seg, next);
-          res = FormatScan(format, ss, clientP, clientNext);
-          if (res != ResOK) {
-            /* <design/poolams/#marked.scan.fail> */
-            amsseg->marksChanged = TRUE;
-            *totalReturn = FALSE;
-            return res;
+        }
+
+        /* <design/poolams/#scan.stack.overflow> */
+        if (amsseg->greyOverflow) {
+          amsseg->greyOverflow = FALSE;
+          j = 0;
+          while(j < amsseg->grains
+                && AMSFindGrey(&i, seg, j, amsseg->grains)) {
+            res = amsScanGrey(&j, ss, seg, i);
+            if (res != ResOK) {
+              /* <design/poolams/#marked.scan.fail> */
+              amsseg->greyOverflow = TRUE;
+              amsseg->marksChanged = TRUE;
+              *totalReturn = FALSE;
+              return res;
+            }
           }
-          /* Check that there haven't been any ambiguous fixes during the */
-          /* scan, because AMSFindGrey won't work otherwise. */
-          AVER_CRITICAL(!amsseg->ambiguousFixes);
-          AMS_GREY_BLACKEN(seg, i);
-          if (i+1 < j)
-            AMS_RANGE_WHITE_BLACKEN(seg, i+1, j);
         }
       }
     } while(amsseg->marksChanged);
@@ -1478,6 +1562,7 @@ static Res AMSFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
           AMS_RANGE_WHITE_BLACKEN(seg, i, AMS_ADDR_INDEX(seg, next));
         } else { /* turn it grey */
           AMS_WHITE_GREYEN(seg, i);
+          amsGreyPush(amsseg, i);
           SegSetGrey(seg, TraceSetUnion(SegGrey(seg), ss->traces));
           /* mark it for scanning - <design/poolams/#marked.fix> */
           amsseg->marksChanged = TRUE;
@@ -1531,8 +1616,24 @@ static void AMSBlacken(Pool pool, TraceSet traceSet, Seg seg)
     AVERT(AMSSeg, amsseg);
     AVER(amsseg->marksChanged); /* there must be something grey */
     amsseg->marksChanged = FALSE;
-    res = amsIterate(seg, amsBlackenObject, NULL);
-    AVER(res == ResOK);
+    amsseg->greyCount = 0; /* <design/poolams/#scan.stack.reset> */
+    amsseg->greyOverflow = FALSE;
+    if (amsseg->ambiguousFixes) {
+      res = amsIterate(seg, amsBlackenObject, NULL);
+      AVER(res == ResOK);
+    } else {
+      /* <design/poolams/#blacken.find> */
+      Index i, j = 0;
+      while (j < amsseg->grains
+             && AMSFindGrey(&i, seg, j, amsseg->grains)) {
+        Addr clientP, clientNext;
+        AVER(!AMS_IS_INVALID_COLOUR(seg, i));
+        j = amsObjectLimit(&clientP, &clientNext, seg, i);
+        AMS_GREY_BLACKEN(seg, i);
+        if (i+1 < j)
+          AMS_RANGE_BLACKEN(seg, i+1, j);
+      }
+    }
   }
 }
 
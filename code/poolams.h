@@ -70,6 +70,10 @@ typedef struct AMSSegStruct {
   Bool colourTablesInUse;/* the colour tables are in use */
   BT nonwhiteTable;      /* set if grain not white */
   BT nongreyTable;       /* set if not first grain of grey object */
+  /* <design/poolams/#scan.stack> */
+  Count greyCount;       /* number of entries in greyStack */
+  Bool greyOverflow;     /* some grey object is missing from greyStack */
+  Index greyStack[AMSGreyStackLENGTH]; /* grains of newly grey objects */
   Sig sig;
 } AMSSegStruct;
 
@@ -146,13 +150,11 @@ typedef struct AMSSegStruct {
     BTSetRange(Seg2AMSSeg(seg)->nongreyTable, base, limit); \
   END
 
-#define AMSFindGrey(pos, dummy, seg, base, limit) \
-  BTFindShortResRange(pos, dummy, Seg2AMSSeg(seg)->nongreyTable, \
-                      base, limit, 1)
+#define AMSFindGrey(pos, seg, base, limit) \
+  BTFindFirstRes(pos, Seg2AMSSeg(seg)->nongreyTable, base, limit)
 
-#define AMSFindWhite(pos, dummy, seg, base, limit) \
-  BTFindShortResRange(pos, dummy, Seg2AMSSeg(seg)->nonwhiteTable, \
-                      base, limit, 1)
+#define AMSFindWhite(pos, seg, base, limit) \
+  BTFindFirstRes(pos, Seg2AMSSeg(seg)->nonwhiteTable, base, limit)
 
 #define AMS_FIND_WHITE_RANGE(baseOut, limitOut, seg, base, limit) \
   BTFindLongResRange(baseOut, limitOut, Seg2AMSSeg(seg)->nonwhiteTable, \
@@ -87,6 +87,8 @@ typedef struct AWLPoolStruct {
   PoolGenStruct pgenStruct; /* generation representing the pool */
   PoolGen pgen;             /* NULL or pointer to pgenStruct */
   Count succAccesses;       /* number of successive single accesses */
+  Bool haveSegSALimit;      /* limit single accesses per segment? */
+  Count segSALimit;         /* single accesses per segment per cycle */
   FindDependentFunction findDependent; /*  to find a dependent object */
   awlStatTotalStruct stats;
   Sig sig;
@@ -296,7 +298,10 @@ DEFINE_CLASS(Seg, AWLSeg, klass)
  * AWLTotalSALimit is the total number of accesses during a GC cycle.
  *
  * These should be set in config.h, but are here in static variables so that
- * it's possible to tweak them in a debugger.
+ * it's possible to tweak them in a debugger.  AWLInit copies the segment
+ * limit into each pool (or takes MPS_KEY_AWL_SINGLE_ACCESS_LIMIT instead),
+ * so changing AWLSegSALimit or AWLHaveSegSALimit only affects pools
+ * created afterwards.  The total limit is read on every access.
  */
 
 extern Count AWLSegSALimit;
@@ -352,9 +357,11 @@ static Bool AWLCanTrySingleAccess(Arena arena, AWL awl, Seg seg, Addr addr)
 
   /* If there have been too many single accesses to this segment
      then don't keep trying them, even if it means retaining objects.
-     (Observed behaviour in Open Dylan 2012-09-10 by RB.) */
-  if(AWLHaveSegSALimit) {
-    if(awlseg->singleAccesses >= AWLSegSALimit) {
+     (Observed behaviour in Open Dylan 2012-09-10 by RB.)  A limit of
+     zero means the whole segment is scanned on the first access.
+     <design/poolawl/#sa.limit> */
+  if(awl->haveSegSALimit) {
+    if(awlseg->singleAccesses >= awl->segSALimit) {
       STATISTIC(awl->stats.declined++);
       EVENT2(AWLDeclineSeg, seg, (EventFU)awlseg->singleAccesses);
       return FALSE; /* decline single access because of segment limit */
@@ -510,6 +517,7 @@ static Addr awlNoDependent(Addr addr)
 /* AWLInit -- initialize an AWL pool */
 
 ARG_DEFINE_KEY(AWL_FIND_DEPENDENT, Fun);
+ARG_DEFINE_KEY(AWL_SINGLE_ACCESS_LIMIT, Count);
 
 static Res AWLInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 {
@@ -519,6 +527,8 @@ static Res AWLInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   Res res;
   ArgStruct arg;
   unsigned gen = AWL_GEN_DEFAULT;
+  Bool haveSegSALimit = AWLHaveSegSALimit;
+  Count segSALimit = AWLSegSALimit;
 
   AVER(pool != NULL);
   AVERT(Arena, arena);
@@ -535,6 +545,10 @@ static Res AWLInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   }
   if (ArgPick(&arg, args, MPS_KEY_GEN))
     gen = arg.val.u;
+  if (ArgPick(&arg, args, MPS_KEY_AWL_SINGLE_ACCESS_LIMIT)) {
+    haveSegSALimit = TRUE;
+    segSALimit = arg.val.count;
+  }
 
   res = PoolAbsInit(pool, arena, klass, args);
   if (res != ResOK)
@@ -556,6 +570,8 @@ static Res AWLInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 
   awl->alignShift = SizeLog2(PoolAlignment(pool));
   awl->succAccesses = 0;
+  awl->haveSegSALimit = haveSegSALimit;
+  awl->segSALimit = segSALimit;
   awlStatTotalInit(awl);
 
   SetClassOfPoly(pool, CLASS(AWLPool));
@@ -1247,6 +1263,37 @@ mps_pool_class_t mps_class_awl(void)
 }
 
 
+/* mps_awl_scan_segment_hint -- scan the segment containing an object
+ *
+ * If the segment is protected by the read barrier, scan it now, as if
+ * the mutator had hit the barrier and single access had been
+ * declined.  See <design/poolawl/#sa.hint>.
+ */
+
+void mps_awl_scan_segment_hint(mps_pool_t mps_pool, mps_addr_t p)
+{
+  Pool pool = (Pool)mps_pool;
+  Arena arena;
+  AWL awl;
+  Seg seg;
+
+  AVER(TESTT(Pool, pool));
+  arena = PoolArena(pool);
+  ArenaEnter(arena);
+  awl = MustBeA(AWLPool, pool);
+
+  if (SegOfAddr(&seg, arena, (Addr)p)
+      && SegPool(seg) == pool
+      && BS_INTER(SegSM(seg), AccessREAD) != AccessSetEMPTY)
+  {
+    TraceSegAccess(arena, seg, AccessREAD);
+    AWLNoteSegAccess(awl, seg, (Addr)p);
+  }
+
+  ArenaLeave(arena);
+}
+
+
 /* AWLCheck -- check an AWL pool */
 
 ATTRIBUTE_UNUSED
@@ -1257,6 +1304,8 @@ static Bool AWLCheck(AWL awl)
   CHECKD(Pool, CouldBeA(Pool, awl));
   CHECKL(AWLGrainsSize(awl, (Count)1) == PoolAlignment(CouldBeA(Pool, awl)));
   /* Nothing to check about succAccesses. */
+  CHECKL(BoolCheck(awl->haveSegSALimit));
+  /* Nothing to check about segSALimit. */
   CHECKL(FUNCHECK(awl->findDependent));
   /* Don't bother to check stats. */
   return TRUE;
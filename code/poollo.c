@@ -26,6 +26,11 @@ typedef struct LOStruct {
   Shift alignShift;             /* log_2 of pool alignment */
   PoolGenStruct pgenStruct;     /* generation representing the pool */
   PoolGen pgen;                 /* NULL or pointer to pgenStruct */
+  Bool lazySweep;               /* defer sweeping? <design/poollo/#sweep.lazy> */
+  Count unsweptSegs;            /* number of segments waiting to be swept */
+  Bool sizeClasses;             /* segregate small objects? <design/poollo/#class> */
+  RingStruct classRing[LO_SIZE_CLASS_COUNT]; /* segments in each class */
+  struct LOSegStruct *classSeg[LO_SIZE_CLASS_COUNT]; /* last filled from */
   Sig sig;
 } LOStruct;
 
@@ -55,6 +60,13 @@ typedef struct LOSegStruct {
   Count bufferedGrains;     /* grains in buffers */
   Count newGrains;          /* grains allocated since last collection */
   Count oldGrains;          /* grains allocated prior to last collection */
+  Count markedGrains;       /* grains in objects marked by exact fixes */
+  STATISTIC_DECL(Count markedCount) /* objects marked by exact fixes */
+  Bool ambiguousFixes;      /* seg has been ambiguously marked since whiten */
+  Bool unswept;             /* reclaimed, but dead objects not yet freed */
+  Count slotGrains;         /* grains per slot, or 0 if not size-classed */
+  BT slots;                 /* slot table: set if slot is in use, or NULL */
+  RingStruct classRing;     /* node in pool's ring for this size class */
   Sig sig;                  /* <code/misc.h#sig> */
 } LOSegStruct;
 
@@ -63,6 +75,7 @@ typedef struct LOSegStruct {
 static Res loSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args);
 static void loSegFinish(Inst inst);
 static Count loSegGrains(LOSeg loseg);
+static Count loSegSlots(LOSeg loseg);
 
 
 /* LOSegClass -- Class definition for LO segments */
@@ -92,11 +105,30 @@ static Bool LOSegCheck(LOSeg loseg)
   CHECKL(loseg->freeGrains + loseg->bufferedGrains + loseg->newGrains
          + loseg->oldGrains
          == SegSize(seg) >> lo->alignShift);
+  CHECKL(BoolCheck(loseg->ambiguousFixes));
+  CHECKL(BoolCheck(loseg->unswept));
+  CHECKL(!loseg->unswept || SegWhite(seg) == TraceSetEMPTY);
+  CHECKL(lo->lazySweep || !loseg->unswept);
+  CHECKL((loseg->slotGrains == 0) == (loseg->slots == NULL));
+  if (loseg->slotGrains != 0) {
+    CHECKL(lo->sizeClasses);
+    CHECKL(SizeIsP2(loseg->slotGrains));
+    CHECKL(SizeLog2(loseg->slotGrains) < LO_SIZE_CLASS_COUNT);
+    CHECKD_NOSIG(Ring, &loseg->classRing);
+  }
   return TRUE;
 }
 
 
-/* loSegInit -- Init method for LO segments */
+/* loSegInit -- Init method for LO segments
+ *
+ * If the slot size argument is non-zero, the segment belongs to a size
+ * class and is allocated in slots of that many grains.  See
+ * <design/poollo/#class>.
+ */
+
+ARG_DEFINE_KEY(lo_seg_slot_grains, Count);
+#define loKeySegSlotGrains (&_mps_key_lo_seg_slot_grains)
 
 static Res loSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
 {
@@ -107,8 +139,13 @@ static Res loSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   Arena arena = PoolArena(pool);
   /* number of bits needed in each control array */
   Count grains;
+  Count slotGrains = 0;
+  ArgStruct arg;
   void *p;
 
+  if (ArgPick(&arg, args, loKeySegSlotGrains))
+    slotGrains = arg.val.count;
+
   /* Initialize the superclass fields first via next-method call */
   res = NextMethod(Seg, LOSeg, init)(seg, pool, base, size, args);
   if(res != ResOK)
@@ -133,6 +170,24 @@ static Res loSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   loseg->bufferedGrains = (Count)0;
   loseg->newGrains = (Count)0;
   loseg->oldGrains = (Count)0;
+  loseg->markedGrains = (Count)0;
+  STATISTIC(loseg->markedCount = (Count)0);
+  loseg->ambiguousFixes = FALSE;
+  loseg->unswept = FALSE;
+  loseg->slotGrains = slotGrains;
+  loseg->slots = NULL;
+  RingInit(&loseg->classRing);
+  if (slotGrains != 0) {
+    Count slots = grains / slotGrains;
+    AVER(lo->sizeClasses);
+    AVER(slots > 0);
+    res = ControlAlloc(&p, arena, BTSize(slots));
+    if (res != ResOK)
+      goto failSlotTable;
+    loseg->slots = p;
+    BTResRange(loseg->slots, 0, slots);
+    RingAppend(&lo->classRing[SizeLog2(slotGrains)], &loseg->classRing);
+  }
 
   SetClassOfPoly(seg, CLASS(LOSeg));
   loseg->sig = LOSegSig;
@@ -140,6 +195,9 @@ static Res loSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
 
   return ResOK;
 
+failSlotTable:
+  RingFinish(&loseg->classRing);
+  ControlFree(arena, loseg->alloc, tablebytes);
 failAllocTable:
   ControlFree(arena, loseg->mark, tablebytes);
 failMarkTable:
@@ -157,10 +215,20 @@ static void loSegFinish(Inst inst)
   Seg seg = MustBeA(Seg, inst);
   LOSeg loseg = MustBeA(LOSeg, seg);
   Pool pool = SegPool(seg);
+  LO lo = MustBeA(LOPool, pool);
   Arena arena = PoolArena(pool);
   Size tablesize;
   Count grains;
 
+  if (loseg->slotGrains != 0) {
+    Index k = SizeLog2(loseg->slotGrains);
+    if (lo->classSeg[k] == loseg)
+      lo->classSeg[k] = NULL;
+    RingRemove(&loseg->classRing);
+    ControlFree(arena, loseg->slots, BTSize(loSegSlots(loseg)));
+  }
+  RingFinish(&loseg->classRing);
+
   loseg->sig = SigInvalid;
 
   grains = loSegGrains(loseg);
@@ -182,6 +250,15 @@ static Count loSegGrains(LOSeg loseg)
 }
 
 
+/* loSegSlots -- number of slots in a size class segment */
+
+static Count loSegSlots(LOSeg loseg)
+{
+  AVER(loseg->slotGrains != 0);
+  return loSegGrains(loseg) / loseg->slotGrains;
+}
+
+
 /* Conversion between indexes and Addrs */
 #define loIndexOfAddr(base, lo, p) \
   (AddrOffset((base), (p)) >> (lo)->alignShift)
@@ -190,7 +267,11 @@ static Count loSegGrains(LOSeg loseg)
   (AddrAdd((base), LOGrainsSize((lo), (i))))
 
 
-/* loSegFree -- mark block from baseIndex to limitIndex free */
+/* loSegFree -- mark block from baseIndex to limitIndex free
+ *
+ * In a size class segment, a slot becomes free when the last of its
+ * grains does.  See <design/poollo/#class.free>.
+ */
 
 static void loSegFree(LOSeg loseg, Index baseIndex, Index limitIndex)
 {
@@ -201,6 +282,137 @@ static void loSegFree(LOSeg loseg, Index baseIndex, Index limitIndex)
   AVER(BTIsSetRange(loseg->alloc, baseIndex, limitIndex));
   BTResRange(loseg->alloc, baseIndex, limitIndex);
   BTSetRange(loseg->mark, baseIndex, limitIndex);
+
+  if (loseg->slotGrains != 0) {
+    Count slotGrains = loseg->slotGrains;
+    Index slot = baseIndex / slotGrains;
+    Index slotLimit = (limitIndex + slotGrains - 1) / slotGrains;
+    if (slotLimit > loSegSlots(loseg))
+      slotLimit = loSegSlots(loseg);
+    for (; slot < slotLimit; ++slot)
+      if (BTGet(loseg->slots, slot)
+          && BTIsResRange(loseg->alloc, slot * slotGrains,
+                          (slot + 1) * slotGrains))
+        BTRes(loseg->slots, slot);
+  }
+}
+
+
+/* loSegSweep -- free the unmarked objects in an LO segment
+ *
+ * Returns the number of grains freed.  Also returns whether anything
+ * in the segment is still in use (a marked object or a buffer), and
+ * the number and size of the marked objects.
+ *
+ * Could consider implementing this using Walk.
+ */
+
+static Count loSegSweep(Bool *markedReturn,
+                        Count *preservedInPlaceCountReturn,
+                        Size *preservedInPlaceSizeReturn,
+                        LOSeg loseg)
+{
+  Addr p, base, limit;
+  Bool marked;
+  Count reclaimedGrains = (Count)0;
+  Seg seg = MustBeA(Seg, loseg);
+  Pool pool = SegPool(seg);
+  LO lo = MustBeA(LOPool, pool);
+  Format format = NULL; /* supress "may be used uninitialized" warning */
+  Count preservedInPlaceCount = (Count)0;
+  Size preservedInPlaceSize = (Size)0;
+  Bool b;
+
+  AVER(markedReturn != NULL);
+  AVER(preservedInPlaceCountReturn != NULL);
+  AVER(preservedInPlaceSizeReturn != NULL);
+  AVERT(LOSeg, loseg);
+
+  base = SegBase(seg);
+  limit = SegLimit(seg);
+  marked = FALSE;
+
+  b = PoolFormat(&format, pool);
+  AVER(b);
+
+  /* i is the index of the current pointer,
+   * p is the actual address that is being considered.
+   * j and q act similarly for a pointer which is used to
+   * point at the end of the current object.
+   */
+  p = base;
+  while(p < limit) {
+    Buffer buffer;
+    Bool hasBuffer = SegBuffer(&buffer, seg);
+    Addr q;
+    Index i;
+
+    if (hasBuffer) {
+      marked = TRUE;
+      if (p == BufferScanLimit(buffer)
+          && BufferScanLimit(buffer) != BufferLimit(buffer)) {
+        /* skip over buffered area */
+        p = BufferLimit(buffer);
+        continue;
+      }
+      /* since we skip over the buffered area we are always */
+      /* either before the buffer, or after it, never in it */
+      AVER(p < BufferGetInit(buffer) || BufferLimit(buffer) <= p);
+    }
+    i = loIndexOfAddr(base, lo, p);
+    if(!BTGet(loseg->alloc, i)) {
+      /* This grain is free */
+      p = AddrAdd(p, pool->alignment);
+      continue;
+    }
+    q = (*format->skip)(AddrAdd(p, format->headerSize));
+    q = AddrSub(q, format->headerSize);
+    if(BTGet(loseg->mark, i)) {
+      marked = TRUE;
+      ++preservedInPlaceCount;
+      preservedInPlaceSize += AddrOffset(p, q);
+    } else {
+      Index j = loIndexOfAddr(base, lo, q);
+      /* This object is not marked, so free it */
+      loSegFree(loseg, i, j);
+      reclaimedGrains += j - i;
+    }
+    p = q;
+  }
+  AVER(p == limit);
+
+  *markedReturn = marked;
+  *preservedInPlaceCountReturn = preservedInPlaceCount;
+  *preservedInPlaceSizeReturn = preservedInPlaceSize;
+  return reclaimedGrains;
+}
+
+
+/* loSegFinishSweep -- finish reclaiming a lazily reclaimed segment
+ *
+ * The accounting was done by loSegReclaim, so this only needs to free
+ * the dead objects in the tables.  It must be called before anything
+ * relies on the alloc table (allocating, whitening, or walking the
+ * segment).  See <design/poollo/#sweep.lazy>.
+ */
+
+static void loSegFinishSweep(LOSeg loseg)
+{
+  Seg seg = MustBeA(Seg, loseg);
+  LO lo = MustBeA(LOPool, SegPool(seg));
+  Bool marked;
+  Count count;
+  Size size;
+
+  AVERT(LOSeg, loseg);
+
+  if (!loseg->unswept)
+    return;
+
+  (void)loSegSweep(&marked, &count, &size, loseg);
+  AVER(lo->unsweptSegs > 0);
+  --lo->unsweptSegs;
+  loseg->unswept = FALSE;
 }
 
 
@@ -231,11 +443,14 @@ static Bool loSegFindFree(Addr *bReturn, Addr *lReturn,
   AVER(agrains >= 1);
   AVER(agrains <= loseg->freeGrains);
   AVER(size <= SegSize(seg));
+  AVER(loseg->slotGrains == 0);
 
   if (SegHasBuffer(seg))
     /* Don't bother trying to allocate from a buffered segment */
     return FALSE;
 
+  loSegFinishSweep(loseg);
+
   grains = loSegGrains(loseg);
   if(!BTFindLongResRange(&baseIndex, &limitIndex, loseg->alloc,
                      0, grains, agrains)) {
@@ -253,12 +468,48 @@ static Bool loSegFindFree(Addr *bReturn, Addr *lReturn,
 }
 
 
+/* loSegFindSlots -- find free slots in a size class segment
+ *
+ * Returns the first run of free slots, which may be more than one
+ * slot long.  See <design/poollo/#class.fill>.
+ */
+
+static Bool loSegFindSlots(Addr *bReturn, Addr *lReturn, LOSeg loseg)
+{
+  Seg seg = MustBeA(Seg, loseg);
+  LO lo = MustBeA(LOPool, SegPool(seg));
+  Count slots;
+  Index baseSlot, limitSlot;
+
+  AVER(bReturn != NULL);
+  AVER(lReturn != NULL);
+  AVERT(LOSeg, loseg);
+  AVER(loseg->slotGrains != 0);
+
+  if (SegHasBuffer(seg) || loseg->freeGrains < loseg->slotGrains)
+    return FALSE;
+
+  loSegFinishSweep(loseg);
+
+  slots = loSegSlots(loseg);
+  if (!BTFindLongResRange(&baseSlot, &limitSlot, loseg->slots,
+                          0, slots, 1))
+    return FALSE;
+
+  *bReturn = loAddrOfIndex(SegBase(seg), lo, baseSlot * loseg->slotGrains);
+  *lReturn = loAddrOfIndex(SegBase(seg), lo, limitSlot * loseg->slotGrains);
+  return TRUE;
+}
+
+
 /* loSegCreate -- Creates a segment of size at least size.
  *
- * Segments will be multiples of ArenaGrainSize.
+ * Segments will be multiples of ArenaGrainSize.  If slotGrains is
+ * non-zero, the segment belongs to that size class.
  */
 
-static Res loSegCreate(LOSeg *loSegReturn, Pool pool, Size size)
+static Res loSegCreate(LOSeg *loSegReturn, Pool pool, Size size,
+                       Count slotGrains)
 {
   LO lo = MustBeA(LOPool, pool);
   Seg seg;
@@ -267,9 +518,12 @@ static Res loSegCreate(LOSeg *loSegReturn, Pool pool, Size size)
   AVER(loSegReturn != NULL);
   AVER(size > 0);
 
-  res = PoolGenAlloc(&seg, lo->pgen, CLASS(LOSeg),
-                     SizeArenaGrains(size, PoolArena(pool)),
-                     argsNone);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD_FIELD(args, loKeySegSlotGrains, count, slotGrains);
+    res = PoolGenAlloc(&seg, lo->pgen, CLASS(LOSeg),
+                       SizeArenaGrains(size, PoolArena(pool)),
+                       args);
+  } MPS_ARGS_END(args);
   if (res != ResOK)
     return res;
 
@@ -280,77 +534,40 @@ static Res loSegCreate(LOSeg *loSegReturn, Pool pool, Size size)
 
 /* loSegReclaim -- reclaim white objects in an LO segment
  *
- * Could consider implementing this using Walk.
+ * If the pool sweeps lazily and there were no ambiguous fixes, the
+ * size of the surviving objects is already known from LOFix, so this
+ * only does the accounting, and leaves the segment to be swept later.
+ * See <design/poollo/#sweep.lazy>.
  */
 
 static void loSegReclaim(LOSeg loseg, Trace trace)
 {
-  Addr p, base, limit;
   Bool marked;
-  Count reclaimedGrains = (Count)0;
+  Count reclaimedGrains;
   Seg seg = MustBeA(Seg, loseg);
   Pool pool = SegPool(seg);
   LO lo = MustBeA(LOPool, pool);
-  Format format = NULL; /* supress "may be used uninitialized" warning */
   Count preservedInPlaceCount = (Count)0;
   Size preservedInPlaceSize = (Size)0;
-  Bool b;
 
   AVERT(LOSeg, loseg);
   AVERT(Trace, trace);
-
-  base = SegBase(seg);
-  limit = SegLimit(seg);
-  marked = FALSE;
-
-  b = PoolFormat(&format, pool);
-  AVER(b);
-
-  /* i is the index of the current pointer,
-   * p is the actual address that is being considered.
-   * j and q act similarly for a pointer which is used to
-   * point at the end of the current object.
-   */
-  p = base;
-  while(p < limit) {
-    Buffer buffer;
-    Bool hasBuffer = SegBuffer(&buffer, seg);
-    Addr q;
-    Index i;
-
-    if (hasBuffer) {
-      marked = TRUE;
-      if (p == BufferScanLimit(buffer)
-          && BufferScanLimit(buffer) != BufferLimit(buffer)) {
-        /* skip over buffered area */
-        p = BufferLimit(buffer);
-        continue;
-      }
-      /* since we skip over the buffered area we are always */
-      /* either before the buffer, or after it, never in it */
-      AVER(p < BufferGetInit(buffer) || BufferLimit(buffer) <= p);
-    }
-    i = loIndexOfAddr(base, lo, p);
-    if(!BTGet(loseg->alloc, i)) {
-      /* This grain is free */
-      p = AddrAdd(p, pool->alignment);
-      continue;
-    }
-    q = (*format->skip)(AddrAdd(p, format->headerSize));
-    q = AddrSub(q, format->headerSize);
-    if(BTGet(loseg->mark, i)) {
-      marked = TRUE;
-      ++preservedInPlaceCount;
-      preservedInPlaceSize += AddrOffset(p, q);
-    } else {
-      Index j = loIndexOfAddr(base, lo, q);
-      /* This object is not marked, so free it */
-      loSegFree(loseg, i, j);
-      reclaimedGrains += j - i;
+  AVER(!loseg->unswept);
+
+  if (lo->lazySweep && !loseg->ambiguousFixes) {
+    AVER(loseg->markedGrains <= loseg->oldGrains);
+    STATISTIC(preservedInPlaceCount = loseg->markedCount);
+    reclaimedGrains = loseg->oldGrains - loseg->markedGrains;
+    preservedInPlaceSize = LOGrainsSize(lo, loseg->markedGrains);
+    marked = loseg->markedGrains > 0 || SegHasBuffer(seg);
+    if (marked && reclaimedGrains > 0) {
+      loseg->unswept = TRUE;
+      ++lo->unsweptSegs;
     }
-    p = q;
+  } else {
+    reclaimedGrains = loSegSweep(&marked, &preservedInPlaceCount,
+                                 &preservedInPlaceSize, loseg);
   }
-  AVER(p == limit);
 
   AVER(reclaimedGrains <= loSegGrains(loseg));
   AVER(loseg->oldGrains >= reclaimedGrains);
@@ -394,6 +611,9 @@ static void LOWalk(Pool pool, Seg seg, FormattedObjectsVisitor f,
   b = PoolFormat(&format, pool);
   AVER(b);
 
+  /* Don't visit objects that are already known to be dead. */
+  loSegFinishSweep(loseg);
+
   base = SegBase(seg);
   grains = loSegGrains(loseg);
   i = 0;
@@ -447,6 +667,9 @@ static void LOVarargs(ArgStruct args[MPS_ARGS_MAX], va_list varargs)
 
 /* LOInit -- initialize an LO pool */
 
+ARG_DEFINE_KEY(LO_LAZY_SWEEP, Bool);
+ARG_DEFINE_KEY(LO_SIZE_CLASSES, Bool);
+
 static Res LOInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 {
   LO lo;
@@ -454,6 +677,9 @@ static Res LOInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   ArgStruct arg;
   Chain chain;
   unsigned gen = LO_GEN_DEFAULT;
+  Bool lazySweep = LO_LAZY_SWEEP_DEFAULT;
+  Bool sizeClasses = LO_SIZE_CLASSES_DEFAULT;
+  Index k;
 
   AVER(pool != NULL);
   AVERT(Arena, arena);
@@ -476,8 +702,14 @@ static Res LOInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   }
   if (ArgPick(&arg, args, MPS_KEY_GEN))
     gen = arg.val.u;
+  if (ArgPick(&arg, args, MPS_KEY_LO_LAZY_SWEEP))
+    lazySweep = arg.val.b;
+  if (ArgPick(&arg, args, MPS_KEY_LO_SIZE_CLASSES))
+    sizeClasses = arg.val.b;
   
   AVERT(Format, pool->format);
+  AVERT(Bool, lazySweep);
+  AVERT(Bool, sizeClasses);
   AVER(FormatArena(pool->format) == arena);
   AVERT(Chain, chain);
   AVER(gen <= ChainGens(chain));
@@ -487,6 +719,13 @@ static Res LOInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   lo->alignShift = SizeLog2((Size)PoolAlignment(pool));
 
   lo->pgen = NULL;
+  lo->lazySweep = lazySweep;
+  lo->unsweptSegs = 0;
+  lo->sizeClasses = sizeClasses;
+  for (k = 0; k < LO_SIZE_CLASS_COUNT; ++k) {
+    RingInit(&lo->classRing[k]);
+    lo->classSeg[k] = NULL;
+  }
 
   SetClassOfPoly(pool, CLASS(LOPool));
   lo->sig = LOSig;
@@ -502,6 +741,8 @@ static Res LOInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   return ResOK;
 
 failGenInit:
+  for (k = 0; k < LO_SIZE_CLASS_COUNT; ++k)
+    RingFinish(&lo->classRing[k]);
   NextMethod(Inst, LOPool, finish)(MustBeA(Inst, pool));
 failAbsInit:
   AVER(res != ResOK);
@@ -516,6 +757,7 @@ static void LOFinish(Inst inst)
   Pool pool = MustBeA(AbstractPool, inst);
   LO lo = MustBeA(LOPool, pool);
   Ring node, nextNode;
+  Index k;
 
   RING_FOR(node, &pool->segRing, nextNode) {
     Seg seg = SegOfPoolRing(node);
@@ -531,12 +773,86 @@ static void LOFinish(Inst inst)
   }
   PoolGenFinish(lo->pgen);
 
+  for (k = 0; k < LO_SIZE_CLASS_COUNT; ++k) {
+    AVER(lo->classSeg[k] == NULL);
+    RingFinish(&lo->classRing[k]);
+  }
+
   lo->sig = SigInvalid;
 
   NextMethod(Inst, LOPool, finish)(inst);
 }
 
 
+/* loSizeClass -- find the size class for a buffer fill, if any
+ *
+ * Class k has slots of 2^k grains.  See <design/poollo/#class>.
+ */
+
+static Bool loSizeClass(Index *classReturn, LO lo, Size size)
+{
+  Count grains = size >> lo->alignShift;
+  Index k;
+
+  AVER(classReturn != NULL);
+  AVER(grains > 0);
+
+  if (!lo->sizeClasses)
+    return FALSE;
+  k = (grains == 1) ? 0 : (Index)SizeFloorLog2((Size)(grains - 1)) + 1;
+  if (k >= LO_SIZE_CLASS_COUNT)
+    return FALSE;
+  *classReturn = k;
+  return TRUE;
+}
+
+
+/* loClassFindSlots -- find free slots in a size class
+ *
+ * Tries the segment this class was last filled from, then the other
+ * segments in the class, emptiest first.  See
+ * <design/poollo/#class.fill>.
+ */
+
+static Bool loClassFindSlots(Addr *bReturn, Addr *lReturn,
+                             LOSeg *loSegReturn, LO lo, Index k)
+{
+  Ring node, nextNode;
+  LOSeg loseg, best = NULL;
+
+  loseg = lo->classSeg[k];
+  if (loseg != NULL && loSegFindSlots(bReturn, lReturn, loseg))
+    goto found;
+
+  RING_FOR(node, &lo->classRing[k], nextNode) {
+    loseg = RING_ELT(LOSeg, classRing, node);
+    if (loseg != lo->classSeg[k]
+        && (best == NULL || loseg->freeGrains > best->freeGrains))
+      best = loseg;
+  }
+  if (best == NULL)
+    return FALSE;
+  loseg = best;
+  if (loSegFindSlots(bReturn, lReturn, loseg))
+    goto found;
+
+  /* The emptiest segment may be buffered, or its free grains may not
+     make up a whole slot, so try the rest. */
+  RING_FOR(node, &lo->classRing[k], nextNode) {
+    loseg = RING_ELT(LOSeg, classRing, node);
+    if (loseg != lo->classSeg[k] && loseg != best
+        && loSegFindSlots(bReturn, lReturn, loseg))
+      goto found;
+  }
+  return FALSE;
+
+found:
+  lo->classSeg[k] = loseg;
+  *loSegReturn = loseg;
+  return TRUE;
+}
+
+
 static Res LOBufferFill(Addr *baseReturn, Addr *limitReturn,
                         Pool pool, Buffer buffer,
                         Size size)
@@ -547,6 +863,7 @@ static Res LOBufferFill(Addr *baseReturn, Addr *limitReturn,
   LOSeg loseg;
   Addr base, limit;
   Seg seg;
+  Index k;
 
   AVER(baseReturn != NULL);
   AVER(limitReturn != NULL);
@@ -556,18 +873,37 @@ static Res LOBufferFill(Addr *baseReturn, Addr *limitReturn,
   AVER(size > 0);
   AVER(SizeIsAligned(size, PoolAlignment(pool)));
 
+  if (loSizeClass(&k, lo, size)) {
+    Count slotGrains = (Count)1 << k;
+    if (loClassFindSlots(&base, &limit, &loseg, lo, k)) {
+      seg = MustBeA(Seg, loseg);
+      goto found;
+    }
+    res = loSegCreate(&loseg, pool,
+                      LOGrainsSize(lo, slotGrains * LO_SIZE_CLASS_SEG_SLOTS),
+                      slotGrains);
+    if (res != ResOK)
+      return res;
+    lo->classSeg[k] = loseg;
+    seg = MustBeA(Seg, loseg);
+    base = SegBase(seg);
+    limit = loAddrOfIndex(base, lo, loSegSlots(loseg) * slotGrains);
+    goto found;
+  }
+
   /* Try to find a segment with enough space already. */
   RING_FOR(node, PoolSegRing(pool), nextNode) {
     seg = SegOfPoolRing(node);
     loseg = MustBeA(LOSeg, seg);
     AVERT(LOSeg, loseg);
-    if(LOGrainsSize(lo, loseg->freeGrains) >= size
+    if(loseg->slotGrains == 0
+       && LOGrainsSize(lo, loseg->freeGrains) >= size
        && loSegFindFree(&base, &limit, loseg, size))
       goto found;
   }
 
   /* No segment had enough space, so make a new one. */
-  res = loSegCreate(&loseg, pool, size);
+  res = loSegCreate(&loseg, pool, size, 0);
   if(res != ResOK)
     return res;
   seg = MustBeA(Seg, loseg);
@@ -586,6 +922,14 @@ found:
     AVER(BTIsResRange(loseg->alloc, baseIndex, limitIndex));
     AVER(BTIsSetRange(loseg->mark, baseIndex, limitIndex));
     BTSetRange(loseg->alloc, baseIndex, limitIndex);
+    if (loseg->slotGrains != 0) {
+      AVER(baseIndex % loseg->slotGrains == 0);
+      AVER(limitIndex % loseg->slotGrains == 0);
+      AVER(BTIsResRange(loseg->slots, baseIndex / loseg->slotGrains,
+                        limitIndex / loseg->slotGrains));
+      BTSetRange(loseg->slots, baseIndex / loseg->slotGrains,
+                 limitIndex / loseg->slotGrains);
+    }
     AVER(loseg->freeGrains >= limitIndex - baseIndex);
     loseg->freeGrains -= limitIndex - baseIndex;
     loseg->bufferedGrains += limitIndex - baseIndex;
@@ -658,6 +1002,12 @@ static Res LOWhiten(Pool pool, Trace trace, Seg seg)
   AVERT(Trace, trace);
   AVER(SegWhite(seg) == TraceSetEMPTY);
 
+  /* The mark table is about to be reused. */
+  loSegFinishSweep(loseg);
+  loseg->markedGrains = 0;
+  STATISTIC(loseg->markedCount = 0);
+  loseg->ambiguousFixes = FALSE;
+
   grains = loSegGrains(loseg);
 
   /* Whiten allocated objects; leave free areas black. */
@@ -734,6 +1084,18 @@ static Res LOFix(Pool pool, ScanState ss, Seg seg, Ref *refIO)
         *refIO = (Addr)0;
       } else {
         BTSet(loseg->mark, i);
+        if (lo->lazySweep) {
+          /* <design/poollo/#sweep.lazy.fix> */
+          if (ss->rank == RankAMBIG) {
+            /* Might not be the start of an object, so can't be sized. */
+            loseg->ambiguousFixes = TRUE;
+          } else {
+            Addr next = (*pool->format->skip)(clientRef);
+            next = AddrSub(next, pool->format->headerSize);
+            loseg->markedGrains += AddrOffset(base, next) >> lo->alignShift;
+            STATISTIC(++loseg->markedCount);
+          }
+        }
       }
     }
   } break;
@@ -759,6 +1121,31 @@ static void LOReclaim(Pool pool, Trace trace, Seg seg)
 }
 
 
+/* LOSweep -- finish sweeping one lazily reclaimed segment
+ *
+ * See <design/poollo/#sweep.idle>.
+ */
+
+static Bool LOSweep(Pool pool)
+{
+  LO lo = MustBeA(LOPool, pool);
+  Ring node, nextNode;
+
+  if (lo->unsweptSegs == 0)
+    return FALSE;
+
+  RING_FOR(node, PoolSegRing(pool), nextNode) {
+    LOSeg loseg = MustBeA(LOSeg, SegOfPoolRing(node));
+    if (loseg->unswept) {
+      loSegFinishSweep(loseg);
+      return TRUE;
+    }
+  }
+  NOTREACHED;
+  return FALSE;
+}
+
+
 /* LOTotalSize -- total memory allocated from the arena */
 /* TODO: This code is repeated in AMS */
 
@@ -796,6 +1183,7 @@ DEFINE_CLASS(Pool, LOPool, klass)
   klass->fix = LOFix;
   klass->fixEmergency = LOFix;
   klass->reclaim = LOReclaim;
+  klass->sweep = LOSweep;
   klass->walk = LOWalk;
   klass->totalSize = LOTotalSize;
   klass->freeSize = LOFreeSize;
@@ -821,6 +1209,10 @@ static Bool LOCheck(LO lo)
   CHECKC(LOPool, lo);
   CHECKL(ShiftCheck(lo->alignShift));
   CHECKL(LOGrainsSize(lo, (Count)1) == PoolAlignment(MustBeA(AbstractPool, lo)));
+  CHECKL(BoolCheck(lo->lazySweep));
+  CHECKL(lo->lazySweep || lo->unsweptSegs == 0);
+  CHECKL(BoolCheck(lo->sizeClasses));
+  /* Could check that each class ring contains only segments of that class. */
   if (lo->pgen != NULL) {
     CHECKL(lo->pgen == &lo->pgenStruct);
     CHECKD(PoolGen, lo->pgen);
@@ -29,6 +29,19 @@
  *
  * .buffer.not: This pool doesn't support fast cache allocation, which
  * is a shame.
+ *
+ * .magazine: If the pool was created with MPS_KEY_MFS_MAGAZINE_SIZE
+ * greater than zero, it keeps a magazine layer in front of the free
+ * list, after Bonwick and Adams.  A magazine is a chain of up to that
+ * many free units.  Each slot holds two magazines (loaded and
+ * previous), and a depot holds full magazines.  MFSTryAlloc and
+ * MFSTryFree work on the caller's slot under the slot's lock, and
+ * exchange magazines with the depot under the depot's lock, without
+ * the arena lock.  Only when the depot has no full magazine to give,
+ * or no room to take one, does a request enter the arena and reach
+ * MFSAlloc or MFSFree, which move a magazine between the depot and
+ * the free list.  Locks are claimed in the order arena, slot, depot.
+ * See <design/poolmfs/#magazine>.
  */
 
 #include "mpscmfs.h"
@@ -57,6 +70,40 @@ typedef struct MFSHeaderStruct {
 #define UNIT_MIN        sizeof(HeaderStruct)
 
 
+/* MFSSlotStruct -- pair of magazines
+ *
+ * .magazine.slot: Bonwick keeps a pair of magazines for each CPU.  The
+ * MPS has no portable way to find the current CPU or thread, so a
+ * thread uses the slot found by hashing the address of its stack
+ * (mfsSlot).  Threads that share a slot are still correct; they just
+ * contend for its lock.
+ */
+
+typedef struct MFSSlotStruct {
+  Lock lock;                    /* protects the rest of the slot */
+  Header loaded;                /* units in the loaded magazine */
+  Count loadedRounds;           /* number of units in it */
+  Header previous;              /* units in the previous magazine */
+  Count previousRounds;         /* number of units in it */
+} MFSSlotStruct, *MFSSlot;
+
+
+/* MFSMagazinesStruct -- magazine layer; see .magazine
+ *
+ * .magazine.chain: A magazine is a chain of free units linked through
+ * their headers, so magazines need no memory of their own, and an
+ * empty magazine is just a count of zero.
+ */
+
+typedef struct MFSMagazinesStruct {
+  Count size;                   /* units in a full magazine */
+  Lock depotLock;               /* protects depot and depotCount */
+  Count depotCount;             /* number of full magazines */
+  Header depot[MFS_DEPOT_LIMIT]; /* full magazines */
+  MFSSlotStruct slot[MFS_MAGAZINE_SLOTS];
+} MFSMagazinesStruct, *MFSMagazines;
+
+
 /* MFSVarargs -- decode obsolete varargs */
 
 static void MFSVarargs(ArgStruct args[MPS_ARGS_MAX], va_list varargs)
@@ -70,12 +117,75 @@ static void MFSVarargs(ArgStruct args[MPS_ARGS_MAX], va_list varargs)
 }
 
 ARG_DEFINE_KEY(MFS_UNIT_SIZE, Size);
+ARG_DEFINE_KEY(MFS_MAGAZINE_SIZE, Count);
 ARG_DEFINE_KEY(MFSExtendSelf, Bool);
 
+
+/* mfsMagazinesCreate, mfsMagazinesDestroy -- magazine layer */
+
+static Res mfsMagazinesCreate(MFS mfs, Arena arena, Count size)
+{
+  MFSMagazines mags;
+  Index i;
+  void *p;
+  Res res;
+
+  AVER(size > 0);
+
+  res = ControlAlloc(&p, arena, sizeof(MFSMagazinesStruct));
+  if (res != ResOK)
+    goto failMagazinesAlloc;
+  mags = p;
+
+  /* Allocate all the locks in one block. */
+  res = ControlAlloc(&p, arena, LockSize() * (MFS_MAGAZINE_SLOTS + 1));
+  if (res != ResOK)
+    goto failLocksAlloc;
+  mags->depotLock = p;
+  LockInit(mags->depotLock);
+  for (i = 0; i < MFS_MAGAZINE_SLOTS; ++i) {
+    MFSSlot slot = &mags->slot[i];
+    slot->lock = (Lock)PointerAdd(p, LockSize() * (i + 1));
+    LockInit(slot->lock);
+    slot->loaded = NULL;
+    slot->loadedRounds = 0;
+    slot->previous = NULL;
+    slot->previousRounds = 0;
+  }
+
+  mags->size = size;
+  mags->depotCount = 0;
+  mfs->magazines = mags;
+  return ResOK;
+
+failLocksAlloc:
+  ControlFree(arena, mags, sizeof(MFSMagazinesStruct));
+failMagazinesAlloc:
+  return res;
+}
+
+static void mfsMagazinesDestroy(MFS mfs)
+{
+  Arena arena = PoolArena(MFSPool(mfs));
+  MFSMagazines mags = mfs->magazines;
+  Index i;
+
+  AVER(mags != NULL);
+  mfs->magazines = NULL;
+  for (i = 0; i < MFS_MAGAZINE_SLOTS; ++i)
+    LockFinish(mags->slot[i].lock);
+  LockFinish(mags->depotLock);
+  ControlFree(arena, mags->depotLock,
+              LockSize() * (MFS_MAGAZINE_SLOTS + 1));
+  ControlFree(arena, mags, sizeof(MFSMagazinesStruct));
+}
+
+
 static Res MFSInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 {
   Size extendBy = MFS_EXTEND_BY_DEFAULT;
   Bool extendSelf = TRUE;
+  Count magazineSize = MFS_MAGAZINE_SIZE_DEFAULT;
   Size unitSize;
   MFS mfs;
   ArgStruct arg;
@@ -90,6 +200,8 @@ static Res MFSInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   unitSize = arg.val.size;
   if (ArgPick(&arg, args, MPS_KEY_EXTEND_BY))
     extendBy = arg.val.size;
+  if (ArgPick(&arg, args, MPS_KEY_MFS_MAGAZINE_SIZE))
+    magazineSize = arg.val.count;
   if (ArgPick(&arg, args, MFSExtendSelf))
     extendSelf = arg.val.b;
 
@@ -119,6 +231,14 @@ static Res MFSInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   mfs->tractList = NULL;
   mfs->total = 0;
   mfs->free = 0;
+  mfs->magazines = NULL;
+  if (magazineSize > 0) {
+    res = mfsMagazinesCreate(mfs, arena, magazineSize);
+    if (res != ResOK) {
+      NextMethod(Inst, MFSPool, finish)(MustBeA(Inst, pool));
+      return res;
+    }
+  }
   mfs->sig = MFSSig;
 
   AVERT(MFS, mfs);
@@ -156,6 +276,10 @@ static void MFSFinish(Inst inst)
 
   MFSFinishTracts(pool, MFSTractFreeVisitor, UNUSED_POINTER);
 
+  /* The units in the magazines went back to the arena with the tracts. */
+  if (mfs->magazines != NULL)
+    mfsMagazinesDestroy(mfs);
+
   mfs->sig = SigInvalid;
 
   NextMethod(Inst, MFSPool, finish)(inst);
@@ -212,6 +336,108 @@ void MFSExtend(Pool pool, Addr base, Size size)
 }
 
 
+/* mfsDepotFill -- add a full magazine to the depot from the free list
+ *
+ * Called by MFSAlloc with the arena lock, when MFSTryAlloc found no
+ * full magazine.  Does nothing if another thread has since put one in
+ * the depot.
+ */
+
+static void mfsDepotFill(MFS mfs)
+{
+  MFSMagazines mags = mfs->magazines;
+  Header list = NULL;
+  Count n;
+
+  LockClaim(mags->depotLock);
+  n = mags->depotCount;
+  LockRelease(mags->depotLock);
+  if (n > 0)
+    return;
+
+  for (n = 0; n < mags->size; ++n) {
+    Header h = mfs->freeList;
+    if (h == NULL) {
+      Addr base;
+      if (!mfs->extendSelf
+          || ArenaAlloc(&base, LocusPrefDefault(), mfs->extendBy,
+                        MFSPool(mfs)) != ResOK)
+        break;
+      MFSExtend(MFSPool(mfs), base, mfs->extendBy);
+      h = mfs->freeList;
+    }
+    mfs->freeList = h->next;
+    mfs->free -= mfs->unitSize;
+    h->next = list;
+    list = h;
+  }
+
+  if (n == mags->size) {
+    LockClaim(mags->depotLock);
+    if (mags->depotCount < MFS_DEPOT_LIMIT) {
+      mags->depot[mags->depotCount] = list;
+      ++mags->depotCount;
+      list = NULL;
+    }
+    LockRelease(mags->depotLock);
+  }
+
+  /* Couldn't fill a magazine, or store it: put the units back. */
+  while (list != NULL) {
+    Header h = list;
+    list = h->next;
+    h->next = mfs->freeList;
+    mfs->freeList = h;
+    mfs->free += mfs->unitSize;
+  }
+}
+
+
+/* mfsDepotDrain -- return a full magazine from the depot to the free list
+ *
+ * Called by MFSFree with the arena lock, when MFSTryFree found the
+ * depot full.
+ */
+
+static void mfsDepotDrain(MFS mfs)
+{
+  MFSMagazines mags = mfs->magazines;
+  Header h = NULL;
+
+  LockClaim(mags->depotLock);
+  if (mags->depotCount > 0) {
+    --mags->depotCount;
+    h = mags->depot[mags->depotCount];
+  }
+  LockRelease(mags->depotLock);
+
+  while (h != NULL) {
+    Header next = h->next;
+    h->next = mfs->freeList;
+    mfs->freeList = h;
+    mfs->free += mfs->unitSize;
+    h = next;
+  }
+}
+
+
+/* mfsSlot -- find the calling thread's slot; see .magazine.slot
+ *
+ * The address of a local variable identifies the stack, and so the
+ * thread.  Drop the low bits, which vary with the depth of the call,
+ * and mix the rest so that stacks a power of two apart spread out.
+ */
+
+#define SLOT_SHIFT 16
+
+static MFSSlot mfsSlot(MFSMagazines mags, void *stackPointer)
+{
+  Word w = (Word)stackPointer >> SLOT_SHIFT;
+  w = (w * (Word)2654435761UL) >> 12;
+  return &mags->slot[w & (MFS_MAGAZINE_SLOTS - 1)];
+}
+
+
 /*  == Allocate ==
  *
  *  Allocation simply involves taking a unit from the front of the freelist
@@ -228,6 +454,11 @@ static Res MFSAlloc(Addr *pReturn, Pool pool, Size size)
   AVER(pReturn != NULL);
   AVER(size == mfs->unroundedUnitSize);
 
+  if (mfs->magazines != NULL) {
+    /* A thread found no full magazine: load the depot with one. */
+    mfsDepotFill(mfs);
+  }
+
   f = mfs->freeList;
 
   /* If the free list is empty then extend the pool with a new region. */
@@ -278,6 +509,11 @@ static void MFSFree(Pool pool, Addr old, Size size)
   AVER(old != (Addr)0);
   AVER(size == mfs->unroundedUnitSize);
 
+  if (mfs->magazines != NULL) {
+    /* A thread found no room in the depot: make some. */
+    mfsDepotDrain(mfs);
+  }
+
   /* .freelist.fragments */
   h = (Header)old;
   h->next = mfs->freeList;
@@ -286,6 +522,112 @@ static void MFSFree(Pool pool, Addr old, Size size)
 }
 
 
+/* MFSTryAlloc -- allocate a unit from a magazine without the arena lock
+ *
+ * If the loaded magazine is empty, and the previous one is not, swap
+ * them.  If both are empty, swap the previous one for a full magazine
+ * from the depot.  See .magazine and <code/pool.c#try.unlocked>.
+ */
+
+static Bool MFSTryAlloc(Addr *pReturn, Pool pool, Size size)
+{
+  MFS mfs = MustBeA_CRITICAL(MFSPool, pool);
+  MFSMagazines mags = mfs->magazines;
+  MFSSlot slot;
+  Header h = NULL;
+
+  AVER_CRITICAL(pReturn != NULL);
+  AVER_CRITICAL(size == mfs->unroundedUnitSize);
+
+  if (mags == NULL)
+    return FALSE;
+
+  slot = mfsSlot(mags, &slot);
+  LockClaim(slot->lock);
+  if (slot->loadedRounds == 0) {
+    if (slot->previousRounds > 0) {
+      slot->loaded = slot->previous;
+      slot->loadedRounds = slot->previousRounds;
+      slot->previous = NULL;
+      slot->previousRounds = 0;
+    } else {
+      LockClaim(mags->depotLock);
+      if (mags->depotCount > 0) {
+        --mags->depotCount;
+        slot->loaded = mags->depot[mags->depotCount];
+        slot->loadedRounds = mags->size;
+      }
+      LockRelease(mags->depotLock);
+    }
+  }
+  if (slot->loadedRounds > 0) {
+    h = slot->loaded;
+    slot->loaded = h->next;
+    --slot->loadedRounds;
+  }
+  LockRelease(slot->lock);
+
+  if (h == NULL)
+    return FALSE;
+  *pReturn = (Addr)h;
+  return TRUE;
+}
+
+
+/* MFSTryFree -- free a unit to a magazine without the arena lock
+ *
+ * If the loaded magazine is full, and the previous one is empty, swap
+ * them.  If both are full, give the previous one to the depot and load
+ * an empty one.  See .magazine and <code/pool.c#try.unlocked>.
+ */
+
+static Bool MFSTryFree(Pool pool, Addr old, Size size)
+{
+  MFS mfs = MustBeA_CRITICAL(MFSPool, pool);
+  MFSMagazines mags = mfs->magazines;
+  MFSSlot slot;
+  Bool freed = FALSE;
+
+  AVER_CRITICAL(old != (Addr)0);
+  AVER_CRITICAL(size == mfs->unroundedUnitSize);
+
+  if (mags == NULL)
+    return FALSE;
+
+  slot = mfsSlot(mags, &slot);
+  LockClaim(slot->lock);
+  if (slot->loadedRounds == mags->size) {
+    if (slot->previousRounds == 0) {
+      slot->previous = slot->loaded;
+      slot->previousRounds = slot->loadedRounds;
+      slot->loaded = NULL;
+      slot->loadedRounds = 0;
+    } else {
+      AVER_CRITICAL(slot->previousRounds == mags->size);
+      LockClaim(mags->depotLock);
+      if (mags->depotCount < MFS_DEPOT_LIMIT) {
+        mags->depot[mags->depotCount] = slot->previous;
+        ++mags->depotCount;
+        slot->previous = slot->loaded;
+        slot->loaded = NULL;
+        slot->loadedRounds = 0;
+      }
+      LockRelease(mags->depotLock);
+    }
+  }
+  if (slot->loadedRounds < mags->size) {
+    Header h = (Header)old;
+    h->next = slot->loaded;
+    slot->loaded = h;
+    ++slot->loadedRounds;
+    freed = TRUE;
+  }
+  LockRelease(slot->lock);
+
+  return freed;
+}
+
+
 /* MFSTotalSize -- total memory allocated from the arena */
 
 static Size MFSTotalSize(Pool pool)
@@ -300,7 +642,25 @@ static Size MFSTotalSize(Pool pool)
 static Size MFSFreeSize(Pool pool)
 {
   MFS mfs = MustBeA(MFSPool, pool);
-  return mfs->free;
+  MFSMagazines mags = mfs->magazines;
+  Size size = mfs->free;
+
+  /* Units in magazines are free too; see .magazine. */
+  if (mags != NULL) {
+    Count rounds;
+    Index i;
+    LockClaim(mags->depotLock);
+    rounds = mags->depotCount * mags->size;
+    LockRelease(mags->depotLock);
+    for (i = 0; i < MFS_MAGAZINE_SLOTS; ++i) {
+      MFSSlot slot = &mags->slot[i];
+      LockClaim(slot->lock);
+      rounds += slot->loadedRounds + slot->previousRounds;
+      LockRelease(slot->lock);
+    }
+    size += rounds * mfs->unitSize;
+  }
+  return size;
 }
 
 
@@ -319,6 +679,15 @@ static Res MFSDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
   if (res != ResOK)
     return res;
 
+  if (mfs->magazines != NULL) {
+    res = WriteF(stream, depth + 2,
+                 "magazine size $W\n", (WriteFW)mfs->magazines->size,
+                 "depot count $W\n", (WriteFW)mfs->magazines->depotCount,
+                 NULL);
+    if (res != ResOK)
+      return res;
+  }
+
   return WriteF(stream, depth + 2,
                 "unroundedUnitSize $W\n", (WriteFW)mfs->unroundedUnitSize,
                 "extendBy $W\n", (WriteFW)mfs->extendBy,
@@ -342,6 +711,8 @@ DEFINE_CLASS(Pool, MFSPool, klass)
   klass->init = MFSInit;
   klass->alloc = MFSAlloc;
   klass->free = MFSFree;
+  klass->tryAlloc = MFSTryAlloc;
+  klass->tryFree = MFSTryFree;
   klass->totalSize = MFSTotalSize;
   klass->freeSize = MFSFreeSize;  
 }
@@ -52,7 +52,7 @@ typedef struct LinkStruct {
   int state;                     /* Free, Prefinal, Final */
   union LinkStructUnion {
     MessageStruct messageStruct; /* state = Final */
-    RingStruct linkRing;         /* state one of {Free, Prefinal} */
+    RingStruct linkRing;         /* state = Prefinal */
   } the;
 } LinkStruct;
 
@@ -113,7 +113,10 @@ static void MRGRefPartSetRef(Arena arena, RefPart refPart, Ref ref)
 typedef struct MRGStruct {
   PoolStruct poolStruct;    /* generic pool structure */
   RingStruct entryRing;     /* <design/poolmrg/#poolstruct.entry> */
-  RingStruct freeRing;      /* <design/poolmrg/#poolstruct.free> */
+  Link *free;               /* <design/poolmrg/#poolstruct.free> */
+  Count freeCount;          /* number of free guardians */
+  Count freeSize;           /* capacity of free */
+  Count guardians;          /* number of guardians */
   RingStruct refRing;       /* <design/poolmrg/#poolstruct.refring> */
   Size extendBy;            /* <design/poolmrg/#extend> */
   Sig sig;                  /* <code/mps.h#sig> */
@@ -136,7 +139,9 @@ static Bool MRGCheck(MRG mrg)
   CHECKD(Pool, pool);
   CHECKC(MRGPool, mrg);
   CHECKD_NOSIG(Ring, &mrg->entryRing);
-  CHECKD_NOSIG(Ring, &mrg->freeRing);
+  CHECKL(mrg->freeCount <= mrg->guardians);
+  CHECKL(mrg->guardians <= mrg->freeSize);
+  CHECKL((mrg->free == NULL) == (mrg->freeSize == 0));
   CHECKD_NOSIG(Ring, &mrg->refRing);
   CHECKL(mrg->extendBy == ArenaGrainSize(PoolArena(pool)));
   return TRUE;
@@ -383,9 +388,11 @@ static void MRGGuardianInit(MRG mrg, Link link, RefPart refPart)
   AVER(link != NULL);
   AVER(refPart != NULL);
 
-  RingInit(&link->the.linkRing);
   link->state = MRGGuardianFREE;
-  RingAppend(&mrg->freeRing, &link->the.linkRing);
+  /* <design/poolmrg/#free.push> */
+  AVER(mrg->freeCount < mrg->freeSize);
+  mrg->free[mrg->freeCount] = link;
+  ++mrg->freeCount;
   /* <design/poolmrg/#free.overwrite> */
   MRGRefPartSetRef(PoolArena(MustBeA(AbstractPool, mrg)), refPart, 0);
 }
@@ -456,6 +463,8 @@ static MessageClassStruct MRGMessageClassStruct = {
   MessageNoGCLiveSize,         /* GCLiveSize */   
   MessageNoGCCondemnedSize,    /* GCCondemnedSize */
   MessageNoGCNotCondemnedSize, /* GCNotCondemnedSize */
+  MessageNoGCCopiedSize,       /* GCCopiedSize */
+  MessageNoGCMarkedSize,       /* GCMarkedSize */
   MessageNoGCStartWhy,         /* GCStartWhy */
   MessageClassSig              /* <design/message/#class.sig.double> */
 };
@@ -491,6 +500,9 @@ static Res MRGSegPairCreate(MRGRefSeg *refSegReturn, MRG mrg)
   MRGLinkSeg linkseg;
   MRGRefSeg refseg;
   Size linkSegSize;
+  Link *free = NULL;
+  Count freeSize = 0;
+  void *p;
 
   AVER(refSegReturn != NULL);
 
@@ -498,6 +510,17 @@ static Res MRGSegPairCreate(MRGRefSeg *refSegReturn, MRG mrg)
   linkSegSize = nGuardians * sizeof(LinkStruct);
   linkSegSize = SizeArenaGrains(linkSegSize, arena);
 
+  /* <design/poolmrg/#alloc.grow.free> */
+  if (mrg->guardians + nGuardians > mrg->freeSize) {
+    freeSize = mrg->freeSize * 2;
+    if (freeSize < mrg->guardians + nGuardians)
+      freeSize = mrg->guardians + nGuardians;
+    res = ControlAlloc(&p, arena, freeSize * sizeof(Link));
+    if (res != ResOK)
+      goto failFreeAlloc;
+    free = p;
+  }
+
   res = SegAlloc(&segLink, CLASS(MRGLinkSeg),
                  LocusPrefDefault(), linkSegSize, pool,
                  argsNone);
@@ -518,10 +541,21 @@ static Res MRGSegPairCreate(MRGRefSeg *refSegReturn, MRG mrg)
   linkBase = (Link)SegBase(segLink);
   refPartBase = (RefPart)SegBase(segRefPart);
 
-  for(i = 0; i < nGuardians; ++i)
-    MRGGuardianInit(mrg, linkBase + i, refPartBase + i);
-  AVER((Addr)(&linkBase[i]) <= SegLimit(segLink));
-  AVER((Addr)(&refPartBase[i]) <= SegLimit(segRefPart));
+  if (free != NULL) {
+    if (mrg->free != NULL) {
+      (void)mps_lib_memcpy(free, mrg->free, mrg->freeCount * sizeof(Link));
+      ControlFree(arena, mrg->free, mrg->freeSize * sizeof(Link));
+    }
+    mrg->free = free;
+    mrg->freeSize = freeSize;
+  }
+  mrg->guardians += nGuardians;
+
+  /* Push in reverse, so that the guardians are popped in address order. */
+  for(i = nGuardians; i > 0; --i)
+    MRGGuardianInit(mrg, linkBase + i - 1, refPartBase + i - 1);
+  AVER((Addr)(&linkBase[nGuardians]) <= SegLimit(segLink));
+  AVER((Addr)(&refPartBase[nGuardians]) <= SegLimit(segRefPart));
 
   *refSegReturn = refseg;
 
@@ -530,6 +564,9 @@ static Res MRGSegPairCreate(MRGRefSeg *refSegReturn, MRG mrg)
 failRefPartSegAlloc:
   SegFree(segLink);
 failLinkSegAlloc:
+  if (free != NULL)
+    ControlFree(arena, free, freeSize * sizeof(Link));
+failFreeAlloc:
   return res;
 }
 
@@ -623,7 +660,10 @@ static Res MRGInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   mrg = CouldBeA(MRGPool, pool);
  
   RingInit(&mrg->entryRing);
-  RingInit(&mrg->freeRing);
+  mrg->free = NULL;
+  mrg->freeCount = 0;
+  mrg->freeSize = 0;
+  mrg->guardians = 0;
   RingInit(&mrg->refRing);
   mrg->extendBy = ArenaGrainSize(PoolArena(pool));
 
@@ -664,8 +704,12 @@ static void MRGFinish(Inst inst)
   if (!RingIsSingle(&mrg->entryRing)) {
     RingRemove(&mrg->entryRing);
   }
-  if (!RingIsSingle(&mrg->freeRing)) {
-    RingRemove(&mrg->freeRing);
+  if (mrg->free != NULL) {
+    ControlFree(PoolArena(pool), mrg->free, mrg->freeSize * sizeof(Link));
+    mrg->free = NULL;
+    mrg->freeCount = 0;
+    mrg->freeSize = 0;
+    mrg->guardians = 0;
   }
 
   RING_FOR(node, &mrg->refRing, nextNode) {
@@ -681,39 +725,94 @@ static void MRGFinish(Inst inst)
 }
 
 
-/* MRGRegister -- register an object for finalization */
+/* MRGGuardianAlloc -- allocate a free guardian for a reference */
 
-Res MRGRegister(Pool pool, Ref ref)
+static void MRGGuardianAlloc(MRG mrg, Ref ref)
 {
-  MRG mrg = MustBeA(MRGPool, pool);
-  Arena arena = PoolArena(pool);
-  Ring freeNode;
+  Arena arena = PoolArena(MustBeA(AbstractPool, mrg));
   Link link;
   RefPart refPart;
-  Res res;
-  MRGRefSeg junk; /* unused */
 
   AVER(ref != 0);
+  AVER(mrg->freeCount > 0);
 
-  /* <design/poolmrg/#alloc.grow> */
-  if (RingIsSingle(&mrg->freeRing)) {
-    res = MRGSegPairCreate(&junk, mrg);  
-    if (res != ResOK)
-      return res;
-  }
-  AVER(!RingIsSingle(&mrg->freeRing));
-  freeNode = RingNext(&mrg->freeRing);
-
-  link = linkOfRing(freeNode);
-  AVER(link->state == MRGGuardianFREE);
   /* <design/poolmrg/#alloc.pop> */
-  RingRemove(freeNode);
+  --mrg->freeCount;
+  link = mrg->free[mrg->freeCount];
+  AVER(link->state == MRGGuardianFREE);
   link->state = MRGGuardianPREFINAL;
-  RingAppend(&mrg->entryRing, freeNode);
+  RingInit(&link->the.linkRing);
+  RingAppend(&mrg->entryRing, &link->the.linkRing);
 
   /* <design/poolmrg/#guardian.ref.alloc> */
   refPart = MRGRefPartOfLink(link, arena);
   MRGRefPartSetRef(arena, refPart, ref);
+}
+
+
+/* MRGReserve -- ensure that there are enough free guardians
+ *
+ * <design/poolmrg/#alloc.grow>
+ */
+
+static Res MRGReserve(MRG mrg, Count count)
+{
+  Res res;
+  MRGRefSeg junk; /* unused */
+
+  while (mrg->freeCount < count) {
+    res = MRGSegPairCreate(&junk, mrg);
+    if (res != ResOK)
+      return res;
+  }
+  return ResOK;
+}
+
+
+/* MRGRegister -- register an object for finalization */
+
+Res MRGRegister(Pool pool, Ref ref)
+{
+  MRG mrg = MustBeA(MRGPool, pool);
+  Res res;
+
+  AVER(ref != 0);
+
+  res = MRGReserve(mrg, 1);
+  if (res != ResOK)
+    return res;
+  MRGGuardianAlloc(mrg, ref);
+
+  return ResOK;
+}
+
+
+/* MRGRegisterMany -- register many objects for finalization
+ *
+ * The references are read from refs[0] to refs[count-1] (which may be
+ * protected).  Either all of the objects are registered, or none of
+ * them are.  See <design/poolmrg/#alloc.many>.
+ */
+
+Res MRGRegisterMany(Pool pool, Ref *refs, Count count)
+{
+  MRG mrg = MustBeA(MRGPool, pool);
+  Arena arena = PoolArena(pool);
+  Res res;
+  Index i;
+
+  AVER(refs != NULL);
+
+  res = MRGReserve(mrg, count);
+  if (res != ResOK)
+    return res;
+  for (i = 0; i < count; ++i) {
+    Ref ref = ArenaPeek(arena, &refs[i]);
+    Pool refpool;
+    AVER(PoolOfAddr(&refpool, arena, (Addr)ref));
+    AVER(PoolHasAttr(refpool, AttrGC));
+    MRGGuardianAlloc(mrg, ref);
+  }
 
   return ResOK;
 }
@@ -14,6 +14,7 @@ typedef struct MRGStruct *MRG;
 
 extern PoolClass PoolClassMRG(void);
 extern Res MRGRegister(Pool, Ref);
+extern Res MRGRegisterMany(Pool, Ref *, Count);
 extern Res MRGDeregister(Pool, Ref);
 
 #endif /* poolmrg_h */
@@ -42,6 +42,17 @@ extern PoolClass PoolClassMVFF(void);
 
 #define MVFFSig           ((Sig)0x5193FFF9) /* SIGnature MVFF */
 
+/* MVFFCacheStruct -- cache of small free blocks; see .cache */
+
+typedef struct MVFFCacheStruct *MVFFCache;
+typedef struct MVFFCacheStruct {
+  Lock lock;                    /* protects the rest of the cache */
+  Shift alignShift;             /* log2 of the pool alignment */
+  Size size;                    /* total size of cached blocks */
+  Count count[MVFF_CACHE_CLASSES]; /* number of blocks of each size */
+  Addr list[MVFF_CACHE_CLASSES];   /* blocks, linked by first word */
+} MVFFCacheStruct;
+
 typedef struct MVFFStruct *MVFF;
 typedef struct MVFFStruct {     /* MVFF pool outer structure */
   PoolStruct poolStruct;        /* generic structure */
@@ -51,11 +62,12 @@ typedef struct MVFFStruct {     /* MVFF pool outer structure */
   double spare;                 /* spare space fraction, see MVFFReduce */
   MFSStruct cbsBlockPoolStruct; /* stores blocks for CBSs */
   CBSStruct totalCBSStruct;     /* all memory allocated from the arena */
-  CBSStruct freeCBSStruct;      /* free memory (primary) */
+  CBSSegFitStruct freeCBSStruct; /* free memory (primary); see .segfit */
   FreelistStruct flStruct;      /* free memory (secondary, for emergencies) */
   FailoverStruct foStruct;      /* free memory (fail-over mechanism) */
   Bool firstFit;                /* as opposed to last fit */
   Bool slotHigh;                /* prefers high part of large block */
+  MVFFCache cache;              /* small free blocks, or NULL; .cache */
   Sig sig;                      /* <design/sig/> */
 } MVFFStruct;
 
@@ -69,13 +81,15 @@ DECLARE_CLASS(Pool, MVFFDebugPool, MVFFPool);
 #define PoolMVFF(pool)     PARENT(MVFFStruct, poolStruct, pool)
 #define MVFFPool(mvff)     (&(mvff)->poolStruct)
 #define MVFFTotalLand(mvff)  (&(mvff)->totalCBSStruct.landStruct)
-#define MVFFFreePrimary(mvff)   (&(mvff)->freeCBSStruct.landStruct)
+#define MVFFFreePrimary(mvff) \
+  (&(mvff)->freeCBSStruct.cbsStruct.landStruct)
 #define MVFFFreeSecondary(mvff)  FreelistLand(&(mvff)->flStruct)
 #define MVFFFreeLand(mvff)  FailoverLand(&(mvff)->foStruct)
 #define MVFFLocusPref(mvff) (&(mvff)->locusPrefStruct)
 #define MVFFBlockPool(mvff) MFSPool(&(mvff)->cbsBlockPoolStruct)
 
 static Bool MVFFCheck(MVFF mvff);
+static void mvffCacheFlushAll(MVFF mvff);
 
 
 /* MVFFDebug -- MVFFDebug class */
@@ -120,6 +134,22 @@ static void MVFFReduce(MVFF mvff)
 
   freeLimit = (Size)(LandSize(MVFFTotalLand(mvff)) * mvff->spare);
   freeSize = LandSize(MVFFFreeLand(mvff));
+
+  /* .cache.reduce: Cached blocks are free too, so count them, and
+     flush them all to the free land before returning memory, so that
+     they can be returned with it.  Otherwise they would stay in the
+     cache until their list overflows.  See .cache. */
+  if (mvff->cache != NULL) {
+    Size cacheSize;
+    LockClaim(mvff->cache->lock);
+    cacheSize = mvff->cache->size;
+    LockRelease(mvff->cache->lock);
+    if (freeSize + cacheSize < freeLimit)
+      return;
+    mvffCacheFlushAll(mvff);
+    freeSize = LandSize(MVFFFreeLand(mvff));
+  }
+
   if (freeSize < freeLimit)
     return;
 
@@ -297,6 +327,212 @@ static Res mvffFindFree(Range rangeReturn, MVFF mvff, Size size,
 }
 
 
+/* .cache: If the pool was created with MPS_KEY_MVFF_POOL_LOCK, it
+ * keeps a list of free blocks of each small size, protected by a lock
+ * of its own, so that MVFFTryAlloc and MVFFTryFree can serve most
+ * requests without the arena lock.  Only a miss (the list for the size
+ * is empty, or full) goes to the free land, under the arena lock.
+ * Cached blocks count as free, but they aren't in the free land, so
+ * they don't coalesce until they are flushed.  MVFFReduce flushes
+ * them all before returning memory to the arena; see .cache.reduce.  The cache lock is claimed after the arena lock when both
+ * are needed, never before.  See <design/poolmvff/#impl.cache>.
+ */
+
+#define mvffCacheIndex(cache, size) \
+  (((size) >> (cache)->alignShift) - 1)
+
+
+/* mvffCachePop -- take a block of the given (aligned) size, if any */
+
+static Bool mvffCachePop(Addr *aReturn, MVFFCache cache, Size size)
+{
+  Index i = mvffCacheIndex(cache, size);
+  Addr a;
+
+  if (i >= MVFF_CACHE_CLASSES)
+    return FALSE;
+
+  LockClaim(cache->lock);
+  a = cache->list[i];
+  if (a != NULL) {
+    cache->list[i] = *(Addr *)a;
+    --cache->count[i];
+    cache->size -= size;
+  }
+  LockRelease(cache->lock);
+
+  if (a == NULL)
+    return FALSE;
+  *aReturn = a;
+  return TRUE;
+}
+
+
+/* mvffCachePush -- keep a block of the given (aligned) size, if room */
+
+static Bool mvffCachePush(MVFFCache cache, Addr old, Size size)
+{
+  Index i = mvffCacheIndex(cache, size);
+  Bool pushed = FALSE;
+
+  if (i >= MVFF_CACHE_CLASSES)
+    return FALSE;
+
+  LockClaim(cache->lock);
+  if (cache->count[i] < MVFF_CACHE_DEPTH) {
+    *(Addr *)old = cache->list[i];
+    cache->list[i] = old;
+    ++cache->count[i];
+    cache->size += size;
+    pushed = TRUE;
+  }
+  LockRelease(cache->lock);
+
+  return pushed;
+}
+
+
+/* mvffCacheFill -- allocate a block and cache more of its size
+ *
+ * Allocates a range for half a list of blocks of the given (aligned)
+ * size from the free land, returns the first and caches the rest.
+ * The list may briefly exceed MVFF_CACHE_DEPTH if another thread
+ * frees blocks of this size meanwhile, which does no harm.
+ */
+
+static Res mvffCacheFill(Addr *aReturn, MVFF mvff, Size size,
+                         LandFindMethod findMethod, FindDelete findDelete)
+{
+  MVFFCache cache = mvff->cache;
+  Index i = mvffCacheIndex(cache, size);
+  Count n = MVFF_CACHE_DEPTH / 2;
+  RangeStruct range;
+  Addr base;
+  Res res;
+
+  AVER(i < MVFF_CACHE_CLASSES);
+
+  res = mvffFindFree(&range, mvff, size * n, findMethod, findDelete);
+  if (res != ResOK)
+    return res;
+  AVER(RangeSize(&range) == size * n);
+  base = RangeBase(&range);
+
+  LockClaim(cache->lock);
+  while (--n > 0) {
+    Addr a = AddrAdd(base, size * n);
+    *(Addr *)a = cache->list[i];
+    cache->list[i] = a;
+    ++cache->count[i];
+    cache->size += size;
+  }
+  LockRelease(cache->lock);
+
+  *aReturn = base;
+  return ResOK;
+}
+
+
+/* mvffCacheFlush -- return cached blocks of a size to the land
+ *
+ * Returns all the blocks of the given (aligned) size if all is TRUE,
+ * otherwise half of them.
+ */
+
+static void mvffCacheFlush(MVFF mvff, Size size, Bool all)
+{
+  MVFFCache cache = mvff->cache;
+  Index i = mvffCacheIndex(cache, size);
+  Addr list = NULL;
+  Count n;
+
+  if (i >= MVFF_CACHE_CLASSES)
+    return;
+
+  LockClaim(cache->lock);
+  n = all ? cache->count[i] : cache->count[i] / 2;
+  for (; n > 0; --n) {
+    Addr a = cache->list[i];
+    cache->list[i] = *(Addr *)a;
+    --cache->count[i];
+    cache->size -= size;
+    *(Addr *)a = list;
+    list = a;
+  }
+  LockRelease(cache->lock);
+
+  while (list != NULL) {
+    RangeStruct range, coalescedRange;
+    Res res;
+    RangeInitSize(&range, list, size);
+    list = *(Addr *)list;
+    res = LandInsert(&coalescedRange, MVFFFreeLand(mvff), &range);
+    AVER(res == ResOK);
+  }
+}
+
+
+/* mvffCacheFlushAll -- return all the cached blocks to the land */
+
+static void mvffCacheFlushAll(MVFF mvff)
+{
+  Index i;
+
+  AVER(mvff->cache != NULL);
+  for (i = 0; i < MVFF_CACHE_CLASSES; ++i)
+    mvffCacheFlush(mvff, (Size)(i + 1) << mvff->cache->alignShift, TRUE);
+}
+
+
+/* mvffCacheCreate, mvffCacheDestroy -- create and destroy the cache */
+
+static Res mvffCacheCreate(MVFF mvff, Arena arena, Align align)
+{
+  MVFFCache cache;
+  Index i;
+  void *p;
+  Res res;
+
+  AVER(mvff->cache == NULL);
+
+  res = ControlAlloc(&p, arena, sizeof(MVFFCacheStruct));
+  if (res != ResOK)
+    goto failCacheAlloc;
+  cache = p;
+  res = ControlAlloc(&p, arena, LockSize());
+  if (res != ResOK)
+    goto failLockAlloc;
+  cache->lock = p;
+  LockInit(cache->lock);
+
+  cache->alignShift = SizeLog2(align);
+  cache->size = 0;
+  for (i = 0; i < MVFF_CACHE_CLASSES; ++i) {
+    cache->count[i] = 0;
+    cache->list[i] = NULL;
+  }
+  mvff->cache = cache;
+  return ResOK;
+
+failLockAlloc:
+  ControlFree(arena, cache, sizeof(MVFFCacheStruct));
+failCacheAlloc:
+  return res;
+}
+
+static void mvffCacheDestroy(MVFF mvff)
+{
+  Arena arena = PoolArena(MVFFPool(mvff));
+  MVFFCache cache = mvff->cache;
+
+  AVER(cache != NULL);
+  mvff->cache = NULL;
+  LockFinish(cache->lock);
+  ControlFree(arena, cache->lock, LockSize());
+  ControlFree(arena, cache, sizeof(MVFFCacheStruct));
+}
+
+
 /* MVFFAlloc -- Allocate a block
  *
  * .alloc.critical: In manual-allocation-bound programs this is on the
@@ -321,6 +557,15 @@ static Res MVFFAlloc(Addr *aReturn, Pool pool, Size size)
   findMethod = mvff->firstFit ? LandFindFirst : LandFindLast;
   findDelete = mvff->slotHigh ? FindDeleteHIGH : FindDeleteLOW;
 
+  if (mvff->cache != NULL) {
+    /* See .cache. */
+    if (mvffCachePop(aReturn, mvff->cache, size))
+      return ResOK;
+    if (mvffCacheIndex(mvff->cache, size) < MVFF_CACHE_CLASSES
+        && mvffCacheFill(aReturn, mvff, size, findMethod, findDelete) == ResOK)
+      return ResOK;
+  }
+
   res = mvffFindFree(&range, mvff, size, findMethod, findDelete);
   if (res != ResOK)
     return res;
@@ -331,6 +576,26 @@ static Res MVFFAlloc(Addr *aReturn, Pool pool, Size size)
 }
 
 
+/* MVFFTryAlloc -- allocate a block from the cache without the arena lock
+ *
+ * See .cache and <code/pool.c#try.unlocked>.
+ */
+
+static Bool MVFFTryAlloc(Addr *aReturn, Pool pool, Size size)
+{
+  MVFF mvff = PoolMVFF(pool);
+
+  AVER_CRITICAL(aReturn != NULL);
+  AVER_CRITICAL(TESTT(MVFF, mvff));
+  AVER_CRITICAL(size > 0);
+
+  if (mvff->cache == NULL)
+    return FALSE;
+  return mvffCachePop(aReturn, mvff->cache,
+                      SizeAlignUp(size, PoolAlignment(pool)));
+}
+
+
 /* MVFFFree -- free the given block
  *
  * .free.critical: In manual-allocation-bound programs this is on the
@@ -351,7 +616,15 @@ static void MVFFFree(Pool pool, Addr old, Size size)
   AVER_CRITICAL(AddrIsAligned(old, PoolAlignment(pool)));
   AVER_CRITICAL(size > 0);
 
-  RangeInitSize(&range, old, SizeAlignUp(size, PoolAlignment(pool)));
+  size = SizeAlignUp(size, PoolAlignment(pool));
+  if (mvff->cache != NULL) {
+    /* See .cache. */
+    if (mvffCachePush(mvff->cache, old, size))
+      return;
+    mvffCacheFlush(mvff, size, FALSE);
+  }
+
+  RangeInitSize(&range, old, size);
   res = LandInsert(&coalescedRange, MVFFFreeLand(mvff), &range);
   /* Insertion must succeed because it fails over to a Freelist. */
   AVER_CRITICAL(res == ResOK);
@@ -359,6 +632,26 @@ static void MVFFFree(Pool pool, Addr old, Size size)
 }
 
 
+/* MVFFTryFree -- free a block to the cache without the arena lock
+ *
+ * See .cache and <code/pool.c#try.unlocked>.
+ */
+
+static Bool MVFFTryFree(Pool pool, Addr old, Size size)
+{
+  MVFF mvff = PoolMVFF(pool);
+
+  AVER_CRITICAL(TESTT(MVFF, mvff));
+  AVER_CRITICAL(old != (Addr)0);
+  AVER_CRITICAL(size > 0);
+
+  if (mvff->cache == NULL)
+    return FALSE;
+  return mvffCachePush(mvff->cache, old,
+                       SizeAlignUp(size, PoolAlignment(pool)));
+}
+
+
 /* MVFFBufferFill -- Fill the buffer
  *
  * Fill it with the largest block we can find. This is worst-fit
@@ -449,6 +742,8 @@ static void MVFFDebugVarargs(ArgStruct args[MPS_ARGS_MAX], va_list varargs)
 ARG_DEFINE_KEY(MVFF_SLOT_HIGH, Bool);
 ARG_DEFINE_KEY(MVFF_ARENA_HIGH, Bool);
 ARG_DEFINE_KEY(MVFF_FIRST_FIT, Bool);
+ARG_DEFINE_KEY(MVFF_SEGREGATED_FIT, Bool);
+ARG_DEFINE_KEY(MVFF_POOL_LOCK, Bool);
 
 static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 {
@@ -458,6 +753,8 @@ static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   Bool slotHigh = MVFF_SLOT_HIGH_DEFAULT;
   Bool arenaHigh = MVFF_ARENA_HIGH_DEFAULT;
   Bool firstFit = MVFF_FIRST_FIT_DEFAULT;
+  Bool segFit = MVFF_SEGREGATED_FIT_DEFAULT;
+  Bool poolLock = MVFF_POOL_LOCK_DEFAULT;
   double spare = MVFF_SPARE_DEFAULT;
   MVFF mvff;
   Res res;
@@ -466,7 +763,6 @@ static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   AVER(pool != NULL);
   AVERT(Arena, arena);
   AVERT(ArgList, args);
-  UNUSED(klass); /* used for debug pools only */
 
   /* .arg: class-specific additional arguments; see */
   /* <design/poolmvff/#method.init> */
@@ -494,6 +790,12 @@ static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   if (ArgPick(&arg, args, MPS_KEY_MVFF_FIRST_FIT))
     firstFit = arg.val.b;
 
+  if (ArgPick(&arg, args, MPS_KEY_MVFF_SEGREGATED_FIT))
+    segFit = arg.val.b;
+
+  if (ArgPick(&arg, args, MPS_KEY_MVFF_POOL_LOCK))
+    poolLock = arg.val.b;
+
   AVER(extendBy > 0);           /* .arg.check */
   AVER(avgSize > 0);            /* .arg.check */
   AVER(avgSize <= extendBy);    /* .arg.check */
@@ -508,6 +810,8 @@ static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   AVERT(Bool, slotHigh);
   AVERT(Bool, arenaHigh);
   AVERT(Bool, firstFit);
+  AVERT(Bool, segFit);
+  AVERT(Bool, poolLock);
 
   res = PoolAbsInit(pool, arena, klass, args);
   if (res != ResOK)
@@ -522,6 +826,7 @@ static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   mvff->slotHigh = slotHigh;
   mvff->firstFit = firstFit;
   mvff->spare = spare;
+  mvff->cache = NULL;
 
   LocusPrefInit(MVFFLocusPref(mvff));
   LocusPrefExpress(MVFFLocusPref(mvff),
@@ -546,11 +851,21 @@ static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   if (res != ResOK)
     goto failTotalLandInit;
 
-  MPS_ARGS_BEGIN(liArgs) {
-    MPS_ARGS_ADD(liArgs, CBSBlockPool, MVFFBlockPool(mvff));
-    res = LandInit(MVFFFreePrimary(mvff), CLASS(CBSFast), arena, align,
-                   mvff, liArgs);
-  } MPS_ARGS_END(liArgs);
+  /* .segfit: A segregated-fit CBS finds free blocks without searching
+   * its splay tree, at the cost of address-ordered fit (so firstFit
+   * is ignored).  See <design/cbs/#impl.seg-fit>.  Its blocks are
+   * larger, so it has its own block pool, which means this option is
+   * not for the control pool. */
+  if (segFit) {
+    res = LandInit(MVFFFreePrimary(mvff), CLASS(CBSSegFit), arena, align,
+                   mvff, mps_args_none);
+  } else {
+    MPS_ARGS_BEGIN(liArgs) {
+      MPS_ARGS_ADD(liArgs, CBSBlockPool, MVFFBlockPool(mvff));
+      res = LandInit(MVFFFreePrimary(mvff), CLASS(CBSFast), arena, align,
+                     mvff, liArgs);
+    } MPS_ARGS_END(liArgs);
+  }
   if (res != ResOK)
     goto failFreePrimaryInit;
 
@@ -568,6 +883,15 @@ static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
   if (res != ResOK)
     goto failFreeLandInit;
 
+  /* .cache.debug: A debug pool ignores poolLock, because the cache's
+   * list links would overwrite the free template of cached blocks.
+   * DebugPoolInit passes the debug class in klass. */
+  if (poolLock && klass->debugMixin == PoolNoDebugMixin) {
+    res = mvffCacheCreate(mvff, arena, align);
+    if (res != ResOK)
+      goto failCacheCreate;
+  }
+
   SetClassOfPoly(pool, CLASS(MVFFPool));
   mvff->sig = MVFFSig;
   AVERC(MVFFPool, mvff);
@@ -577,6 +901,8 @@ static Res MVFFInit(Pool pool, Arena arena, PoolClass klass, ArgList args)
 
   return ResOK;
 
+failCacheCreate:
+  LandFinish(MVFFFreeLand(mvff));
 failFreeLandInit:
   LandFinish(MVFFFreeSecondary(mvff));
 failFreeSecondaryInit:
@@ -625,6 +951,10 @@ static void MVFFFinish(Inst inst)
   AVER(b);
   AVER(LandSize(MVFFTotalLand(mvff)) == 0);
 
+  /* Cached blocks went back to the arena with the rest of the pool. */
+  if (mvff->cache != NULL)
+    mvffCacheDestroy(mvff);
+
   LandFinish(MVFFFreeLand(mvff));
   LandFinish(MVFFFreeSecondary(mvff));
   LandFinish(MVFFFreePrimary(mvff));
@@ -672,6 +1002,14 @@ static Size MVFFFreeSize(Pool pool)
   mvff = PoolMVFF(pool);
   AVERT(MVFF, mvff);
 
+  if (mvff->cache != NULL) {
+    Size size;
+    LockClaim(mvff->cache->lock);
+    size = LandSize(MVFFFreeLand(mvff)) + mvff->cache->size;
+    LockRelease(mvff->cache->lock);
+    return size;
+  }
+
   return LandSize(MVFFFreeLand(mvff));
 }
 
@@ -703,6 +1041,14 @@ static Res MVFFDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
   if (res != ResOK)
     return res;
 
+  if (mvff->cache != NULL) {
+    res = WriteF(stream, depth + 2,
+                 "cache size $W\n", (WriteFW)mvff->cache->size,
+                 NULL);
+    if (res != ResOK)
+      return res;
+  }
+
   res = LocusPrefDescribe(MVFFLocusPref(mvff), stream, depth + 2);
   if (res != ResOK)
     return res;
@@ -737,6 +1083,8 @@ DEFINE_CLASS(Pool, MVFFPool, klass)
   klass->init = MVFFInit;
   klass->alloc = MVFFAlloc;
   klass->free = MVFFFree;
+  klass->tryAlloc = MVFFTryAlloc;
+  klass->tryFree = MVFFTryFree;
   klass->bufferFill = MVFFBufferFill;
   klass->bufferEmpty = MVFFBufferEmpty;
   klass->totalSize = MVFFTotalSize;
@@ -792,7 +1140,7 @@ static Bool MVFFCheck(MVFF mvff)
   CHECKL(mvff->spare <= 1.0);                   /* see .arg.check */
   CHECKD(MFS, &mvff->cbsBlockPoolStruct);
   CHECKD(CBS, &mvff->totalCBSStruct);
-  CHECKD(CBS, &mvff->freeCBSStruct);
+  CHECKD(CBS, &mvff->freeCBSStruct.cbsStruct);
   CHECKD(Freelist, &mvff->flStruct);
   CHECKD(Failover, &mvff->foStruct);
   CHECKL(LandSize(MVFFTotalLand(mvff)) >= LandSize(MVFFFreeLand(mvff)));
@@ -800,6 +1148,8 @@ static Bool MVFFCheck(MVFF mvff)
   CHECKL(SizeIsArenaGrains(LandSize(MVFFTotalLand(mvff)), PoolArena(MVFFPool(mvff))));
   CHECKL(BoolCheck(mvff->slotHigh));
   CHECKL(BoolCheck(mvff->firstFit));
+  /* Don't check the cache contents: they're not protected by the arena
+   * lock.  See .cache. */
   return TRUE;
 }
 
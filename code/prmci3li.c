@@ -75,7 +75,10 @@ MRef Prmci3AddressHoldingReg(MutatorFaultContext mfc, unsigned int regnum)
 }
 
 
-/* Prmci3DecodeFaultContext -- decode fault to find faulting address and IP */
+/* Prmci3DecodeFaultContext -- decode fault to find faulting address and IP
+ *
+ * The IP is NULL if the context has no registers (see prmcix.h).
+ */
 
 void Prmci3DecodeFaultContext(MRef *faultmemReturn,
                               Byte **insvecReturn,
@@ -83,7 +86,10 @@ void Prmci3DecodeFaultContext(MRef *faultmemReturn,
 {
   /* .source.linux.kernel (linux/arch/i386/mm/fault.c). */
   *faultmemReturn = (MRef)mfc->info->si_addr;
-  *insvecReturn = (Byte*)mfc->ucontext->uc_mcontext.gregs[REG_EIP];
+  if (mfc->ucontext == NULL)
+    *insvecReturn = NULL;
+  else
+    *insvecReturn = (Byte*)mfc->ucontext->uc_mcontext.gregs[REG_EIP];
 }
 
 
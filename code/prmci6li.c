@@ -79,7 +79,10 @@ MRef Prmci6AddressHoldingReg(MutatorFaultContext mfc, unsigned int regnum)
 }
 
 
-/* Prmci6DecodeFaultContext -- decode fault to find faulting address and IP */
+/* Prmci6DecodeFaultContext -- decode fault to find faulting address and IP
+ *
+ * The IP is NULL if the context has no registers (see prmcix.h).
+ */
 
 void Prmci6DecodeFaultContext(MRef *faultmemReturn,
                               Byte **insvecReturn,
@@ -87,7 +90,10 @@ void Prmci6DecodeFaultContext(MRef *faultmemReturn,
 {
   /* .source.linux.kernel (linux/arch/x86/mm/fault.c). */
   *faultmemReturn = (MRef)mfc->info->si_addr;
-  *insvecReturn = (Byte*)mfc->ucontext->uc_mcontext.gregs[REG_RIP];
+  if (mfc->ucontext == NULL)
+    *insvecReturn = NULL;
+  else
+    *insvecReturn = (Byte*)mfc->ucontext->uc_mcontext.gregs[REG_RIP];
 }
 
 
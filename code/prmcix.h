@@ -14,9 +14,13 @@
 #include <signal.h> /* siginfo_t -- see .feature.li in config.h */
 #include <ucontext.h> /* ucontext_t */
 
+/* The ucontext is NULL if the fault was reported by the userfaultfd
+   handler thread, which can't see the registers of the faulting
+   thread.  See <code/protuffd.c#context>. */
+
 typedef struct MutatorFaultContextStruct { /* Protection fault context data */
   siginfo_t *info;
-  ucontext_t *ucontext;
+  ucontext_t *ucontext;         /* registers, or NULL */
 } MutatorFaultContextStruct;
 
 
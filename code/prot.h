@@ -15,6 +15,7 @@
 #define prot_h
 
 #include "mpmtypes.h"
+#include "ring.h"
 
 
 /* Protection Interface */
@@ -25,6 +26,25 @@ extern void ProtSet(Addr base, Addr limit, AccessSet mode);
 extern void ProtSync(Arena arena);
 
 
+/* Userfaultfd write protection for Linux, see <code/protuffd.c> */
+
+#if defined(PROT_UFFD)
+
+typedef struct ProtUffdRangeStruct *ProtUffdRange;
+
+typedef struct ProtUffdRangeStruct {
+  RingStruct ring;              /* in list of registered ranges */
+  Addr base, limit;             /* the range */
+  Bool registered;              /* registered with the userfaultfd? */
+} ProtUffdRangeStruct;
+
+extern Bool ProtUffdRegister(ProtUffdRange range, Addr base, Addr limit);
+extern void ProtUffdDeregister(ProtUffdRange range);
+extern Bool ProtUffdSet(Addr base, Addr limit, AccessSet mode);
+
+#endif
+
+
 /* Mutator Fault Context */
 
 extern Bool ProtCanStepInstruction(MutatorFaultContext context);
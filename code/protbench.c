@@ -0,0 +1,239 @@
+/* protbench.c -- write barrier latency benchmark
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * This benchmark measures the time taken by a hit on the write barrier,
+ * that is, from a write by the mutator to a protected segment until
+ * the protection has been removed and the write completes.  It's
+ * intended to compare the implementations of the protection interface
+ * (see <design/prot>), in particular protix.c and protuffd.c (build
+ * with CONFIG_PROT_UFFD).  The tests are:
+ *
+ *   raise  raise and lower the write barrier on a segment
+ *   hit    raise the write barrier and then write to the segment
+ *
+ * The time taken by the fault itself is the difference between the
+ * two.
+ */
+
+#include "mps.c"
+#include "testlib.h"
+#include "fmtvec.h"
+#include "mpscams.h"
+
+#ifdef MPS_OS_W3
+#include "getopt.h"
+#else
+#include <getopt.h>
+#endif
+
+#include <stdio.h> /* fprintf, printf, stderr */
+#include <stdlib.h> /* EXIT_FAILURE, EXIT_SUCCESS, strtoul */
+#include <string.h> /* strcmp */
+#include <time.h> /* clock, CLOCKS_PER_SEC */
+
+static unsigned long niter = 100000; /* number of iterations */
+static size_t nwords = 64;           /* words in the object */
+
+static mps_gen_param_s gen[] = {
+  { 1024, 0.9 }
+};
+
+
+/* barrierRaise -- raise the write barrier on the segment containing p
+ *
+ * An empty summary means that the segment has no references, so a
+ * write to it must hit the barrier (see <design/write-barrier>).  The
+ * protection is applied when the shield is left.
+ */
+
+static void barrierRaise(Arena arena, Addr p)
+{
+  Seg seg;
+
+  ArenaEnter(arena);
+  if (!SegOfAddr(&seg, arena, p))
+    error("no segment at %p", (void *)p);
+  SegSetSummary(seg, RefSetEMPTY);
+  ArenaLeave(arena);
+}
+
+
+/* barrierLower -- lower the write barrier on the segment containing p */
+
+static void barrierLower(Arena arena, Addr p)
+{
+  Seg seg;
+
+  ArenaEnter(arena);
+  if (!SegOfAddr(&seg, arena, p))
+    error("no segment at %p", (void *)p);
+  SegSetSummary(seg, RefSetUNIV);
+  ArenaLeave(arena);
+}
+
+
+/* bench -- run one test */
+
+static void bench(const char *name, Bool hit)
+{
+  mps_arena_t arena;
+  mps_thr_t thread;
+  mps_fmt_t format;
+  mps_chain_t chain;
+  mps_pool_t pool;
+  mps_ap_t ap;
+  mps_word_t *obj;
+  volatile mps_word_t *slot;
+  clock_t begin, end;
+  unsigned long i;
+
+  die(mps_arena_create_k(&arena, mps_arena_class_vm(), mps_args_none),
+      "arena_create");
+  die(mps_thread_reg(&thread, arena), "thread_reg");
+  die(vec_fmt(&format, arena), "vec_fmt");
+  die(mps_chain_create(&chain, arena, NELEMS(gen), gen), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&pool, arena, mps_class_ams(), args),
+        "pool_create(ams)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create_k(&ap, pool, mps_args_none), "ap_create");
+
+  /* Nothing refers to the object, so the arena must not collect. */
+  mps_arena_park(arena);
+  die(make_vec(&obj, ap, nwords, VEC_REFS), "make_vec");
+  mps_ap_destroy(ap); /* so that the segment is not buffered */
+  slot = &obj[1];
+
+  begin = clock();
+  for (i = 0; i < niter; ++i) {
+    barrierRaise((Arena)arena, (Addr)obj);
+    if (hit)
+      *slot = 0;
+    else
+      barrierLower((Arena)arena, (Addr)obj);
+  }
+  end = clock();
+
+  printf("%s: %lu iterations, %g microseconds each\n", name, niter,
+         (double)(end - begin) * 1e6 / CLOCKS_PER_SEC / (double)niter);
+
+  mps_pool_destroy(pool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_thread_dereg(thread);
+  mps_arena_destroy(arena);
+}
+
+
+/* Command-line options definitions.  See getopt_long(3). */
+
+static struct option longopts[] = {
+  {"help",             no_argument,       NULL, 'h'},
+  {"niter",            required_argument, NULL, 'i'},
+  {NULL,               0,                 NULL, 0  }
+};
+
+
+static struct {
+  const char *name;
+  Bool hit;
+} tests[] = {
+  {"raise", FALSE},
+  {"hit",   TRUE},
+};
+
+
+/* Command-line driver */
+
+int main(int argc, char *argv[])
+{
+  int ch;
+  unsigned i;
+
+  while ((ch = getopt_long(argc, argv, "hi:", longopts, NULL)) != -1)
+    switch (ch) {
+    case 'i':
+      niter = strtoul(optarg, NULL, 10);
+      break;
+    default:
+      fprintf(stderr,
+              "Usage: %s [option...] [test...]\n"
+              "Options:\n"
+              "  -i n, --niter=n\n"
+              "    Number of iterations (default %lu).\n"
+              "Tests:\n"
+              "  raise  raise and lower the write barrier\n"
+              "  hit    raise the write barrier and write to the segment\n",
+              argv[0],
+              niter);
+      return EXIT_FAILURE;
+    }
+  argc -= optind;
+  argv += optind;
+
+  if (niter == 0) {
+    fprintf(stderr, "Bad arguments; try --help\n");
+    return EXIT_FAILURE;
+  }
+
+  while (argc > 0) {
+    for (i = 0; i < NELEMS(tests); ++i)
+      if (strcmp(argv[0], tests[i].name) == 0)
+        goto found;
+    fprintf(stderr, "unknown test \"%s\"\n", argv[0]);
+    return EXIT_FAILURE;
+  found:
+    (void)mps_lib_assert_fail_install(assert_die);
+    bench(tests[i].name, tests[i].hit);
+    --argc;
+    ++argv;
+  }
+
+  return EXIT_SUCCESS;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
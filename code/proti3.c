@@ -186,6 +186,8 @@ static Bool IsSimpleMov(Size *inslenReturn,
   MRef faultmem;
 
   Prmci3DecodeFaultContext(&faultmem, &insvec, context);
+  if (insvec == NULL)
+    return FALSE; /* no registers, so .assume.null */
 
   /* .assume.want */
   /* .source.i486 Page 26-210 */
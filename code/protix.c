@@ -68,6 +68,11 @@ void ProtSet(Addr base, Addr limit, AccessSet mode)
   AVER(AddrOffset(base, limit) <= INT_MAX);     /* should be redundant */
   AVERT(AccessSet, mode);
 
+#if defined(PROT_UFFD)
+  if (ProtUffdSet(base, limit, mode))
+    return;
+#endif
+
   /* Convert between MPS AccessSet and UNIX PROT thingies.
      In this function, AccessREAD means protect against read accesses
      (disallow them).  PROT_READ means allow read accesses.  Notice that
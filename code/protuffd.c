@@ -0,0 +1,484 @@
+/* protuffd.c: WRITE PROTECTION USING USERFAULTFD FOR LINUX
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * This module is only used if the MPS is built with CONFIG_PROT_UFFD
+ * (see <code/config.h>).  It implements write-only protection (the
+ * write barrier) using the write-protect mode of userfaultfd(2)
+ * instead of mprotect(2).  A thread that writes to a write-protected
+ * page is blocked by the kernel, and a message is sent to a handler
+ * thread created by this module, which calls ArenaAccess to remove
+ * the cause of the fault, then wakes the faulting thread.  So write
+ * barrier hits don't involve signal delivery, and don't interact with
+ * other users of SIGSEGV in the process.  Compare <code/protxc.c>.
+ *
+ * Read protection (the read barrier) can't be implemented this way,
+ * so it still uses mprotect(2) and the signal handler in
+ * <code/protli.c>.
+ *
+ * .register: userfaultfd(2) can only write-protect memory that has
+ * been registered with the userfaultfd.  Each chunk of a VM arena is
+ * registered when it is created (see VMChunkCreate), and deregistered
+ * when it is destroyed.  Registration belongs to the mapping, so when
+ * the MPS is built with PROT_UFFD, VMMap and VMUnmap change the
+ * protection of the chunk's reservation instead of replacing it with
+ * a new mapping (see <code/vmix.c>).
+ *
+ * .register.track: The registered ranges are kept in a list, and
+ * ProtUffdSet only uses the userfaultfd for the parts of a range
+ * that are in the list.  Other memory (the chunks of client arenas,
+ * protectable roots, and any chunk whose registration failed) is
+ * protected with mprotect(2), exactly as without PROT_UFFD.  So each
+ * page is always protected by the same means, and protection set by
+ * one means is never left behind by a change made by the other.
+ *
+ * .unpopulated: Write protection must also apply to pages that have
+ * never been touched, otherwise the first write to such a page
+ * wouldn't hit the barrier.  That needs the kernel feature
+ * UFFD_FEATURE_WP_UNPOPULATED (Linux 6.4 and later).
+ *
+ * .fallback: If userfaultfd(2) isn't available at run time (the
+ * system call fails, or the kernel doesn't support the features we
+ * need), or the headers the MPS was built with don't define the system
+ * call, nothing is registered, so ProtUffdSet returns FALSE and
+ * ProtSet falls back to mprotect(2) in <code/protix.c>.  If the kernel
+ * refuses to write-protect a registered range, for example for lack of
+ * memory, ProtUffdSet protects it with mprotect(2) instead.
+ *
+ * .user-mode-only: UFFD_USER_MODE_ONLY lets unprivileged processes use
+ * userfaultfd.  Faults in the kernel (for example in read(2) into
+ * protected memory) then fail with EFAULT, as they would with
+ * mprotect(2).  Kernels before Linux 5.11 reject the flag with EINVAL,
+ * so the system call is then retried without it, which succeeds if the
+ * process is privileged or vm.unprivileged_userfaultfd is set.
+ *
+ * .context: The handler thread can't see the registers of the
+ * faulting thread, so the context it passes to ArenaAccess has the
+ * fault address but no ucontext (see <code/prmcix.h>).  The
+ * instruction can't be emulated without registers, so
+ * ProtCanStepInstruction returns FALSE, and PoolSingleAccess falls
+ * back to handling the fault for the whole segment.
+ *
+ * .wake: After ArenaAccess returns, the handler wakes the faulting
+ * thread explicitly.  Normally ArenaAccess has already woken it by
+ * removing the write protection (see ProtUffdSet), but the fault may
+ * be stale: another thread may already have removed the protection.
+ * The handler must not remove the protection itself, because by then
+ * the MPS may have protected the page again, and must know about any
+ * write to it.
+ *
+ * .cost: A hit needs a switch to the handler thread and back, so on a
+ * single processor it costs more than a hit handled by the signal
+ * handler in <code/protli.c>.  Run protbench.c in both builds to
+ * compare.
+ *
+ *
+ * TRANSGRESSIONS
+ *
+ * .trans.must: As in <code/protxc.c>, OS calls that can only fail
+ * because of static errors are asserted to succeed.  Calls that the
+ * kernel may refuse at run time are not: see .fallback.
+ */
+
+#include "mpm.h"
+#include "prmcix.h"
+#include "vm.h"
+
+SRCID(protuffd, "$Id$");
+
+#if defined(PROT_UFFD)
+
+#if !defined(MPS_OS_LI)
+#error "protuffd.c is Linux-specific, but MPS_OS_LI is not set"
+#endif
+
+#include <errno.h>
+#include <fcntl.h>
+#include <pthread.h>
+#include <unistd.h>
+
+#include <linux/userfaultfd.h>
+#include <sys/ioctl.h>
+#include <sys/mman.h>
+#include <sys/syscall.h>
+
+#ifndef UFFD_USER_MODE_ONLY
+#define UFFD_USER_MODE_ONLY 1 /* Linux 5.11 */
+#endif
+
+#ifndef UFFD_FEATURE_WP_UNPOPULATED
+#define UFFD_FEATURE_WP_UNPOPULATED (1 << 13) /* Linux 6.4 */
+#endif
+
+
+/* The userfaultfd, or -1 if it's not in use (see .fallback). */
+
+static int protUffd = -1;
+
+
+/* The registered ranges (see .register.track), and a lock that
+   protects the list, because chunks of different arenas may be
+   created, destroyed and protected at the same time. */
+
+static RingStruct protUffdRanges;
+static pthread_mutex_t protUffdRangesLock = PTHREAD_MUTEX_INITIALIZER;
+
+
+/* protUffdWriteProtect -- set or remove write protection on a range
+ *
+ * Returns FALSE if the kernel refused.  The range must be registered.
+ * EAGAIN means that the address space was changing, and is worth
+ * retrying.  Setting protection may also fail for lack of memory for
+ * page tables, but removing it needs no memory.
+ */
+
+static Bool protUffdWriteProtect(Addr base, Addr limit, Bool protect)
+{
+  struct uffdio_writeprotect wp;
+  int r;
+
+  wp.range.start = (unsigned long)base;
+  wp.range.len = (unsigned long)AddrOffset(base, limit);
+  wp.mode = protect ? UFFDIO_WRITEPROTECT_MODE_WP : 0;
+  do {
+    r = ioctl(protUffd, UFFDIO_WRITEPROTECT, &wp);
+  } while (r != 0 && errno == EAGAIN);
+  return r == 0;
+}
+
+
+/* protUffdCatchOne -- handle one message from the userfaultfd */
+
+static void protUffdCatchOne(void)
+{
+  struct uffd_msg msg;
+  struct uffdio_range range;
+  MutatorFaultContextStruct context;
+  siginfo_t info;
+  ssize_t n;
+  Addr addr;
+  int r;
+
+  n = read(protUffd, &msg, sizeof msg);
+  if (n < 0) {
+    AVER(errno == EINTR);
+    return;
+  }
+  AVER(n == sizeof msg);
+  if (msg.event != UFFD_EVENT_PAGEFAULT)
+    return;
+  AVER((msg.arg.pagefault.flags & UFFD_PAGEFAULT_FLAG_WP) != 0);
+
+  addr = (Addr)(Word)msg.arg.pagefault.address;
+
+  /* .context: Describe the fault as the signal handler would see it,
+     but without registers. */
+  info.si_signo = SIGSEGV;
+  info.si_errno = 0;
+  info.si_code = SEGV_ACCERR;
+  info.si_addr = (void *)addr;
+  context.info = &info;
+  context.ucontext = NULL;
+  (void)ArenaAccess(addr, AccessWRITE, &context);
+
+  /* .wake: This fails if the chunk has been destroyed in the
+     meantime, but then the faulting thread was writing to memory it
+     no longer owned. */
+  range.start = (unsigned long)AddrAlignDown(addr, PageSize());
+  range.len = (unsigned long)PageSize();
+  r = ioctl(protUffd, UFFDIO_WAKE, &range);
+  UNUSED(r);
+}
+
+
+/* protUffdCatchThread -- handler thread loop */
+
+ATTRIBUTE_NORETURN
+static void *protUffdCatchThread(void *p)
+{
+  UNUSED(p);
+  for (;;)
+    protUffdCatchOne();
+}
+
+
+/* protUffdSetupInner -- open the userfaultfd and start the handler */
+
+static void protUffdSetupInner(void)
+{
+  struct uffdio_api api;
+  pthread_t thread;
+  int fd, r;
+
+#if defined(SYS_userfaultfd)
+  fd = (int)syscall(SYS_userfaultfd, O_CLOEXEC | UFFD_USER_MODE_ONLY);
+  if (fd < 0 && errno == EINVAL) /* .user-mode-only */
+    fd = (int)syscall(SYS_userfaultfd, O_CLOEXEC);
+#else
+  fd = -1;
+#endif
+  if (fd < 0)
+    return; /* .fallback */
+
+  api.api = UFFD_API;
+  api.features = UFFD_FEATURE_PAGEFAULT_FLAG_WP | UFFD_FEATURE_WP_UNPOPULATED;
+  api.ioctls = 0;
+  if (ioctl(fd, UFFDIO_API, &api) != 0) {
+    (void)close(fd);
+    return; /* .fallback, .unpopulated */
+  }
+
+  RingInit(&protUffdRanges);
+  protUffd = fd;
+  r = pthread_create(&thread, NULL, protUffdCatchThread, NULL);
+  if (r != 0) {
+    protUffd = -1;
+    (void)close(fd);
+    return; /* .fallback */
+  }
+}
+
+static void protUffdSetup(void)
+{
+  static pthread_once_t once = PTHREAD_ONCE_INIT;
+  int r;
+
+  /* There's one userfaultfd and one handler thread for all arenas. */
+  r = pthread_once(&once, protUffdSetupInner);
+  AVER(r == 0); /* .trans.must */
+}
+
+
+/* ProtUffdRegister -- register a chunk with the userfaultfd
+ *
+ * Returns TRUE if the range [base, limit) was registered, in which
+ * case it is added to the list of registered ranges (see
+ * .register.track), and the caller must pass the same range structure
+ * to ProtUffdDeregister before unmapping the memory.  Returns FALSE if
+ * the userfaultfd is not in use, or the kernel refused; the memory is
+ * then protected with mprotect(2).
+ */
+
+Bool ProtUffdRegister(ProtUffdRange range, Addr base, Addr limit)
+{
+  struct uffdio_register reg;
+  int r;
+
+  AVER(range != NULL);
+  AVER(base < limit);
+
+  RingInit(&range->ring);
+  range->base = base;
+  range->limit = limit;
+  range->registered = FALSE;
+
+  protUffdSetup();
+  if (protUffd < 0)
+    return FALSE; /* .fallback */
+
+  reg.range.start = (unsigned long)base;
+  reg.range.len = (unsigned long)AddrOffset(base, limit);
+  reg.mode = UFFDIO_REGISTER_MODE_WP;
+  reg.ioctls = 0;
+  r = ioctl(protUffd, UFFDIO_REGISTER, &reg);
+  if (r != 0)
+    return FALSE; /* .fallback */
+
+  range->registered = TRUE;
+  r = pthread_mutex_lock(&protUffdRangesLock);
+  AVER(r == 0); /* .trans.must */
+  RingAppend(&protUffdRanges, &range->ring);
+  r = pthread_mutex_unlock(&protUffdRangesLock);
+  AVER(r == 0); /* .trans.must */
+  return TRUE;
+}
+
+
+/* ProtUffdDeregister -- deregister a chunk
+ *
+ * Does nothing if ProtUffdRegister failed for this range.
+ */
+
+void ProtUffdDeregister(ProtUffdRange range)
+{
+  struct uffdio_range uffdRange;
+  int r;
+
+  AVER(range != NULL);
+
+  if (range->registered) {
+    r = pthread_mutex_lock(&protUffdRangesLock);
+    AVER(r == 0); /* .trans.must */
+    RingRemove(&range->ring);
+    r = pthread_mutex_unlock(&protUffdRangesLock);
+    AVER(r == 0); /* .trans.must */
+
+    uffdRange.start = (unsigned long)range->base;
+    uffdRange.len = (unsigned long)AddrOffset(range->base, range->limit);
+    (void)ioctl(protUffd, UFFDIO_UNREGISTER, &uffdRange);
+    range->registered = FALSE;
+  }
+  RingFinish(&range->ring);
+}
+
+
+/* protUffdNextPart -- find the next part of a range to protect
+ *
+ * Sets *limitReturn to the end of the longest part of [base, limit)
+ * that starts at base and is either all registered or all
+ * unregistered, and returns TRUE if it is registered.  Must be called
+ * with protUffdRangesLock held.
+ */
+
+static Bool protUffdNextPart(Addr *limitReturn, Addr base, Addr limit)
+{
+  Ring node, next;
+
+  RING_FOR(node, &protUffdRanges, next) {
+    ProtUffdRange range = RING_ELT(ProtUffdRange, ring, node);
+    if (range->base <= base && base < range->limit) {
+      *limitReturn = range->limit < limit ? range->limit : limit;
+      return TRUE;
+    }
+    if (base < range->base && range->base < limit)
+      limit = range->base;
+  }
+  *limitReturn = limit;
+  return FALSE;
+}
+
+
+/* protUffdSetPart -- set the protection of part of a range
+ *
+ * Write-only protection of registered memory is set with the
+ * userfaultfd, and read protection with mprotect(2), as in
+ * <code/protix.c>.  Write protection is removed from pages that are
+ * read-protected, so that a write to them is always handled by the
+ * signal handler.  Unregistered memory is protected with mprotect(2)
+ * alone.
+ */
+
+static void protUffdSetPart(Addr base, Addr limit, AccessSet mode,
+                            Bool registered)
+{
+  int flags;
+  Bool protect = FALSE;
+
+  switch(mode) {
+  case AccessWRITE | AccessREAD:
+  case AccessREAD:
+    flags = PROT_NONE;
+    break;
+  case AccessWRITE:
+    flags = PROT_READ | PROT_EXEC;
+    if (registered) {
+      /* Apply write protection before making the pages writable, so
+         that there's never a moment when they can be written without
+         hitting a barrier.  If that fails, protect them with
+         mprotect(2) instead (.fallback). */
+      protect = protUffdWriteProtect(base, limit, TRUE);
+      if (protect)
+        flags = PROT_READ | PROT_WRITE | PROT_EXEC;
+    }
+    break;
+  case AccessSetEMPTY:
+    flags = PROT_READ | PROT_WRITE | PROT_EXEC;
+    break;
+  default:
+    NOTREACHED;
+    return;
+  }
+
+  if (mprotect((void *)base, (size_t)AddrOffset(base, limit), flags) != 0)
+    NOTREACHED;
+
+  /* Remove write protection after making the pages inaccessible, for
+     the same reason.  This can't fail for lack of memory (see
+     protUffdWriteProtect), so failure would be a static error. */
+  if (registered && !protect)
+    if (!protUffdWriteProtect(base, limit, FALSE))
+      NOTREACHED;
+}
+
+
+/* ProtUffdSet -- set protection using the userfaultfd
+ *
+ * Returns FALSE if no part of the range is registered, in which case
+ * the caller must set the protection itself (see .fallback).
+ * Otherwise sets the protection of each part of the range by the
+ * means appropriate to it (see .register.track).
+ */
+
+Bool ProtUffdSet(Addr base, Addr limit, AccessSet mode)
+{
+  Addr partLimit;
+  Bool registered;
+  int r;
+
+  if (protUffd < 0)
+    return FALSE; /* .fallback */
+
+  r = pthread_mutex_lock(&protUffdRangesLock);
+  AVER(r == 0); /* .trans.must */
+  registered = protUffdNextPart(&partLimit, base, limit);
+  if (!registered && partLimit == limit) {
+    r = pthread_mutex_unlock(&protUffdRangesLock);
+    AVER(r == 0); /* .trans.must */
+    return FALSE;
+  }
+  for (;;) {
+    protUffdSetPart(base, partLimit, mode, registered);
+    if (partLimit == limit)
+      break;
+    base = partLimit;
+    registered = protUffdNextPart(&partLimit, base, limit);
+  }
+  r = pthread_mutex_unlock(&protUffdRangesLock);
+  AVER(r == 0); /* .trans.must */
+  return TRUE;
+}
+
+#endif /* PROT_UFFD */
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ * 
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ * 
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ * 
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ * 
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ * 
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
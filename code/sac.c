@@ -7,9 +7,16 @@
 #include "mpm.h"
 #include "sac.h"
 
+#if defined(MPS_OS_W3)
+#include "mpswin.h" /* for InterlockedCompareExchangePointer */
+#endif
+
 SRCID(sac, "$Id$");
 
 
+ARG_DEFINE_KEY(SAC_TABLE_LIMIT, Size);
+
+
 typedef _mps_sac_freelist_block_s *SACFreeListBlock;
 
 
@@ -47,6 +54,9 @@ static Bool SACCheck(SAC sac)
   CHECKL(sac->classesCount > sac->middleIndex);
   CHECKL(BoolCheck(esac->_trapped));
   CHECKL(esac->_middle > 0);
+  CHECKL((esac->_table == NULL) == (esac->_table_limit == 0));
+  CHECKL(esac->_table_shift == SizeLog2(PoolAlignment(sac->pool)));
+  CHECKL(SizeIsAligned(esac->_table_limit, PoolAlignment(sac->pool)));
   /* check classes above middle */
   prevSize = esac->_middle;
   for (j = sac->middleIndex + 1, i = 0; j < sac->classesCount; ++j, i += 2) {
@@ -82,9 +92,12 @@ static Bool SACCheck(SAC sac)
 }
 
 
-/* sacSize -- calculate size of a SAC structure */
+/* sacSize -- calculate size of a SAC structure
+ *
+ * The lookup table, if any, follows the freelists.  See .table.
+ */
 
-static Size sacSize(Index middleIndex, Count classesCount)
+static Size sacSize(Index middleIndex, Count classesCount, Count tableEntries)
 {
   Index indexMax; /* max index for the freelist */
   SACStruct dummy;
@@ -93,14 +106,39 @@ static Size sacSize(Index middleIndex, Count classesCount)
     indexMax = 2 * (classesCount - middleIndex - 1);
   else
     indexMax = 1 + 2 * middleIndex;
-  return PointerOffset(&dummy, &dummy.esac_s._freelists[indexMax+1]);
+  return PointerOffset(&dummy, &dummy.esac_s._freelists[indexMax+1])
+         + tableEntries;
+}
+
+
+/* sacTableEntries -- number of entries in the lookup table */
+
+static Count sacTableEntries(mps_sac_t esac)
+{
+  return esac->_table_limit >> esac->_table_shift;
 }
 
 
-/* SACCreate -- create an SAC object */
+static void sacFind(Index *iReturn, Size *blockSizeReturn,
+                    SAC sac, Size size);
+
+
+/* SACCreate -- create an SAC object
+ *
+ * .table: If MPS_KEY_SAC_TABLE_LIMIT is non-zero, sizes up to that
+ * limit (rounded down to the pool alignment, and no more than the
+ * largest class) are looked up in a table by MPS_SAC_ALLOC_FAST and
+ * MPS_SAC_FREE_FAST, rather than by searching from the middle.  Entry
+ * k of the table is the freelist index for sizes from k*align+1 to
+ * (k+1)*align, so a lookup is a subtraction, a shift and a load.
+ *
+ * .table.index: Table entries are unsigned chars to keep the table
+ * small, so a cache with a table can have at most sacTableClassLIMIT
+ * classes.
+ */
 
 Res SACCreate(SAC *sacReturn, Pool pool, Count classesCount,
-              SACClasses classes)
+              SACClasses classes, ArgList args)
 {
   void *p;
   SAC sac;
@@ -110,6 +148,11 @@ Res SACCreate(SAC *sacReturn, Pool pool, Count classesCount,
   Size prevSize;
   unsigned totalFreq = 0;
   mps_sac_t esac;
+  Size tableLimit = 0;
+  Shift tableShift;
+  Count tableEntries;
+  unsigned char *table;
+  ArgStruct arg;
 
   AVER(sacReturn != NULL);
   AVERT(Pool, pool);
@@ -128,6 +171,18 @@ Res SACCreate(SAC *sacReturn, Pool pool, Count classesCount,
     /* no restrictions on frequency */
   }
 
+  if (ArgPick(&arg, args, MPS_KEY_SAC_TABLE_LIMIT))
+    tableLimit = arg.val.size;
+  tableShift = SizeLog2(PoolAlignment(pool));
+  if (tableLimit > classes[classesCount - 1].mps_block_size)
+    tableLimit = classes[classesCount - 1].mps_block_size;
+  tableLimit = SizeAlignDown(tableLimit, PoolAlignment(pool));
+  tableEntries = tableLimit >> tableShift;
+  if (tableEntries > 0 && classesCount > sacTableClassLIMIT) {
+    res = ResLIMIT;
+    goto failLimit;
+  }
+
   /* Calculate frequency scale */
   for (i = 0; i < classesCount; ++i) {
     unsigned oldFreq = totalFreq;
@@ -149,7 +204,8 @@ Res SACCreate(SAC *sacReturn, Pool pool, Count classesCount,
     middleIndex = i + 1; /* there must exist another class at i+1 */
 
   /* Allocate SAC */
-  res = ControlAlloc(&p, PoolArena(pool), sacSize(middleIndex, classesCount));
+  res = ControlAlloc(&p, PoolArena(pool),
+                     sacSize(middleIndex, classesCount, tableEntries));
   if(res != ResOK)
     goto failSACAlloc;
   sac = p;
@@ -184,12 +240,26 @@ Res SACCreate(SAC *sacReturn, Pool pool, Count classesCount,
   sac->pool = pool;
   sac->classesCount = classesCount;
   sac->middleIndex = middleIndex;
+  sac->remote = NULL;
+
+  /* Fill the lookup table, see .table. */
+  table = PointerAdd(sac, sacSize(middleIndex, classesCount, 0));
+  for (j = 0; j < tableEntries; ++j) {
+    Size blockSize;
+    sacFind(&i, &blockSize, sac, (j + 1) << tableShift);
+    AVER(i <= UCHAR_MAX);
+    table[j] = (unsigned char)i;
+  }
+  esac->_table_limit = tableLimit;
+  esac->_table_shift = tableShift;
+  esac->_table = tableEntries > 0 ? table : NULL;
   sac->sig = SACSig;
   AVERT(SAC, sac);
   *sacReturn = sac;
   return ResOK;
 
 failSACAlloc:
+failLimit:
   return res;
 }
 
@@ -202,13 +272,14 @@ void SACDestroy(SAC sac)
   SACFlush(sac);
   sac->sig = SigInvalid;
   ControlFree(PoolArena(sac->pool), sac,
-              sacSize(sac->middleIndex, sac->classesCount));
+              sacSize(sac->middleIndex, sac->classesCount,
+                      sacTableEntries(ExternalSACOfSAC(sac))));
 }
 
 
 /* sacFind -- find the index corresponding to size
  *
- * This function replicates the loop in MPS_SAC_ALLOC_FAST, only with
+ * This function replicates the search in _MPS_SAC_FIND, only with
  * added checks.
  */
 
@@ -242,6 +313,88 @@ static void sacFind(Index *iReturn, Size *blockSizeReturn,
 }
 
 
+/* SACFreeRemote -- free an object from a thread that doesn't own the cache
+ *
+ * .remote: A cache belongs to a single thread, which allocates and
+ * frees through MPS_SAC_ALLOC_FAST and MPS_SAC_FREE_FAST without a
+ * lock.  Other threads may free blocks to it by pushing them onto
+ * sac->remote, a list linked through the first word of each block
+ * with the size of the block in the second word.  The push is a
+ * compare-and-swap, so it needs neither the arena lock nor the owner.
+ * The owner takes the whole list at once in sacDrainRemote (so there
+ * is no ABA problem) on its next fill or flush, which are under the
+ * arena lock.
+ *
+ * This is called without the arena lock, so it may only look at the
+ * fields of the cache that never change.
+ */
+
+void SACFreeRemote(SAC sac, Addr p, Size size)
+{
+  Index i;
+  Size blockSize;
+  Addr head;
+
+  AVER(TESTT(SAC, sac));
+  AVER(p != NULL);
+  AVER(size > 0);
+
+  sacFind(&i, &blockSize, sac, size);
+  if (blockSize == SizeMAX)
+    blockSize = size;
+  AVER(blockSize >= 2 * sizeof(Addr));
+  UNUSED(blockSize);
+
+  /* @@@@ ignoring shields for now */
+  ADDR_PTR(Size, p)[1] = size;
+  do {
+    head = sac->remote;
+    *ADDR_PTR(Addr, p) = head;
+  } while (!ATOMIC_CAS_PTR(&sac->remote, head, p));
+}
+
+
+/* sacDrainRemote -- move blocks freed by other threads into the cache
+ *
+ * See .remote.  Blocks that don't fit in their class are freed to the
+ * pool.
+ */
+
+static void sacDrainRemote(SAC sac)
+{
+  Addr fl, cb;
+  mps_sac_t esac;
+
+  do {
+    fl = sac->remote;
+    if (fl == NULL)
+      return;
+  } while (!ATOMIC_CAS_PTR(&sac->remote, fl, NULL));
+
+  esac = ExternalSACOfSAC(sac);
+  while (fl != NULL) {
+    Index i;
+    Size blockSize, size;
+
+    /* @@@@ ignoring shields for now */
+    cb = fl; fl = *ADDR_PTR(Addr, cb);
+    size = ADDR_PTR(Size, cb)[1];
+    AVER(PoolHasAddr(sac->pool, cb));
+    sacFind(&i, &blockSize, sac, size);
+    if (esac->_freelists[i]._count < esac->_freelists[i]._count_max) {
+      *ADDR_PTR(Addr, cb) = esac->_freelists[i]._blocks;
+      esac->_freelists[i]._blocks = cb;
+      ++esac->_freelists[i]._count;
+    } else {
+      /* Adjust size for the overlarge class, see .align. */
+      if (blockSize == SizeMAX)
+        blockSize = SizeAlignUp(size, PoolAlignment(sac->pool));
+      PoolFree(sac->pool, cb, blockSize);
+    }
+  }
+}
+
+
 /* SACFill -- alloc an object, and perhaps fill the cache */
 
 Res SACFill(Addr *p_o, SAC sac, Size size)
@@ -262,6 +415,17 @@ Res SACFill(Addr *p_o, SAC sac, Size size)
   /* Check it's empty (in the future, there will be other cases). */
   AVER(esac->_freelists[i]._count == 0);
 
+  /* Blocks freed by other threads may refill this class. */
+  sacDrainRemote(sac);
+  if (esac->_freelists[i]._count > 0) {
+    fl = esac->_freelists[i]._blocks;
+    --esac->_freelists[i]._count;
+    *p_o = fl;
+    /* @@@@ ignoring shields for now */
+    esac->_freelists[i]._blocks = *ADDR_PTR(Addr, fl);
+    return ResOK;
+  }
+
   /* Fill 1/3 of the cache for this class. */
   blockCount = esac->_freelists[i]._count_max / 3;
   /* Adjust size for the overlarge class. */
@@ -368,6 +532,7 @@ void SACFlush(SAC sac)
 
   AVERT(SAC, sac);
 
+  sacDrainRemote(sac);
   esac = ExternalSACOfSAC(sac);
   for (j = sac->middleIndex + 1, i = 0;
        j < sac->classesCount; ++j, i += 2) {
@@ -12,6 +12,7 @@
 
 
 #define sacClassLIMIT ((Count)8)
+#define sacTableClassLIMIT ((Count)127) /* see <code/sac.c#table.index> */
 
 
 /* SAC -- the real segregated allocation caches */
@@ -25,6 +26,7 @@ typedef struct SACStruct {
   Pool pool;
   Count classesCount;  /* number of classes */
   Index middleIndex;   /* index of the middle */
+  Addr volatile remote; /* blocks freed by other threads, <code/sac.c#remote> */
   _mps_sac_s esac_s;   /* variable length, must be last */
 } SACStruct;
 
@@ -42,11 +44,12 @@ typedef struct mps_sac_classes_s *SACClasses;
 
 
 extern Res SACCreate(SAC *sac_o, Pool pool, Count classesCount,
-                     SACClasses classes);
+                     SACClasses classes, ArgList args);
 extern void SACDestroy(SAC sac);
 extern Res SACFill(Addr *p_o, SAC sac, Size size);
 extern void SACEmpty(SAC sac, Addr p, Size size);
 extern void SACFlush(SAC sac);
+extern void SACFreeRemote(SAC sac, Addr p, Size size);
 
 
 #endif /* sac_h */
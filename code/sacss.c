@@ -69,8 +69,15 @@ static mps_res_t stress(mps_arena_t arena, mps_align_t align,
   if (res != MPS_RES_OK)
     return res;
 
-  die(mps_sac_create(&sac, pool, classes_count, classes),
-      "SACCreate");
+  MPS_ARGS_BEGIN(sac_args) {
+    /* Sometimes look up some or all of the sizes in a table. */
+    if (rnd() % 2 == 0) {
+      size_t limit = classes[classes_count - 1].mps_block_size;
+      MPS_ARGS_ADD(sac_args, MPS_KEY_SAC_TABLE_LIMIT, rnd() % (2 * limit));
+    }
+    die(mps_sac_create_k(&sac, pool, classes_count, classes, sac_args),
+        "SACCreate");
+  } MPS_ARGS_END(sac_args);
 
   /* allocate a load of objects */
   for (i = 0; i < testSetSIZE; ++i) {
@@ -102,15 +109,23 @@ static mps_res_t stress(mps_arena_t arena, mps_align_t align,
     /* free half of the objects */
     /* upper half, as when allocating them again we want smaller objects */
     /* see randomSize() */
-    switch (k % 2) {
+    switch (k % 3) {
     case 0:
       for (i=testSetSIZE/2; i<testSetSIZE; ++i)
         MPS_SAC_FREE(sac, (mps_addr_t)ps[i], ss[i]);
       break;
-    default:
+    case 1:
       for (i=testSetSIZE/2; i<testSetSIZE; ++i)
         mps_sac_free(sac, (mps_addr_t)ps[i], ss[i]);
       break;
+    default:
+      /* A remote free needs room for a link and a size. */
+      for (i=testSetSIZE/2; i<testSetSIZE; ++i)
+        if (ss[i] >= 2 * sizeof(void *))
+          mps_sac_free_remote(sac, (mps_addr_t)ps[i], ss[i]);
+        else
+          mps_sac_free(sac, (mps_addr_t)ps[i], ss[i]);
+      break;
     }
     /* allocate some new objects */
     for (i=testSetSIZE/2; i<testSetSIZE; ++i) {
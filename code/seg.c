@@ -310,6 +310,21 @@ void SegSetSummary(Seg seg, RefSet summary)
 }
 
 
+/* SegSetRemembered -- change the remembered set of a segment
+ *
+ * The caller must have set the summary first, because setting the
+ * summary to RefSetUNIV makes the remembered set universal.  See
+ * <design/write-barrier/#gen.seg>.
+ */
+
+void SegSetRemembered(Seg seg, GenSet remembered)
+{
+  GCSeg gcseg = MustBeA(GCSeg, seg);
+  AVER(gcseg->summary != RefSetUNIV || remembered == GenSetUNIV);
+  gcseg->remembered = remembered;
+}
+
+
 /* SegSetRankAndSummary -- set both the rank set and the summary */
 
 void SegSetRankAndSummary(Seg seg, RankSet rankSet, RefSet summary)
@@ -1059,7 +1074,11 @@ Bool GCSegCheck(GCSeg gcseg)
     CHECKL(gcseg->summary == RefSetEMPTY);
   }
 
+  /* <design/write-barrier/#gen.seg> */
+  CHECKL(gcseg->summary != RefSetUNIV || gcseg->remembered == GenSetUNIV);
+
   CHECKD_NOSIG(Ring, &gcseg->genRing);
+  CHECKL(gcseg->genSet == GenSetEMPTY || BS_IS_SINGLE(gcseg->genSet));
 
   return TRUE;
 }
@@ -1079,9 +1098,11 @@ static Res gcSegInit(Seg seg, Pool pool, Addr base, Size size, ArgList args)
   gcseg = CouldBeA(GCSeg, seg);
 
   gcseg->summary = RefSetEMPTY;
+  gcseg->remembered = GenSetEMPTY;
   gcseg->buffer = NULL;
   RingInit(&gcseg->greyRing);
   RingInit(&gcseg->genRing);
+  gcseg->genSet = GenSetEMPTY;
 
   SetClassOfPoly(seg, CLASS(GCSeg));
   gcseg->sig = GCSegSig;
@@ -1103,6 +1124,7 @@ static void gcSegFinish(Inst inst)
     seg->grey = TraceSetEMPTY;
   }
   gcseg->summary = RefSetEMPTY;
+  gcseg->remembered = GenSetEMPTY;
 
   gcseg->sig = SigInvalid;
 
@@ -1285,6 +1307,11 @@ static void gcSegSetRankSet(Seg seg, RankSet rankSet)
   oldRankSet = seg->rankSet;
   seg->rankSet = BS_BITFIELD(Rank, rankSet);
 
+  if (arena->softBarrier) {
+    /* The client maintains the summary; see <design/write-barrier/#soft>. */
+    return;
+  }
+
   if (oldRankSet == RankSetEMPTY) {
     if (rankSet != RankSetEMPTY) {
       AVER(gcseg->summary == RefSetEMPTY);
@@ -1302,6 +1329,8 @@ static void gcSegSetRankSet(Seg seg, RankSet rankSet)
 static void gcSegSyncWriteBarrier(Seg seg, Arena arena)
 {
   /* Can't check seg -- this function enforces invariants tested by SegCheck. */
+  if (arena->softBarrier)
+    return; /* <design/write-barrier/#soft> */
   if (SegSummary(seg) == RefSetUNIV)
     ShieldLower(arena, seg, AccessWRITE);
   else
@@ -1309,6 +1338,24 @@ static void gcSegSyncWriteBarrier(Seg seg, Arena arena)
 }
 
 
+/* gcSegSummaryRemembered -- update the remembered set for a summary
+ *
+ * A universal summary means that the mutator may have written any
+ * reference into the segment, so the remembered set must be universal
+ * too.  An empty summary means that the segment has no references.
+ * Otherwise the caller is responsible for the remembered set.  See
+ * <design/write-barrier/#gen.seg>.
+ */
+
+static void gcSegSummaryRemembered(GCSeg gcseg, RefSet summary)
+{
+  if (summary == RefSetUNIV)
+    gcseg->remembered = GenSetUNIV;
+  else if (summary == RefSetEMPTY)
+    gcseg->remembered = GenSetEMPTY;
+}
+
+
 /* gcSegSetSummary -- GCSeg method to change the summary on a segment
  *
  * In fact, we only need to raise the write barrier if the
@@ -1330,6 +1377,7 @@ static void gcSegSetSummary(Seg seg, RefSet summary)
 
   arena = PoolArena(SegPool(seg));
   gcseg->summary = summary;
+  gcSegSummaryRemembered(gcseg, summary);
 
   AVER(seg->rankSet != RankSetEMPTY);
 
@@ -1359,6 +1407,7 @@ static void gcSegSetRankSummary(Seg seg, RankSet rankSet, RefSet summary)
 
   seg->rankSet = BS_BITFIELD(Rank, rankSet);
   gcseg->summary = summary;
+  gcSegSummaryRemembered(gcseg, summary);
 
   if (rankSet != RankSetEMPTY)
     gcSegSyncWriteBarrier(seg, arena);
@@ -1423,6 +1472,7 @@ static Res gcSegMerge(Seg seg, Seg segHi,
   GCSeg gcseg, gcsegHi;
   TraceSet grey;
   RefSet summary;
+  GenSet remembered;
   Buffer buf;
   Res res;
 
@@ -1449,8 +1499,14 @@ static Res gcSegMerge(Seg seg, Seg segHi,
      protection modes by unioning the segment summaries.  See also
      design.mps.seg.merge.inv.similar. */
   summary = RefSetUnion(gcseg->summary, gcsegHi->summary);
+  remembered = GenSetUnion(gcseg->remembered, gcsegHi->remembered);
   SegSetSummary(seg, summary);
   SegSetSummary(segHi, summary);
+  if (summary != RefSetUNIV) {
+    gcseg->remembered = remembered;
+    gcsegHi->remembered = remembered;
+  }
+  AVER(gcseg->genSet == gcsegHi->genSet);
   AVER(SegSM(seg) == SegSM(segHi));
   if (SegPM(seg) != SegPM(segHi)) {
     /* This shield won't cope with a partially-protected segment, so
@@ -1467,6 +1523,7 @@ static Res gcSegMerge(Seg seg, Seg segHi,
   /* Update fields of gcseg. Finish gcsegHi. */
   gcSegSetGreyInternal(segHi, grey, TraceSetEMPTY);
   gcsegHi->summary = RefSetEMPTY;
+  gcsegHi->remembered = GenSetEMPTY;
   gcsegHi->sig = SigInvalid;
   RingFinish(&gcsegHi->greyRing);
   RingRemove(&gcsegHi->genRing);
@@ -1528,10 +1585,12 @@ static Res gcSegSplit(Seg seg, Seg segHi,
   /* Full initialization for segHi. */
   gcsegHi = SegGCSeg(segHi);
   gcsegHi->summary = gcseg->summary;
+  gcsegHi->remembered = gcseg->remembered;
   gcsegHi->buffer = NULL;
   RingInit(&gcsegHi->greyRing);
   RingInit(&gcsegHi->genRing);
   RingInsert(&gcseg->genRing, &gcsegHi->genRing);
+  gcsegHi->genSet = gcseg->genSet;
   gcsegHi->sig = GCSegSig;
   gcSegSetGreyInternal(segHi, TraceSetEMPTY, grey);
 
@@ -1571,6 +1630,7 @@ static Res gcSegDescribe(Inst inst, mps_lib_FILE *stream, Count depth)
 
   res = WriteF(stream, depth + 2,
                "summary $W\n", (WriteFW)gcseg->summary,
+               "remembered $W\n", (WriteFW)gcseg->remembered,
                NULL);
   if (res != ResOK)
     return res;
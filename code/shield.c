@@ -377,6 +377,36 @@ static Compare shieldQueueEntryCompare(void *left, void *right, void *closure)
 }
 
 
+/* shieldBridge -- can an outstanding protection range be extended?
+ *
+ * Return TRUE if the memory from limit to base is covered by a few
+ * contiguous segments that are synced with protection mode, so that a
+ * range being protected with mode and ending at limit can be extended
+ * up to base without changing the protection of anything in between.
+ * The walk is limited to ShieldBridgeLIMIT segments, since each step
+ * costs a segment lookup, and a long walk would cost more than the
+ * system call it saves.
+ */
+
+static Bool shieldBridge(Arena arena, Addr limit, Addr base, AccessSet mode)
+{
+  Count count = 0;
+
+  while (limit < base) {
+    Seg seg;
+    if (count >= ShieldBridgeLIMIT
+        || !SegOfAddr(&seg, arena, limit)
+        || SegBase(seg) != limit
+        || !SegIsSynced(seg)
+        || SegPM(seg) != mode)
+      return FALSE;
+    limit = SegLimit(seg);
+    ++count;
+  }
+  return limit == base;
+}
+
+
 /* shieldFlushEntries -- flush queue coalescing protects
  *
  * Sort the shield queue into address order, then iterate over it
@@ -385,16 +415,22 @@ static Compare shieldQueueEntryCompare(void *left, void *right, void *closure)
  * protection calls are extremely inefficient, but has no net gain on
  * Windows.
  *
- * TODO: Could we keep extending the outstanding area over memory
- * that's *not* in the queue but has the same protection mode?  Might
- * require design.mps.shield.improve.noseg.
+ * The outstanding area is also extended over short runs of memory
+ * that are *not* in the queue but have the same protection mode (see
+ * shieldBridge).  Gaps that aren't covered by segments still break
+ * the area: see design.mps.shield.improve.noseg.
+ *
+ * The ShieldFlush event records how many segments were synced and
+ * how many calls to ProtSet that took.
  */
 
-static void shieldFlushEntries(Shield shield)
+static void shieldFlushEntries(Arena arena)
 {
+  Shield shield = ArenaShield(arena);
   Addr base = NULL, limit;
   AccessSet mode;
   Index i;
+  Count segs = 0, calls = 0;
 
   if (shield->length == 0) {
     AVER(shield->queue == NULL);
@@ -411,10 +447,14 @@ static void shieldFlushEntries(Shield shield)
     Seg seg = shieldDequeue(shield, i);
     if (!SegIsSynced(seg)) {
       shieldSetPM(shield, seg, SegSM(seg));
-      if (SegSM(seg) != mode || SegBase(seg) != limit) {
+      ++segs;
+      if (SegSM(seg) != mode
+          || base == NULL
+          || !shieldBridge(arena, limit, SegBase(seg), mode)) {
         if (base != NULL) {
           AVER(base < limit);
           ProtSet(base, limit, mode);
+          ++calls;
         }
         base = SegBase(seg);
         mode = SegSM(seg);
@@ -425,7 +465,10 @@ static void shieldFlushEntries(Shield shield)
   if (base != NULL) {
     AVER(base < limit);
     ProtSet(base, limit, mode);
+    ++calls;
   }
+  if (segs > 0)
+    EVENT3(ShieldFlush, arena, segs, calls);
 
   shieldQueueReset(shield);
 }
@@ -671,7 +714,7 @@ void (ShieldFlush)(Arena arena)
 #ifdef SHIELD_DEBUG
   shieldDebugCheck(arena);
 #endif
-  shieldFlushEntries(shield);
+  shieldFlushEntries(arena);
   AVER(shield->unsynced == 0); /* everything back in sync */
 #ifdef SHIELD_DEBUG
   shieldDebugCheck(arena);
@@ -32,7 +32,6 @@ SRCID(splay, "$Id$");
 
 #define SplayTreeSetRoot(splay, tree) BEGIN ((splay)->root = (tree)); END
 #define SplayCompare(tree, key, node) (((tree)->compare)(node, key))
-#define SplayHasUpdate(splay) ((splay)->updateNode != SplayTrivUpdate)
 
 
 /* SplayTreeCheck -- check consistency of SplayTree
@@ -35,6 +35,7 @@ typedef struct SplayTreeStruct {
 
 #define SplayTreeRoot(splay)    RVALUE((splay)->root)
 #define SplayTreeIsEmpty(splay) (SplayTreeRoot(splay) == TreeEMPTY)
+#define SplayHasUpdate(splay)   ((splay)->updateNode != SplayTrivUpdate)
 
 extern Bool SplayTreeCheck(SplayTree splay);
 extern void SplayTreeInit(SplayTree splay,
@@ -51,6 +51,10 @@ Bool ScanStateCheck(ScanState ss)
   CHECKL(TraceSetSuper(ss->arena->busyTraces, ss->traces));
   CHECKL(RankCheck(ss->rank));
   CHECKL(BoolCheck(ss->wasMarked));
+  CHECKL(BoolCheck(ss->suspended));
+  CHECKL(ss->nesting <= AMC_COPY_DEPTH_MAX);
+  CHECKL(BoolCheck(ss->rememberGens));
+  CHECKL(ss->rememberGens || ss->fixedGens == GenSetUNIV);
   /* @@@@ checks for counts missing */
   return TRUE;
 }
@@ -63,6 +67,7 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
 {
   TraceId ti;
   Trace trace;
+  GenSet whiteGens = GenSetEMPTY;
 
   AVERT(TraceSet, ts);
   AVERT(Arena, arena);
@@ -83,6 +88,7 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
       AVER(ss->fix == trace->fix);
       AVER(ss->fixClosure == trace->fixClosure);
     }
+    whiteGens = GenSetUnion(whiteGens, trace->whiteGens);
   } TRACE_SET_ITER_END(ti, trace, ts, arena);
   AVER(ss->fix != NULL);
 
@@ -96,6 +102,18 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
   ScanStateSetZoneShift(ss, arena->zoneShift);
   ScanStateSetUnfixedSummary(ss, RefSetEMPTY);
   ss->fixedSummary = RefSetEMPTY;
+
+  /* Only note the generations of fixed references if the arena is
+     unzoned and the traces condemn some generations but not others.
+     Otherwise the scan remembers all generations.  See
+     <design/write-barrier/#gen.cost>. */
+#if defined(REMEMBERED_SET_NONE)
+  UNUSED(whiteGens);
+  ss->rememberGens = FALSE;
+#else
+  ss->rememberGens = !arena->zoned && whiteGens != GenSetUNIV;
+#endif
+  ss->fixedGens = ss->rememberGens ? GenSetEMPTY : GenSetUNIV;
   ss->arena = arena;
   ss->wasMarked = TRUE;
   ScanStateSetWhite(ss, white);
@@ -108,6 +126,9 @@ void ScanStateInit(ScanState ss, TraceSet ts, Arena arena,
   STATISTIC(ss->preservedInPlaceCount = (Count)0);
   STATISTIC(ss->copiedSize = (Size)0);
   ss->scannedSize = (Size)0; /* see .work */
+  ss->budget = SizeMAX;
+  ss->suspended = FALSE;
+  ss->nesting = 0;
   ss->sig = ScanStateSig;
 
   AVERT(ScanState, ss);
@@ -333,6 +354,40 @@ static ZoneSet traceSetWhiteUnion(TraceSet ts, Arena arena)
 }
 
 
+/* traceSetWhiteGensUnion
+ *
+ * Returns a GenSet describing the union of the generations of the
+ * white segments of all the specified traces.  */
+
+static GenSet traceSetWhiteGensUnion(TraceSet ts, Arena arena)
+{
+  TraceId ti;
+  Trace trace;
+  GenSet gens = GenSetEMPTY;
+
+  TRACE_SET_ITER(ti, trace, ts, arena)
+    gens = GenSetUnion(gens, trace->whiteGens);
+  TRACE_SET_ITER_END(ti, trace, ts, arena);
+
+  return gens;
+}
+
+
+/* traceSegMayReferToWhite -- might a segment refer to the white set?
+ *
+ * It might only if both its summary intersects the white zones and
+ * its remembered set intersects the white generations.  See
+ * <design/write-barrier/#gen.grey>.
+ */
+
+static Bool traceSegMayReferToWhite(Seg seg, ZoneSet white,
+                                    GenSet whiteGens)
+{
+  return ZoneSetInter(SegSummary(seg), white) != ZoneSetEMPTY
+    && GenSetInter(SegRemembered(seg), whiteGens) != GenSetEMPTY;
+}
+
+
 /* TraceIsEmpty -- return TRUE if trace has no condemned segments
  *
  * .empty.size: If the trace has a condemned size of zero, then it has
@@ -354,6 +409,7 @@ Res TraceAddWhite(Trace trace, Seg seg)
   Res res;
   Pool pool;
   Size condemnedBefore;
+  GenSet gens;
 
   AVERT(Trace, trace);
   AVERT(Seg, seg);
@@ -379,6 +435,13 @@ Res TraceAddWhite(Trace trace, Seg seg)
        pool made it white. */
     trace->white = ZoneSetUnion(trace->white, ZoneSetOfSeg(trace->arena, seg));
 
+    /* A segment that belongs to no generation can't be found through
+       the remembered sets.  See <design/write-barrier/#gen.white>. */
+    gens = SegGenSet(seg);
+    if (gens == GenSetEMPTY)
+      gens = GenSetUNIV;
+    trace->whiteGens = GenSetUnion(trace->whiteGens, gens);
+
     /* if the pool is a moving GC, then condemned objects may move */
     if (PoolHasAttr(pool, AttrMOVINGGC)) {
       trace->mayMove = ZoneSetUnion(trace->mayMove,
@@ -670,6 +733,7 @@ found:
   trace->arena = arena;
   trace->why = why;
   trace->white = ZoneSetEMPTY;
+  trace->whiteGens = GenSetEMPTY;
   trace->mayMove = ZoneSetEMPTY;
   trace->ti = ti;
   trace->state = TraceINIT;
@@ -1061,12 +1125,65 @@ void ScanStateSetSummary(ScanState ss, RefSet summary)
   AVERT(ScanState, ss);
   /* Can't check summary, as it can be anything. */
 
+  /* The unfixed summary is about to be lost, so the generations it
+     might refer to must be remembered now.  The summary passed may
+     include references scanned earlier, so its generations are
+     remembered too.  See <design/write-barrier/#gen.zones>. */
+  if (ss->rememberGens)
+    ss->fixedGens = GenSetUnion(ScanStateRemembered(ss),
+                                GenSetOfZones(ss->arena, summary));
+
   ScanStateSetUnfixedSummary(ss, RefSetEMPTY);
   ss->fixedSummary = summary;
   AVER(ScanStateSummary(ss) == summary);
 }
 
 
+/* ScanStateRemembered -- calculate the remembered set of a scan
+ *
+ * The generations that the scanned references might refer to are the
+ * generations of the segments that TraceFix found for references in
+ * the white set, plus the generations that have segments in the zones
+ * of the other references.  See <design/write-barrier/#gen.scan>.  */
+
+GenSet ScanStateRemembered(ScanState ss)
+{
+  AVERT(ScanState, ss);
+
+  if (!ss->rememberGens)
+    return GenSetUNIV;
+  return GenSetUnion(ss->fixedGens,
+                     GenSetOfZones(ss->arena,
+                                   ZoneSetDiff(ScanStateUnfixedSummary(ss),
+                                               ScanStateWhite(ss))));
+}
+
+
+/* ScanStateAccumulate -- add the counts of a nested scan state
+ *
+ * A pool that scans some objects with a scan state of its own while
+ * fixing a reference (see <design/poolamc/#copy.depth>) adds that
+ * scan state's counts to the scan state of the fix, so that the work
+ * is accounted to the traces.  */
+
+void ScanStateAccumulate(ScanState ss, ScanState nested)
+{
+  AVERT(ScanState, ss);
+  AVERT(ScanState, nested);
+  AVER(nested->traces == ss->traces);
+
+  STATISTIC(ss->fixRefCount += nested->fixRefCount);
+  STATISTIC(ss->segRefCount += nested->segRefCount);
+  STATISTIC(ss->whiteSegRefCount += nested->whiteSegRefCount);
+  STATISTIC(ss->nailCount += nested->nailCount);
+  STATISTIC(ss->snapCount += nested->snapCount);
+  STATISTIC(ss->forwardedCount += nested->forwardedCount);
+  STATISTIC(ss->preservedInPlaceCount += nested->preservedInPlaceCount);
+  STATISTIC(ss->copiedSize += nested->copiedSize);
+  ss->scannedSize += nested->scannedSize;
+}
+
+
 /* ScanStateSummary -- calculate the summary of scanned references
  *
  * The summary of the scanned references is the summary of the unfixed
@@ -1086,16 +1203,22 @@ RefSet ScanStateSummary(ScanState ss)
 
 
 /* traceScanSegRes -- scan a segment to remove greyness
+ *
+ * The pool may suspend the scan once it has scanned budget bytes, in
+ * which case the segment stays grey.  See <design/scan/#suspend>.
  *
  * @@@@ During scanning, the segment should be write-shielded to prevent
  * any other threads from updating it while fix is being applied to it
  * (because fix is not atomic).  At the moment, we don't bother, because
  * we know that all threads are suspended.  */
 
-static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
+static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg,
+                           Size budget)
 {
   Bool wasTotal;
+  Bool suspended = FALSE;
   ZoneSet white;
+  GenSet whiteGens, remembered;
   Res res;
   RefSet summary;
 
@@ -1104,9 +1227,11 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
   EVENT4(TraceScanSeg, ts, rank, arena, seg);
 
   white = traceSetWhiteUnion(ts, arena);
+  whiteGens = traceSetWhiteGensUnion(ts, arena);
 
   /* Only scan a segment if it refers to the white set. */
-  if(ZoneSetInter(white, SegSummary(seg)) == ZoneSetEMPTY) {
+  TraceSoftBarrierFlush(arena);
+  if (!traceSegMayReferToWhite(seg, white, whiteGens)) {
     PoolBlacken(SegPool(seg), ts, seg);
     /* Setup result code to return later. */
     res = ResOK;
@@ -1114,6 +1239,7 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
     ScanStateStruct ssStruct;
     ScanState ss = &ssStruct;
     ScanStateInit(ss, ts, arena, rank, white);
+    ss->budget = budget;
 
     /* Expose the segment to make sure we can scan it. */
     ShieldExpose(arena, seg);
@@ -1121,6 +1247,10 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
     /* Cover, regardless of result */
     ShieldCover(arena, seg);
 
+    /* <design/scan/#suspend.grey> */
+    suspended = ss->suspended;
+    AVER(!suspended || (res == ResOK && !wasTotal && budget < SizeMAX));
+
     traceSetUpdateCounts(ts, arena, ss, traceAccountingPhaseSegScan);
     /* Count segments scanned pointlessly */
     STATISTIC({
@@ -1139,13 +1269,18 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
     /* Following is true whether or not scan was total. */
     /* See <design/scan/#summary.subset>. */
     /* .verify.segsummary: were the seg contents, as found by this 
-     * scan, consistent with the recorded SegSummary?
+     * scan, consistent with the recorded SegSummary?  With a software
+     * barrier, this is what catches a missing call to
+     * mps_write_barrier.  See <design/write-barrier/#soft.check>.
      */
     AVER(RefSetSub(ScanStateUnfixedSummary(ss), SegSummary(seg))); /* <design/check/#.common> */
 
     /* Write barrier deferral -- see design.mps.write-barrier.deferral. */
-    /* Did the segment refer to the white set? */
-    if (ZoneSetInter(ScanStateUnfixedSummary(ss), white) == ZoneSetEMPTY) {
+    /* Did the segment refer to the white set?  See */
+    /* <design/write-barrier/#gen.interesting>. */
+    remembered = ScanStateRemembered(ss);
+    if (ZoneSetInter(ScanStateUnfixedSummary(ss), white) == ZoneSetEMPTY
+        || GenSetInter(remembered, whiteGens) == GenSetEMPTY) {
       /* Boring scan.  One step closer to raising the write barrier. */
       if (seg->defer > 0)
         --seg->defer;
@@ -1155,8 +1290,10 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
         seg->defer = WB_DEFER_DELAY;
     }
 
-    /* Only apply the write barrier if it is not deferred. */
-    if (seg->defer == 0) {
+    /* Only apply the write barrier if it is not deferred.  A software
+       barrier costs nothing to apply, so it is never deferred.  See
+       <design/write-barrier/#soft.deferral>. */
+    if (seg->defer == 0 || arena->softBarrier) {
       /* If we scanned every reference in the segment then we have a
          complete summary we can set. Otherwise, we just have
          information about more zones that the segment refers to. */
@@ -1169,12 +1306,19 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
     }
     SegSetSummary(seg, summary);
 
+    /* <design/write-barrier/#gen.scan> */
+    if (summary != RefSetUNIV) {
+      if (res != ResOK || !wasTotal)
+        remembered = GenSetUnion(SegRemembered(seg), remembered);
+      SegSetRemembered(seg, remembered);
+    }
+
     ScanStateFinish(ss);
   }
 
-  if(res == ResOK) {
-    /* The segment is now black only if scan was successful. */
-    /* Remove the greyness from it. */
+  if(res == ResOK && !suspended) {
+    /* The segment is now black only if scan was successful and */
+    /* complete.  Remove the greyness from it. */
     SegSetGrey(seg, TraceSetDiff(SegGrey(seg), ts));
   }
 
@@ -1185,17 +1329,19 @@ static Res traceScanSegRes(TraceSet ts, Rank rank, Arena arena, Seg seg)
 /* traceScanSeg
  *
  * Scans a segment, switching to emergency mode if there is an allocation
- * failure.
+ * failure.  The budget is as for traceScanSegRes; pass SizeMAX to scan
+ * the whole segment.
  */
 
-static Res traceScanSeg(TraceSet ts, Rank rank, Arena arena, Seg seg)
+static Res traceScanSeg(TraceSet ts, Rank rank, Arena arena, Seg seg,
+                        Size budget)
 {
   Res res;
 
-  res = traceScanSegRes(ts, rank, arena, seg);
+  res = traceScanSegRes(ts, rank, arena, seg, budget);
   if(ResIsAllocFailure(res)) {
     ArenaSetEmergency(arena, TRUE);
-    res = traceScanSegRes(ts, rank, arena, seg);
+    res = traceScanSegRes(ts, rank, arena, seg, budget);
     /* Should be OK in emergency mode. */
     AVER(!ResIsAllocFailure(res));
   }
@@ -1245,7 +1391,8 @@ void TraceSegAccess(Arena arena, Seg seg, AccessSet mode)
     /* Pick set of traces to scan for: */
     traces = arena->flippedTraces;
     rank = TraceRankForAccess(arena, seg);
-    res = traceScanSeg(traces, rank, arena, seg);      
+    /* The mutator needs the whole segment, so don't suspend. */
+    res = traceScanSeg(traces, rank, arena, seg, SizeMAX);
 
     /* Allocation failures should be handled my emergency mode, and we don't
        expect any other kind of failure in a normal GC that causes access
@@ -1278,6 +1425,51 @@ void TraceSegAccess(Arena arena, Seg seg, AccessSet mode)
 }
 
 
+/* traceSegWrite -- handle a software write barrier hit on a segment
+ *
+ * The client has stored a reference in the segment, so its summary is
+ * no longer valid.  This does what TraceSegAccess does for a write
+ * fault.  See <design/write-barrier/#soft>.
+ */
+
+static void traceSegWrite(Arena arena, Seg seg)
+{
+  AVERT(Arena, arena);
+  AVERT(Seg, seg);
+  AVER(arena->softBarrier);
+
+  if (SegRankSet(seg) == RankSetEMPTY || SegSummary(seg) == RefSetUNIV)
+    return;
+
+  EVENT3(TraceAccess, arena, seg, AccessWRITE);
+  STATISTIC(++arena->writeBarrierHitCount);
+  SegSetSummary(seg, RefSetUNIV);
+}
+
+
+/* TraceSoftBarrierFlush -- apply the stores recorded by the barrier
+ *
+ * mps_write_barrier records stores in the arena's buffer without the
+ * arena lock, so this must be called before relying on the summary of
+ * a segment.  In an arena with the hardware barrier, the buffer is
+ * always empty.  See <design/write-barrier/#soft.buffer>.
+ */
+
+void TraceSoftBarrierFlush(Arena arena)
+{
+  Index i;
+
+  AVERT(Arena, arena);
+
+  for (i = 0; i < arena->wbCount; ++i) {
+    Seg seg;
+    if (SegOfAddr(&seg, arena, arena->wbBuffer[i]))
+      traceSegWrite(arena, seg);
+  }
+  arena->wbCount = 0;
+}
+
+
 /* _mps_fix2 (a.k.a. "TraceFix") -- second stage of fixing a reference
  *
  * _mps_fix2 is on the [critical path](../design/critical-path.txt).  A
@@ -1350,6 +1542,9 @@ mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
         EVENT1(TraceFixSeg, seg);
       }
     });
+    /* <design/write-barrier/#gen.fix> */
+    if (ss->rememberGens && TRACT_SEG(&seg, tract))
+      ss->fixedGens = GenSetUnion(ss->fixedGens, SegGenSet(seg));
     goto done;
   }
 
@@ -1379,6 +1574,12 @@ mps_res_t _mps_fix2(mps_ss_t mps_ss, mps_addr_t *mps_ref_io)
     return res;
   }
 
+  /* If the pool updated the reference, it has already added the
+     generation of the new location.  See
+     <design/write-barrier/#gen.fix.move>. */
+  if (ss->rememberGens && ref == (Ref)*mps_ref_io)
+    ss->fixedGens = GenSetUnion(ss->fixedGens, SegGenSet(seg));
+
 done:
   /* See <design/trace/#fix.fixed.all> */
   ss->fixedSummary = RefSetAdd(ss->arena, ss->fixedSummary, ref);
@@ -1401,7 +1602,9 @@ static Res traceScanSingleRefRes(TraceSet ts, Rank rank, Arena arena,
   EVENT4(TraceScanSingleRef, ts, rank, arena, (Addr)refIO);
 
   white = traceSetWhiteUnion(ts, arena);
-  if(ZoneSetInter(SegSummary(seg), white) == ZoneSetEMPTY) {
+  TraceSoftBarrierFlush(arena);
+  if (!traceSegMayReferToWhite(seg, white,
+                               traceSetWhiteGensUnion(ts, arena))) {
     return ResOK;
   }
 
@@ -1416,6 +1619,9 @@ static Res traceScanSingleRefRes(TraceSet ts, Rank rank, Arena arena,
   summary = SegSummary(seg);
   summary = RefSetAdd(arena, summary, *refIO);
   SegSetSummary(seg, summary);
+  if (summary != RefSetUNIV)
+    SegSetRemembered(seg, GenSetUnion(SegRemembered(seg),
+                                      ScanStateRemembered(&ss)));
   ShieldCover(arena, seg);
 
   traceSetUpdateCounts(ts, arena, &ss, traceAccountingPhaseSingleScan);
@@ -1518,6 +1724,10 @@ static Res traceCondemnAll(Trace trace)
 
   TraceCondemnEnd(trace);
 
+  /* Every generation is white, so remembered sets can't keep any
+     segment out of this trace.  See <design/write-barrier/#gen.cost>. */
+  trace->whiteGens = GenSetUNIV;
+
   if (TraceIsEmpty(trace))
     return ResFAIL;
 
@@ -1595,7 +1805,10 @@ Res TraceStart(Trace trace, double mortality, double finishingTime)
 
   arena = trace->arena;
   
-  /* From the already set up white set, derive a grey set. */
+  /* From the already set up white set, derive a grey set.  The
+     summaries must allow for every store the client has made. */
+
+  TraceSoftBarrierFlush(arena);
 
   /* @@@@ Instead of iterating over all the segments, we could */
   /* iterate over all pools which are scannable and thence over */
@@ -1615,8 +1828,9 @@ Res TraceStart(Trace trace, double mortality, double finishingTime)
         /* Turn the segment grey if there might be a reference in it */
         /* to the white set.  This is done by seeing if the summary */
         /* of references in the segment intersects with the */
-        /* approximation to the white set. */
-        if(ZoneSetInter(SegSummary(seg), trace->white) != ZoneSetEMPTY) {
+        /* approximation to the white set, and if its remembered set */
+        /* intersects with the generations of the white set. */
+        if (traceSegMayReferToWhite(seg, trace->white, trace->whiteGens)) {
           /* Note: can a white seg get greyed as well?  At this point */
           /* we still assume it may.  (This assumption runs out in */
           /* PoolTrivGrey). */
@@ -1703,7 +1917,11 @@ void TraceAdvance(Trace trace)
 
     if (traceFindGrey(&seg, &rank, arena, trace->ti)) {
       Res res;
-      res = traceScanSeg(TraceSetSingle(trace), rank, arena, seg);
+      Size budget = (Size)trace->quantumWork;
+      /* <design/scan/#suspend.budget> */
+      if (budget < TraceScanBudgetMIN)
+        budget = TraceScanBudgetMIN;
+      res = traceScanSeg(TraceSetSingle(trace), rank, arena, seg, budget);
       /* Allocation failures should be handled by emergency mode, and we
        * don't expect any other error in a normal GC trace. */
       AVER(res == ResOK);
@@ -1780,9 +1998,38 @@ failCondemn:
 }
 
 
+/* TraceFirstBusy -- find a busy trace
+ *
+ * If any trace is busy, update *traceReturn to point to the busy trace
+ * with the lowest TraceId and return TRUE. Otherwise return FALSE.
+ *
+ * The pollers use this to choose the trace that gets the next quantum
+ * of work, rather than assuming that the running trace has TraceId 0.
+ * While TraceLIMIT is 1 that is the only trace, so this is preparation
+ * for more traces, not a change in behaviour.  See
+ * <design/trace/#instance.limit.poll>.
+ */
+
+Bool TraceFirstBusy(Trace *traceReturn, Arena arena)
+{
+  TraceId ti;
+  Trace trace;
+
+  AVER(traceReturn != NULL);
+  AVERT(Arena, arena);
+
+  TRACE_SET_ITER(ti, trace, arena->busyTraces, arena) {
+    *traceReturn = trace;
+    return TRUE;
+  } TRACE_SET_ITER_END(ti, trace, arena->busyTraces, arena);
+
+  return FALSE;
+}
+
+
 /* TracePoll -- Check if there's any tracing work to be done
  *
- * Consider starting a trace if none is running; advance the running
+ * Consider starting a trace if none is running; advance a running
  * trace (if any) by one quantum.
  *
  * The collectWorldReturn and collectWorldAllowed arguments are as for
@@ -1802,16 +2049,14 @@ Bool TracePoll(Work *workReturn, Bool *collectWorldReturn, Globals globals,
   AVERT(Globals, globals);
   arena = GlobalsArena(globals);
 
-  if (arena->busyTraces != TraceSetEMPTY) {
-    trace = ArenaTrace(arena, (TraceId)0);
-  } else {
+  if (!TraceFirstBusy(&trace, arena)) {
     /* No traces are running: consider starting one now. */
     if (!PolicyStartTrace(&trace, collectWorldReturn, arena,
                           collectWorldAllowed))
       return FALSE;
   }
 
-  AVER(arena->busyTraces == TraceSetSingle(trace));
+  AVER(TraceSetIsMember(arena->busyTraces, trace));
   oldWork = traceWork(trace);
   endWork = oldWork + trace->quantumWork;
   do {
@@ -1856,6 +2101,7 @@ Res TraceDescribe(Trace trace, mps_lib_FILE *stream, Count depth)
                "  state $S\n", (WriteFS)state,
                "  band $U\n", (WriteFU)trace->band,
                "  white   $B\n", (WriteFB)trace->white,
+               "  whiteGens $B\n", (WriteFB)trace->whiteGens,
                "  mayMove $B\n", (WriteFB)trace->mayMove,
                "  chain $P\n", (WriteFP)trace->chain,
                "  condemned $U\n", (WriteFU)trace->condemned,
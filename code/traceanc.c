@@ -118,6 +118,8 @@ static MessageClassStruct TraceStartMessageClassStruct = {
   MessageNoGCLiveSize,           /* GCLiveSize */
   MessageNoGCCondemnedSize,      /* GCCondemnedSize */
   MessageNoGCNotCondemnedSize,   /* GCNotCondemnedSize */
+  MessageNoGCCopiedSize,         /* GCCopiedSize */
+  MessageNoGCMarkedSize,         /* GCMarkedSize */
   TraceStartMessageWhy,          /* GCStartWhy */
   MessageClassSig                /* <design/message/#class.sig.double> */
 };
@@ -281,6 +283,8 @@ typedef struct TraceMessageStruct  {
   Size liveSize;
   Size condemnedSize;
   Size notCondemnedSize;
+  Size copiedSize;
+  Size markedSize;
   MessageStruct messageStruct;
 } TraceMessageStruct;
 
@@ -349,6 +353,28 @@ static Size TraceMessageNotCondemnedSize(Message message)
   return tMessage->notCondemnedSize;
 }
 
+static Size TraceMessageCopiedSize(Message message)
+{
+  TraceMessage tMessage;
+
+  AVERT(Message, message);
+  tMessage = MessageTraceMessage(message);
+  AVERT(TraceMessage, tMessage);
+
+  return tMessage->copiedSize;
+}
+
+static Size TraceMessageMarkedSize(Message message)
+{
+  TraceMessage tMessage;
+
+  AVERT(Message, message);
+  tMessage = MessageTraceMessage(message);
+  AVERT(TraceMessage, tMessage);
+
+  return tMessage->markedSize;
+}
+
 static MessageClassStruct TraceMessageClassStruct = {
   MessageClassSig,               /* sig */
   "TraceGC",                     /* name */
@@ -358,6 +384,8 @@ static MessageClassStruct TraceMessageClassStruct = {
   TraceMessageLiveSize,          /* GCLiveSize */
   TraceMessageCondemnedSize,     /* GCCondemnedSize */
   TraceMessageNotCondemnedSize,  /* GCNotCondemnedSize */
+  TraceMessageCopiedSize,        /* GCCopiedSize */
+  TraceMessageMarkedSize,        /* GCMarkedSize */
   MessageNoGCStartWhy,           /* GCStartWhy */
   MessageClassSig                /* <design/message/#class.sig.double> */
 };
@@ -371,6 +399,8 @@ static void traceMessageInit(Arena arena, TraceMessage tMessage)
   tMessage->liveSize = (Size)0;
   tMessage->condemnedSize = (Size)0;
   tMessage->notCondemnedSize = (Size)0;
+  tMessage->copiedSize = (Size)0;
+  tMessage->markedSize = (Size)0;
 
   tMessage->sig = TraceMessageSig;
   AVERT(TraceMessage, tMessage);
@@ -380,7 +410,9 @@ static void traceMessageInit(Arena arena, TraceMessage tMessage)
  *
  * .message.data: The trace end message contains the live size
  * (forwardedSize + preservedInPlaceSize), the condemned size
- * (condemned), and the not-condemned size (notCondemned).
+ * (condemned), the not-condemned size (notCondemned), and the two
+ * parts of the live size: the copied size (forwardedSize) and the
+ * marked size (preservedInPlaceSize).
  */
 
 void TracePostMessage(Trace trace)
@@ -405,6 +437,8 @@ void TracePostMessage(Trace trace)
     tMessage->liveSize = trace->forwardedSize + trace->preservedInPlaceSize;
     tMessage->condemnedSize = trace->condemned;
     tMessage->notCondemnedSize = trace->notCondemned;
+    tMessage->copiedSize = trace->forwardedSize;
+    tMessage->markedSize = trace->preservedInPlaceSize;
 
     arena->tMessage[ti] = NULL;
     MessagePost(arena, TraceMessageMessage(tMessage));
@@ -773,6 +807,7 @@ void ArenaExposeRemember(Globals globals, Bool remember)
   ArenaPark(globals);
 
   arena = GlobalsArena(globals);
+  TraceSoftBarrierFlush(arena);
   if(SegFirst(&seg, arena)) {
     Addr base;
 
@@ -318,23 +318,49 @@ TreeKey ChunkKey(Tree tree)
 }
 
 
-/* ChunkOfAddr -- return the chunk which encloses an address */
+/* ChunkOfAddr -- return the chunk which encloses an address
+ *
+ * This is on the critical path: it is called by _mps_fix2 for every
+ * reference that passes the zone test.  See <design/critical-path/>.
+ *
+ * .cache: Before searching the chunk tree, consult the arena's
+ * direct-mapped chunk cache, indexed by the address bits just above
+ * ChunkCacheSHIFT.  An entry is only trusted if the chunk it points to
+ * contains the address, so entries never need to be invalidated when
+ * chunks are inserted, and a collision between two chunks costs no
+ * more than a tree search.  ArenaChunkRemoved removes a chunk from the
+ * cache before the chunk is finished.
+ */
+
+#define chunkCacheIndex(addr) \
+  ((Index)(((Word)(addr) >> ChunkCacheSHIFT) & (ChunkCacheLENGTH - 1)))
 
 Bool ChunkOfAddr(Chunk *chunkReturn, Arena arena, Addr addr)
 {
   Tree tree;
+  Chunk chunk;
+  Index i;
 
   AVER_CRITICAL(chunkReturn != NULL);
   AVERT_CRITICAL(Arena, arena);
   /* addr is arbitrary */
 
+  i = chunkCacheIndex(addr);
+  chunk = arena->chunkCache[i];
+  if (chunk != NULL && chunk->base <= addr && addr < chunk->limit) {
+    AVERT_CRITICAL(Chunk, chunk);
+    *chunkReturn = chunk;
+    return TRUE;
+  }
+
   if (TreeFind(&tree, ArenaChunkTree(arena), TreeKeyOfAddrVar(addr),
                ChunkCompare)
       == CompareEQUAL)
   {
-    Chunk chunk = ChunkOfTree(tree);
+    chunk = ChunkOfTree(tree);
     AVER_CRITICAL(chunk->base <= addr);
     AVER_CRITICAL(addr < chunk->limit);
+    arena->chunkCache[i] = chunk;
     *chunkReturn = chunk;
     return TRUE;
   }
@@ -170,8 +170,6 @@ extern Res ChunkInit(Chunk chunk, Arena arena, Addr base, Addr limit,
 extern void ChunkFinish(Chunk chunk);
 extern Compare ChunkCompare(Tree tree, TreeKey key);
 extern TreeKey ChunkKey(Tree tree);
-extern Bool ChunkCacheEntryCheck(ChunkCacheEntry entry);
-extern void ChunkCacheEntryInit(ChunkCacheEntry entry);
 extern Bool ChunkOfAddr(Chunk *chunkReturn, Arena arena, Addr addr);
 extern Res ChunkNodeDescribe(Tree node, mps_lib_FILE *stream);
 
@@ -177,6 +177,15 @@ Res VMMap(VM vm, Addr base, Addr limit)
 
   size = AddrOffset(base, limit);
 
+#if defined(PROT_UFFD)
+  /* Keep the reservation's mapping, which may be registered with the
+     userfaultfd.  See <code/protuffd.c#register>. */
+  if (mprotect((void *)base, (size_t)size,
+               PROT_READ | PROT_WRITE | PROT_EXEC) != 0) {
+    AVER(errno == ENOMEM); /* .assume.mmap.err */
+    return ResMEMORY;
+  }
+#else
   if(mmap((void *)base, (size_t)size,
           PROT_READ | PROT_WRITE | PROT_EXEC,
           MAP_ANON | MAP_PRIVATE | MAP_FIXED,
@@ -185,6 +194,7 @@ Res VMMap(VM vm, Addr base, Addr limit)
     AVER(errno == ENOMEM); /* .assume.mmap.err */
     return ResMEMORY;
   }
+#endif
 
   vm->mapped += size;
   AVER(VMMapped(vm) <= VMReserved(vm));
@@ -199,7 +209,11 @@ Res VMMap(VM vm, Addr base, Addr limit)
 void VMUnmap(VM vm, Addr base, Addr limit)
 {
   Size size;
+#if defined(PROT_UFFD)
+  int r;
+#else
   void *addr;
+#endif
 
   AVERT(VM, vm);
   AVER(base < limit);
@@ -211,11 +225,19 @@ void VMUnmap(VM vm, Addr base, Addr limit)
   size = AddrOffset(base, limit);
   AVER(size <= VMMapped(vm));
 
+#if defined(PROT_UFFD)
+  /* Discard the pages but keep the mapping, as in VMMap. */
+  r = madvise((void *)base, (size_t)size, MADV_DONTNEED);
+  AVER(r == 0);
+  r = mprotect((void *)base, (size_t)size, PROT_NONE);
+  AVER(r == 0);
+#else
   /* see <design/vmo1/#fun.unmap.offset> */
   addr = mmap((void *)base, (size_t)size,
               PROT_NONE, MAP_ANON | MAP_PRIVATE | MAP_FIXED,
               -1, 0);
   AVER(addr == (void *)base);
+#endif
 
   vm->mapped -= size;
 
@@ -0,0 +1,375 @@
+/* wbtest.c: SOFTWARE WRITE BARRIER TEST
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * Checks the software write barrier (<design/write-barrier/#soft>).
+ * A container object in an AMS pool, which is never condemned, is
+ * scanned so that its segment has a tight summary. Then references to
+ * new objects in an AMC nursery are stored into it, each followed by
+ * a call to mps_write_barrier, and the nursery is collected. The
+ * objects must survive, and the container must have been fixed to
+ * refer to their new locations.
+ *
+ * In checking varieties, the test also stores a reference without
+ * calling mps_write_barrier, and checks that the next scan of the
+ * container reports it (<design/write-barrier/#soft.check>).
+ *
+ * Finally it checks that an arena with the software barrier can't
+ * have a second registered thread, or a background collector
+ * (<design/write-barrier/#soft.threads>).
+ */
+
+#include "fmtdy.h"
+#include "fmtdytst.h"
+#include "testlib.h"
+#include "testthr.h"
+#include "mpm.h"
+#include "mpslib.h"
+#include "mpscamc.h"
+#include "mpscams.h"
+#include "mpsavm.h"
+#include "mps.h"
+
+#include <stdio.h> /* printf */
+#include <string.h> /* strstr */
+
+
+#define testArenaSIZE   ((size_t)64 << 20)
+#define slotCOUNT       64
+#define objectSLOTS     4
+#define garbageSLOTS    30
+#define nurserySIZE     64      /* kilobytes */
+
+static mps_gen_param_s nurseryChain[1] = { { nurserySIZE, 0.9 } };
+static mps_gen_param_s oldChain[1] = { { 1024 * 1024, 0.5 } };
+
+static mps_addr_t roots[2];     /* container, and an extra object */
+static mps_addr_t moved[slotCOUNT]; /* addresses before collection */
+
+
+/* collectNursery -- fill the nursery and collect it
+ *
+ * The arena is parked, so allocation doesn't start a collection.
+ * mps_arena_step with no time to spare never collects the world, so
+ * it starts a collection of the chain that is over capacity: the
+ * nursery, and not the container's chain.
+ */
+
+static void collectNursery(mps_arena_t arena, mps_ap_t ap)
+{
+  mps_word_t collections = mps_collections(arena);
+  size_t size = 0;
+
+  while (size < 2 * nurserySIZE * 1024) {
+    mps_word_t v;
+    die(make_dylan_vector(&v, ap, garbageSLOTS), "make garbage");
+    size += (garbageSLOTS + 2) * sizeof(mps_word_t);
+  }
+  (void)mps_arena_step(arena, 0.0, 0.0);
+  mps_arena_park(arena);
+  Insist(mps_collections(arena) != collections);
+}
+
+
+/* containerSummary -- return the summary of the container's segment
+ *
+ * The barrier only records stores, so apply them first, as the
+ * collector does (<design/write-barrier/#soft.buffer>).
+ */
+
+static RefSet containerSummary(mps_arena_t mps_arena)
+{
+  Arena arena = (Arena)mps_arena;
+  Seg seg;
+  TraceSoftBarrierFlush(arena);
+  Insist(SegOfAddr(&seg, arena, (Addr)roots[0]));
+  return SegSummary(seg);
+}
+
+
+/* makeObject -- make a nursery object, marked with a number */
+
+static mps_addr_t makeObject(mps_ap_t ap, size_t i)
+{
+  mps_word_t v;
+  die(make_dylan_vector(&v, ap, objectSLOTS), "make object");
+  DYLAN_VECTOR_SLOT(v, 0) = DYLAN_INT(i);
+  return (mps_addr_t)v;
+}
+
+
+/* checkObject -- check that a nursery object survived */
+
+static void checkObject(mps_addr_t addr, size_t i)
+{
+  Insist(dylan_check(addr));
+  Insist(DYLAN_VECTOR_SLOT(addr, 0) == DYLAN_INT(i));
+}
+
+
+/* test_barrier -- store references through the barrier and collect */
+
+static void test_barrier(mps_arena_t arena, mps_ap_t ap)
+{
+  mps_word_t *container = roots[0];
+  size_t i;
+
+  Insist(containerSummary(arena) != RefSetUNIV);
+
+  for (i = 0; i < slotCOUNT; ++i) {
+    mps_addr_t obj = makeObject(ap, i);
+    DYLAN_VECTOR_SLOT(container, i) = (mps_word_t)obj;
+    mps_write_barrier(arena, &DYLAN_VECTOR_SLOT(container, i));
+    moved[i] = obj;
+  }
+  /* The stores are recorded, and the collection must apply them. */
+  Insist(((Arena)arena)->wbCount > 0);
+
+  collectNursery(arena, ap);
+
+  for (i = 0; i < slotCOUNT; ++i) {
+    mps_addr_t obj = (mps_addr_t)DYLAN_VECTOR_SLOT(container, i);
+    Insist(obj != moved[i]);
+    checkObject(obj, i);
+  }
+  Insist(containerSummary(arena) != RefSetUNIV);
+  printf("Stored %d references through the barrier.\n", slotCOUNT);
+}
+
+
+#if defined(AVER_AND_CHECK_ALL)
+
+/* test_missing -- store a reference without the barrier
+ *
+ * The container refers to itself, so that its summary meets the white
+ * set of a full collection, and the collection scans it.  The object
+ * is also referenced from a root, so the collection is correct
+ * whatever the checks find.
+ */
+
+static mps_lib_assert_fail_t defaultHandler;
+static unsigned summaryFailures;
+
+static void summaryHandler(const char *file, unsigned line,
+                           const char *condition)
+{
+  if (strstr(condition, "SegSummary") != NULL)
+    ++summaryFailures;
+  else
+    defaultHandler(file, line, condition);
+}
+
+static void test_missing(mps_arena_t arena, mps_ap_t ap)
+{
+  mps_word_t *container = roots[0];
+  RefSet summary;
+  mps_addr_t obj;
+  size_t i;
+
+  for (i = 0; i < slotCOUNT; ++i)
+    DYLAN_VECTOR_SLOT(container, i) = DYLAN_INT(i);
+  DYLAN_VECTOR_SLOT(container, 1) = (mps_word_t)container;
+  mps_write_barrier(arena, &DYLAN_VECTOR_SLOT(container, 1));
+  collectNursery(arena, ap);
+  summary = containerSummary(arena);
+  Insist(summary != RefSetUNIV);
+
+  /* Find an object in a zone that the summary leaves out. */
+  i = 0;
+  do {
+    obj = makeObject(ap, 0);
+    Insist(++i < 100000);
+  } while (RefSetIsMember((Arena)arena, summary, obj));
+
+  roots[1] = obj;
+  DYLAN_VECTOR_SLOT(container, 0) = (mps_word_t)obj;
+
+  summaryFailures = 0;
+  defaultHandler = mps_lib_assert_fail_install(summaryHandler);
+  die(mps_arena_collect(arena), "mps_arena_collect");
+  (void)mps_lib_assert_fail_install(defaultHandler);
+
+  Insist(summaryFailures > 0);
+  Insist(DYLAN_VECTOR_SLOT(container, 0) == (mps_word_t)roots[1]);
+  checkObject(roots[1], 0);
+  roots[1] = NULL;
+  printf("Missing barrier detected.\n");
+}
+
+#endif /* AVER_AND_CHECK_ALL */
+
+
+static void test(mps_arena_t arena)
+{
+  mps_fmt_t format;
+  mps_chain_t nursery, old;
+  mps_pool_t amc, ams;
+  mps_ap_t ap, container_ap;
+  mps_root_t root;
+  mps_word_t container;
+
+  die(dylan_fmt(&format, arena), "fmt_create");
+  die(mps_chain_create(&nursery, arena, 1, nurseryChain), "chain_create");
+  die(mps_chain_create(&old, arena, 1, oldChain), "chain_create");
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, nursery);
+    die(mps_pool_create_k(&amc, arena, mps_class_amc(), args),
+        "pool_create(amc)");
+  } MPS_ARGS_END(args);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, old);
+    die(mps_pool_create_k(&ams, arena, mps_class_ams(), args),
+        "pool_create(ams)");
+  } MPS_ARGS_END(args);
+
+  die(mps_root_create_table(&root, arena, mps_rank_exact(), (mps_rm_t)0,
+                            roots, NELEMS(roots)),
+      "root_create_table");
+  die(mps_ap_create(&ap, amc, mps_rank_exact()), "ap_create(amc)");
+
+  /* Destroy the container's allocation point, so that its segment is
+     not buffered, and scans of it are total. */
+  die(mps_ap_create(&container_ap, ams, mps_rank_exact()),
+      "ap_create(ams)");
+  die(make_dylan_vector(&container, container_ap, slotCOUNT),
+      "make container");
+  mps_ap_destroy(container_ap);
+  roots[0] = (mps_addr_t)container;
+
+  mps_arena_park(arena);
+  collectNursery(arena, ap);
+
+  test_barrier(arena, ap);
+#if defined(AVER_AND_CHECK_ALL)
+  test_missing(arena, ap);
+#endif
+
+  mps_ap_destroy(ap);
+  mps_root_destroy(root);
+  mps_pool_destroy(ams);
+  mps_pool_destroy(amc);
+  mps_chain_destroy(old);
+  mps_chain_destroy(nursery);
+  mps_fmt_destroy(format);
+}
+
+
+/* test_threads -- the barrier allows only one registered thread */
+
+static mps_res_t otherRes;
+
+static void *registerThread(void *arg)
+{
+  mps_arena_t arena = arg;
+  mps_thr_t thread;
+
+  otherRes = mps_thread_reg(&thread, arena);
+  if (otherRes == MPS_RES_OK)
+    mps_thread_dereg(thread);
+  return NULL;
+}
+
+static void test_threads(mps_arena_t arena)
+{
+  mps_thr_t thread;
+  testthr_t other;
+
+  die(mps_thread_reg(&thread, arena), "thread_reg");
+  testthr_create(&other, registerThread, arena);
+  testthr_join(&other, NULL);
+  Insist(otherRes == MPS_RES_PARAM);
+  mps_thread_dereg(thread);
+
+  testthr_create(&other, registerThread, arena);
+  testthr_join(&other, NULL);
+  Insist(otherRes == MPS_RES_OK);
+  printf("Second thread refused.\n");
+}
+
+
+/* test_background -- the barrier is incompatible with a collector thread */
+
+static void test_background(void)
+{
+  mps_arena_t arena;
+  mps_res_t res;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SOFT_BARRIER, TRUE);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_BACKGROUND_COLLECTOR, TRUE);
+    res = mps_arena_create_k(&arena, mps_arena_class_vm(), args);
+  } MPS_ARGS_END(args);
+  Insist(res == MPS_RES_PARAM);
+}
+
+
+int main(int argc, char *argv[])
+{
+  mps_arena_t arena;
+
+  testlib_init(argc, argv);
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, testArenaSIZE);
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SOFT_BARRIER, TRUE);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+
+  test(arena);
+  test_threads(arena);
+
+  mps_arena_destroy(arena);
+
+  test_background();
+
+  printf("%s: Conclusion: Failed to find any defects.\n", argv[0]);
+  return 0;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
@@ -0,0 +1,390 @@
+/* weakbench.c -- AWL weak table benchmark
+ *
+ * $Id$
+ * Copyright (c) 2026 Ravenbrook Limited.  See end of file for license.
+ *
+ * This benchmark keeps weak hash tables in an AWL pool, with keys in
+ * an LO pool, and runs lookup loops over the tables while allocating
+ * enough to keep the collector busy. Each lookup loop reads a run of
+ * slots in one table, and so hits the read barrier repeatedly if the
+ * table's segment is grey. The tests compare the ways AWL can handle
+ * those hits (see <design/poolawl/#sa>):
+ *
+ *   single  emulate each access singly, up to the default limit
+ *   scan    scan the whole segment on the first access
+ *   hint    call mps_awl_scan_segment_hint before each lookup loop
+ */
+
+#include "mps.c"
+#include "testlib.h"
+#include "fmtvec.h"
+#include "mpscawl.h"
+#include "mpsclo.h"
+
+#ifdef MPS_OS_W3
+#include "getopt.h"
+#else
+#include <getopt.h>
+#endif
+
+#include <stdio.h> /* fprintf, printf, stderr */
+#include <stdlib.h> /* calloc, free, EXIT_FAILURE, EXIT_SUCCESS, strtoul */
+#include <string.h> /* strcmp */
+#include <time.h> /* clock, CLOCKS_PER_SEC */
+
+static rnd_state_t seed = 0;      /* random number seed */
+static size_t ntables = 64;       /* number of weak tables */
+static size_t nslots = 1024;      /* slots in each table */
+static double pstrong = 0.5;      /* probability that a key is kept alive */
+static unsigned long nloops = 100000; /* lookup loops */
+static size_t nprobe = 16;        /* slots read in each lookup loop */
+static size_t garbage = 64;       /* bytes allocated in each lookup loop */
+static size_t arena_size = 256ul * 1024 * 1024; /* arena size */
+
+static mps_gen_param_s gen[] = {
+  { 1024, 0.9 }
+};
+
+
+/* Objects
+ *
+ * Keys are leaves in the vector format (see fmtvec.c). A weak table
+ * is a vector of references whose first slot is its dependent object
+ * (always NULL here) and whose other slots contain keys or NULL.
+ */
+
+#define TABLE_SLOTS         2   /* index of first slot in a table */
+
+static mps_addr_t find_dependent(mps_addr_t addr)
+{
+  mps_word_t *p = addr;
+  return (mps_addr_t)p[1];
+}
+
+
+static mps_arena_t arena;
+static mps_fmt_t format;
+static mps_chain_t chain;
+static mps_pool_t leafpool, weakpool;
+static mps_ap_t leafap, weakap;
+static mps_word_t **tables;       /* the weak tables */
+static mps_word_t **strong;       /* keys kept alive */
+
+
+static mps_word_t *alloc(mps_ap_t ap, size_t words, unsigned type)
+{
+  mps_word_t *p;
+  die(make_vec(&p, ap, words, type), "make_vec");
+  return p;
+}
+
+
+/* fill -- make the tables and fill them with keys */
+
+static void fill(void)
+{
+  size_t i, j;
+  for (i = 0; i < ntables; ++i) {
+    tables[i] = alloc(weakap, TABLE_SLOTS + nslots, VEC_REFS);
+    for (j = 0; j < nslots; ++j) {
+      mps_word_t *key = alloc(leafap, 2, VEC_LEAF);
+      if (rnd_double() < pstrong)
+        strong[i * nslots + j] = key;
+      tables[i][TABLE_SLOTS + j] = (mps_word_t)key;
+    }
+  }
+}
+
+
+/* lookups -- run lookup loops over random tables
+ *
+ * Returns the number of live keys found.
+ */
+
+static unsigned long lookups(mps_bool_t hint)
+{
+  unsigned long loop, found = 0;
+  for (loop = 0; loop < nloops; ++loop) {
+    mps_word_t *table = tables[rnd() % ntables];
+    size_t j, start = rnd() % nslots;
+    if (hint)
+      mps_awl_scan_segment_hint(weakpool, table);
+    for (j = 0; j < nprobe; ++j)
+      if (table[TABLE_SLOTS + (start + j) % nslots] != 0)
+        ++found;
+    if (garbage > 0)
+      (void)alloc(leafap, garbage / sizeof(mps_word_t) + 1, VEC_LEAF);
+  }
+  return found;
+}
+
+
+/* bench -- run one test */
+
+static void bench(const char *name, mps_bool_t hint, mps_bool_t scanAll)
+{
+  mps_thr_t thread;
+  mps_root_t stackroot, tableroot, strongroot;
+  clock_t begin, end;
+  unsigned long found, collections = 0;
+  mps_message_t message;
+  void *marker;
+
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_ARENA_SIZE, arena_size);
+    die(mps_arena_create_k(&arena, mps_arena_class_vm(), args),
+        "arena_create");
+  } MPS_ARGS_END(args);
+  die(mps_thread_reg(&thread, arena), "thread_reg");
+  die(mps_root_create_thread(&stackroot, arena, thread, &marker),
+      "root_create_thread");
+  die(mps_root_create_table(&tableroot, arena, mps_rank_exact(), 0,
+                            (mps_addr_t *)tables, ntables),
+      "root_create_table");
+  die(mps_root_create_table(&strongroot, arena, mps_rank_exact(), 0,
+                            (mps_addr_t *)strong, ntables * nslots),
+      "root_create_table");
+  die(vec_fmt(&format, arena), "vec_fmt");
+  die(mps_chain_create(&chain, arena, NELEMS(gen), gen), "chain_create");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    die(mps_pool_create_k(&leafpool, arena, mps_class_lo(), args),
+        "pool_create(lo)");
+  } MPS_ARGS_END(args);
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_FORMAT, format);
+    MPS_ARGS_ADD(args, MPS_KEY_CHAIN, chain);
+    MPS_ARGS_ADD(args, MPS_KEY_AWL_FIND_DEPENDENT, find_dependent);
+    if (scanAll)
+      MPS_ARGS_ADD(args, MPS_KEY_AWL_SINGLE_ACCESS_LIMIT, 0);
+    die(mps_pool_create_k(&weakpool, arena, mps_class_awl(), args),
+        "pool_create(awl)");
+  } MPS_ARGS_END(args);
+  die(mps_ap_create_k(&leafap, leafpool, mps_args_none), "ap_create_k");
+  MPS_ARGS_BEGIN(args) {
+    MPS_ARGS_ADD(args, MPS_KEY_RANK, mps_rank_weak());
+    die(mps_ap_create_k(&weakap, weakpool, args), "ap_create_k");
+  } MPS_ARGS_END(args);
+
+  fill();
+  mps_message_type_enable(arena, mps_message_type_gc());
+  begin = clock();
+  found = lookups(hint);
+  end = clock();
+
+  mps_arena_park(arena);
+  while (mps_message_get(&message, arena, mps_message_type_gc())) {
+    ++collections;
+    mps_message_discard(arena, message);
+  }
+  printf("%s: %g seconds, %lu collections, %lu keys found\n", name,
+         (double)(end - begin) / CLOCKS_PER_SEC, collections, found);
+
+  mps_ap_destroy(weakap);
+  mps_ap_destroy(leafap);
+  mps_pool_destroy(weakpool);
+  mps_pool_destroy(leafpool);
+  mps_chain_destroy(chain);
+  mps_fmt_destroy(format);
+  mps_root_destroy(strongroot);
+  mps_root_destroy(tableroot);
+  mps_root_destroy(stackroot);
+  mps_thread_dereg(thread);
+  mps_arena_destroy(arena);
+}
+
+
+/* Command-line options definitions.  See getopt_long(3). */
+
+static struct option longopts[] = {
+  {"help",             no_argument,       NULL, 'h'},
+  {"ntables",          required_argument, NULL, 't'},
+  {"nslots",           required_argument, NULL, 's'},
+  {"pstrong",          required_argument, NULL, 'p'},
+  {"nloops",           required_argument, NULL, 'n'},
+  {"nprobe",           required_argument, NULL, 'r'},
+  {"garbage",          required_argument, NULL, 'g'},
+  {"arena-size",       required_argument, NULL, 'm'},
+  {"seed",             required_argument, NULL, 'x'},
+  {NULL,               0,                 NULL, 0  }
+};
+
+
+static struct {
+  const char *name;
+  mps_bool_t hint;
+  mps_bool_t scanAll;
+} tests[] = {
+  {"single", FALSE, FALSE},
+  {"scan",   FALSE, TRUE},
+  {"hint",   TRUE,  FALSE},
+};
+
+
+/* Command-line driver */
+
+int main(int argc, char *argv[])
+{
+  int ch;
+  unsigned i;
+  mps_bool_t seed_specified = FALSE;
+
+  seed = rnd_seed();
+
+  while ((ch = getopt_long(argc, argv, "ht:s:p:n:r:g:m:x:",
+                           longopts, NULL)) != -1)
+    switch (ch) {
+    case 't':
+      ntables = (size_t)strtoul(optarg, NULL, 10);
+      break;
+    case 's':
+      nslots = (size_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'p':
+      pstrong = strtod(optarg, NULL);
+      break;
+    case 'n':
+      nloops = strtoul(optarg, NULL, 10);
+      break;
+    case 'r':
+      nprobe = (size_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'g':
+      garbage = (size_t)strtoul(optarg, NULL, 10);
+      break;
+    case 'm': {
+        char *p;
+        arena_size = (unsigned)strtoul(optarg, &p, 10);
+        switch(toupper(*p)) {
+        case 'G': arena_size <<= 30; break;
+        case 'M': arena_size <<= 20; break;
+        case 'K': arena_size <<= 10; break;
+        case '\0': break;
+        default:
+          fprintf(stderr, "Bad arena size %s\n", optarg);
+          return EXIT_FAILURE;
+        }
+      }
+      break;
+    case 'x':
+      seed = strtoul(optarg, NULL, 10);
+      seed_specified = TRUE;
+      break;
+    default:
+      fprintf(stderr,
+              "Usage: %s [option...] [test...]\n"
+              "Options:\n"
+              "  -m n, --arena-size=n[KMG]?\n"
+              "    Initial size of arena (default %lu).\n"
+              "  -t n, --ntables=n\n"
+              "    Number of weak tables (default %lu).\n"
+              "  -s n, --nslots=n\n"
+              "    Number of slots in each table (default %lu).\n"
+              "  -p p, --pstrong=p\n"
+              "    Probability that a key is kept alive (default %g).\n",
+              argv[0],
+              (unsigned long)arena_size,
+              (unsigned long)ntables,
+              (unsigned long)nslots,
+              pstrong);
+      fprintf(stderr,
+              "  -n n, --nloops=n\n"
+              "    Number of lookup loops (default %lu).\n"
+              "  -r n, --nprobe=n\n"
+              "    Slots read in each lookup loop (default %lu).\n"
+              "  -g n, --garbage=n\n"
+              "    Bytes allocated in each lookup loop (default %lu).\n"
+              "  -x n, --seed=n\n"
+              "    Random number seed (default from entropy).\n"
+              "Tests:\n"
+              "  single  emulate barrier hits singly\n"
+              "  scan    scan the segment on the first barrier hit\n"
+              "  hint    call mps_awl_scan_segment_hint before lookups\n",
+              nloops,
+              (unsigned long)nprobe,
+              (unsigned long)garbage);
+      return EXIT_FAILURE;
+    }
+  argc -= optind;
+  argv += optind;
+
+  if (ntables == 0 || nslots == 0) {
+    fprintf(stderr, "Bad arguments; try --help\n");
+    return EXIT_FAILURE;
+  }
+
+  if (!seed_specified) {
+    printf("seed: %lu\n", seed);
+    (void)fflush(stdout);
+  }
+
+  tables = calloc(ntables, sizeof tables[0]);
+  strong = calloc(ntables * nslots, sizeof strong[0]);
+  if (tables == NULL || strong == NULL) {
+    fprintf(stderr, "Couldn't allocate roots\n");
+    return EXIT_FAILURE;
+  }
+
+  while (argc > 0) {
+    for (i = 0; i < NELEMS(tests); ++i)
+      if (strcmp(argv[0], tests[i].name) == 0)
+        goto found;
+    fprintf(stderr, "unknown test \"%s\"\n", argv[0]);
+    return EXIT_FAILURE;
+  found:
+    (void)mps_lib_assert_fail_install(assert_die);
+    rnd_state_set(seed);
+    memset(tables, 0, ntables * sizeof tables[0]);
+    memset(strong, 0, ntables * nslots * sizeof strong[0]);
+    bench(tests[i].name, tests[i].hint, tests[i].scanAll);
+    --argc;
+    ++argv;
+  }
+
+  free(strong);
+  free(tables);
+  return EXIT_SUCCESS;
+}
+
+
+/* C. COPYRIGHT AND LICENSE
+ *
+ * Copyright (C) 2026 Ravenbrook Limited <http://www.ravenbrook.com/>.
+ * All rights reserved.  This is an open source license.  Contact
+ * Ravenbrook for commercial licensing options.
+ *
+ * Redistribution and use in source and binary forms, with or without
+ * modification, are permitted provided that the following conditions are
+ * met:
+ *
+ * 1. Redistributions of source code must retain the above copyright
+ * notice, this list of conditions and the following disclaimer.
+ *
+ * 2. Redistributions in binary form must reproduce the above copyright
+ * notice, this list of conditions and the following disclaimer in the
+ * documentation and/or other materials provided with the distribution.
+ *
+ * 3. Redistributions in any form must be accompanied by information on how
+ * to obtain complete source code for this software and any accompanying
+ * software that uses this software.  The source code must either be
+ * included in the distribution or be available for no more than the cost
+ * of distribution plus a nominal fee, and must be freely redistributable
+ * under reasonable conditions.  For an executable file, complete source
+ * code means the source code for all modules it contains. It does not
+ * include source code for modules or files that typically accompany the
+ * major components of the operating system on which the executable file
+ * runs.
+ *
+ * THIS SOFTWARE IS PROVIDED BY THE COPYRIGHT HOLDERS AND CONTRIBUTORS "AS
+ * IS" AND ANY EXPRESS OR IMPLIED WARRANTIES, INCLUDING, BUT NOT LIMITED
+ * TO, THE IMPLIED WARRANTIES OF MERCHANTABILITY, FITNESS FOR A PARTICULAR
+ * PURPOSE, OR NON-INFRINGEMENT, ARE DISCLAIMED. IN NO EVENT SHALL THE
+ * COPYRIGHT HOLDERS AND CONTRIBUTORS BE LIABLE FOR ANY DIRECT, INDIRECT,
+ * INCIDENTAL, SPECIAL, EXEMPLARY, OR CONSEQUENTIAL DAMAGES (INCLUDING, BUT
+ * NOT LIMITED TO, PROCUREMENT OF SUBSTITUTE GOODS OR SERVICES; LOSS OF
+ * USE, DATA, OR PROFITS; OR BUSINESS INTERRUPTION) HOWEVER CAUSED AND ON
+ * ANY THEORY OF LIABILITY, WHETHER IN CONTRACT, STRICT LIABILITY, OR TORT
+ * (INCLUDING NEGLIGENCE OR OTHERWISE) ARISING IN ANY WAY OUT OF THE USE OF
+ * THIS SOFTWARE, EVEN IF ADVISED OF THE POSSIBILITY OF SUCH DAMAGE.
+ */
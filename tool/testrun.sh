@@ -38,6 +38,7 @@ while [ $# -gt 0 ]; do
                 testall)      EXCLUDE="NW"    ;;
                 testansi)     EXCLUDE="LNTW"  ;;
                 testpollnone) EXCLUDE="LNPTW" ;;
+                testuffd)     EXCLUDE="BNW"   ;;
                 *)
                     echo "Test suite $TEST_SUITE not recognized."
                     exit 1 ;;